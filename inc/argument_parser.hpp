@@ -11,6 +11,9 @@ class
 ArgParser
 {
 public:
+    /// The file path that reads the buffer from stdin, as a stream
+    static constexpr std::string_view STDIN_PATH = "-";
+
     ArgParser(int32_t argc, char **argv);
 
     /// Searches for arg and long arg in the arg list
@@ -25,11 +28,12 @@ public:
     // else it will return a false and an empty option parameter
     auto Option_Arg(std::string &option, sv_pair arg) -> bool;
 
-    /// Searches and returns a file path to be edited
+    /// Searches and returns a file path to be edited, STDIN_PATH is returned as is
     /// @param config config parser class
     /// @param file_path a string object that will be filled with the file path
+    /// @param recover_swap will be set to true when a swap file was found and the user wants it replayed
     /// @returns true on empty file, false on filled file
-    auto Get_File_Path(class ConfigParser *config, std::string &file_path) -> bool;
+    auto Get_File_Path(class ConfigParser *config, std::string &file_path, bool *recover_swap) -> bool;
 
     /// Prints the help message to the specified output stream
     /// @warning this function will exit the program with code EXIT_SUCCESS
@@ -45,6 +49,10 @@ private:
     /// @return will return a string of the last arg on the arg_list
     auto Back() -> std::string;
 
+    /// Checks for a swap file left by a crashed session, and asks whether it should be replayed
+    /// @returns true if the swap file should be replayed
+    static auto Check_Swap_File(const std::string &file_path) -> bool;
+
     auto Find_Option_Short(std::string &option, std::string_view short_arg) -> bool;
     auto Find_Option_Long(std::string &option, std::string_view long_arg) -> bool;
 };
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <type_traits>
+#include <filesystem>
+#include <functional>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <string>
+
+#include "tasks.hpp"
+#include "codec.hpp"
+
+
+/// A small coroutine runtime on top of the task pool.
+//  Tasks start on the main thread, blocking work is awaited on the pool, and the coroutine
+//  resumes on the main thread through the completion event, so it may touch the editor freely.
+namespace Async {
+    template<typename T>
+    class Task;
+
+    /// Resumes whoever awaits the task once it finishes, or frees a spawned task
+    struct Final_Awaiter {
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool
+        { return false; }
+
+        template<typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> std::coroutine_handle<>
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            if (continuation) return continuation;
+
+            if (handle.promise().is_detached) handle.destroy();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct Promise_Base {
+        std::coroutine_handle<> continuation;
+        bool is_detached = false;
+
+        auto initial_suspend() noexcept -> std::suspend_always
+        { return {}; }
+
+        auto final_suspend() noexcept -> Final_Awaiter
+        { return {}; }
+
+        /// Nothing in the editor throws, an exception escaping a task is a bug
+        [[noreturn]]
+        void unhandled_exception() noexcept
+        { std::terminate(); }
+    };
+
+    template<typename T>
+    struct Promise : Promise_Base {
+        std::optional<T> value;
+
+        auto get_return_object() -> Task<T>;
+
+        void return_value(T result)
+        { value = std::move(result); }
+    };
+
+    template<>
+    struct Promise<void> : Promise_Base {
+        auto get_return_object() -> Task<void>;
+
+        void return_void() {}
+    };
+
+    /// A lazily started coroutine returning T, started by awaiting it or by Spawn
+    template<typename T = void>
+    class
+    [[nodiscard]]
+    Task
+    {
+    public:
+        using promise_type = Promise<T>;
+
+        explicit
+        Task(std::coroutine_handle<promise_type> handle) :
+            m_handle(handle) {}
+
+        Task(Task &&other) noexcept :
+            m_handle(std::exchange(other.m_handle, {})) {}
+
+        Task(const Task&) = delete;
+        auto operator=(const Task&) -> Task& = delete;
+        auto operator=(Task&&) -> Task& = delete;
+
+        ~Task()
+        { if (m_handle) m_handle.destroy(); }
+
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool
+        { return false; }
+
+        auto await_suspend(std::coroutine_handle<> awaiting) noexcept -> std::coroutine_handle<>
+        {
+            m_handle.promise().continuation = awaiting;
+            return m_handle;
+        }
+
+        auto await_resume() -> T
+        {
+            if constexpr (!std::is_void_v<T>) return std::move(*m_handle.promise().value);
+        }
+
+        /// Gives up the coroutine, which then has to free itself
+        auto Release() -> std::coroutine_handle<promise_type>
+        { return std::exchange(m_handle, {}); }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    template<typename T>
+    auto
+    Promise<T>::get_return_object() -> Task<T>
+    { return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+    inline auto
+    Promise<void>::get_return_object() -> Task<void>
+    { return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+
+    /// Runs work on the pool, then resumes the awaiting coroutine on the main thread with its result
+    template<typename T>
+    class
+    Pool_Awaiter
+    {
+    public:
+        Pool_Awaiter(std::function<T()> work, Tasks::Priority priority, Tasks::Group *group) :
+            m_work(std::move(work)),
+            m_priority(priority),
+            m_group(group) {}
+
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool
+        { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            /* The awaiter lives in the suspended coroutine's frame, so the job can write the result into it */
+            Tasks::Submit_With_Completion(
+                m_priority,
+                [this] { m_result = m_work(); },
+                [handle] { handle.resume(); },
+                m_group
+            );
+        }
+
+        auto await_resume() -> T
+        { return std::move(*m_result); }
+
+    private:
+        std::function<T()> m_work;
+        Tasks::Priority m_priority;
+        Tasks::Group *m_group;
+        std::optional<T> m_result;
+    };
+
+    /// Awaits work run on the pool, the coroutine resumes on the main thread
+    /// @param group counts the work until it is done, or nullptr
+    template<typename Work>
+    auto
+    On_Pool(
+        Work work,
+        Tasks::Priority priority = Tasks::Interactive,
+        Tasks::Group *group = nullptr
+    ) -> Pool_Awaiter<std::invoke_result_t<Work>>
+    { return { std::move(work), priority, group }; }
+
+    /// Starts a task on the calling thread, which should be the main one. The task frees itself once it finishes.
+    void Spawn(Task<void> task);
+
+    /// Reads a whole file, without blocking the main thread
+    /// @returns the content, or nothing if the file could not be read, the error is logged
+    auto Read_File(std::filesystem::path file_path) -> Pool_Awaiter<std::optional<std::string>>;
+
+    /// Replaces the content of a file with text, without blocking the main thread
+    /// @param format the compression the text is written with, on the pool too
+    /// @param group counts the write until the file is closed, so quitting can wait for it
+    /// @returns true on success or false on failure, the error is logged
+    auto Write_File(
+        std::filesystem::path file_path,
+        std::string text,
+        Codec::Format format = Codec::Plain,
+        Tasks::Group *group = nullptr
+    ) -> Pool_Awaiter<bool>;
+} /* namespace Async */
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "utilities.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+/// Every modification of Editor::Data::file_content should go through this namespace,
+//  so that the undo history stays in sync with the buffer.
+namespace Buffer {
+    /// Replace_All rewrites the span of its edits at once from this many edits
+    static const size_t BATCH_EDITS = 64;
+
+    /// A replacement of the text between start and end (exclusive)
+    struct Edit {
+        Position start;
+        Position end;
+        std::string_view text;
+    };
+
+    /// Inserts text into content, text may contain newlines
+    /// @param content the lines that will be modified
+    /// @param position where the text will be inserted
+    /// @param text the inserted text
+    /// @returns the position right after the last inserted character
+    auto Insert_Text(std::vector<std::string> &content, Position position, std::string_view text) -> Position;
+
+    /// Erases the text between start and end (exclusive) from content
+    /// @param content the lines that will be modified
+    /// @param start the first erased position
+    /// @param end the position after the last erased character, { 0, y + 1 } erases a newline
+    /// @returns the erased text, lines are joined with newlines
+    auto Erase_Text(std::vector<std::string> &content, Position start, Position end) -> std::string;
+
+    /// Returns the text between start and end (exclusive), lines are joined with newlines
+    auto Get_Text(const std::vector<std::string> &content, Position start, Position end) -> std::string;
+
+    /// Inserts text into the editor's content and notifies every buffer observer (swap file, ...),
+    //  without recording it in the undo history
+    /// @returns the position right after the last inserted character
+    auto Apply_Insert(Editor::Data *editor_data, Position position, std::string_view text) -> Position;
+
+    /// Erases text from the editor's content and notifies every buffer observer,
+    //  without recording it in the undo history
+    /// @returns the erased text
+    auto Apply_Erase(Editor::Data *editor_data, Position start, Position end) -> std::string;
+
+    /// Checks if the buffer is a read-only window of the viewer, and logs it if so
+    auto Is_Read_Only(Editor::Data *editor_data) -> bool;
+
+    /// Inserts text into the editor's content and records it in the undo history
+    /// @returns the position right after the last inserted character
+    auto Insert(Editor::Data *editor_data, Position position, std::string_view text) -> Position;
+
+    /// Erases text from the editor's content and records it in the undo history
+    /// @returns the erased text
+    auto Erase(Editor::Data *editor_data, Position start, Position end) -> std::string;
+
+    /// Applies many edits in one pass, as one undo step.
+    //  A few edits are applied from the last to the first, so every position stays valid until it is used,
+    //  past BATCH_EDITS edits that add or remove lines or share a line rebuild the whole span they cover once
+    //  and swap it in with a single erase and insert. Edits each on a line of their own are always applied one by one.
+    /// @param edits sorted by start, an edit overlapping the previous one is clipped to its end
+    /// @returns where the text of each edit ends once every edit is applied
+    auto Replace_All(Editor::Data *editor_data, const std::vector<Edit> &edits) -> std::vector<Position>;
+} /* namespace Buffer */
\ No newline at end of file
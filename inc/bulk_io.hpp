@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+
+
+/// Whole-file reads and writes for large files.
+//  With liburing, files from URING_BYTES up are split into blocks kept in flight on an io_uring, straight into
+//  the caller's buffer registered with the kernel when the memlock limit allows it.
+//  Everything else, and any ring that fails, goes through plain blocking pread / pwrite calls.
+namespace Bulk_IO {
+    /// Files from this size up go through io_uring when it is available
+    static const size_t URING_BYTES = 8 * 1024 * 1024;
+
+    /// Bytes asked for by each request in flight
+    static const uint32_t BLOCK_BYTES = 1024 * 1024;
+
+    /// Requests kept in flight at once
+    static const uint32_t QUEUE_DEPTH = 32;
+
+    /// How the last read or write went, for the debug logs
+    struct Transfer {
+        size_t bytes = 0;
+        double seconds = 0;
+        const char *backend = "none";
+
+        [[nodiscard]]
+        auto Get_Gigabytes_Per_Second() const -> double
+        { return (seconds > 0 ? static_cast<double>(bytes) / 1e9 / seconds : 0); }
+    };
+
+    /// Checks once if the kernel lets this process set up an io_uring
+    [[nodiscard]]
+    auto Has_Uring() -> bool;
+
+    /// Reads a whole file into text
+    /// @returns false if the file could not be opened or read
+    auto Read_File(const std::filesystem::path &file_path, std::string *text) -> bool;
+
+    /// Replaces the content of a file with text, creating it if needed
+    /// @returns false if the file could not be opened or fully written
+    auto Write_File(const std::filesystem::path &file_path, std::string_view text) -> bool;
+
+    [[nodiscard]]
+    auto Get_Last_Read() -> Transfer;
+
+    [[nodiscard]]
+    auto Get_Last_Write() -> Transfer;
+} /* namespace Bulk_IO */
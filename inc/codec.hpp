@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+/// Compressed files, told apart by their magic bytes.
+//  gzip needs zlib and zstd needs libzstd at build time, a format built without them is read as plain text.
+namespace Codec {
+    enum Format : uint8_t {
+        Plain,
+        Gzip,
+        Zstd,
+    };
+
+    /// Decompressed bytes produced per call into the decompressor, so a stream is handed over in pieces
+    static const size_t OUTPUT_BYTES = 256 * 1024;
+
+    /// Bytes needed to tell every format apart
+    static const size_t MAGIC_BYTES = 4;
+
+    /// Finds the format of data from its first bytes
+    [[nodiscard]]
+    auto Detect(std::string_view head) -> Format;
+
+    /// Finds the format of a file from its first bytes, a format that was not built in is logged and read as Plain
+    [[nodiscard]]
+    auto Detect_File(const std::filesystem::path &file_path) -> Format;
+
+    [[nodiscard]]
+    auto Is_Supported(Format format) -> bool;
+
+    [[nodiscard]]
+    auto Get_Name(Format format) -> const char*;
+
+    /// Compresses text into format, in one go
+    /// @param output replaced by the compressed bytes
+    /// @param is_fast trades ratio for speed, for text that is only kept in memory
+    /// @returns false on failure, the error is logged
+    auto Compress(Format format, std::string_view text, std::string *output, bool is_fast = false) -> bool;
+
+    /// Decompresses a stream fed in pieces of any size, its format is detected from its first bytes.
+    //  Concatenated gzip members and zstd frames are decompressed one after the other, like zcat does.
+    class
+    Decoder
+    {
+    public:
+        Decoder();
+        ~Decoder();
+
+        Decoder(const Decoder&) = delete;
+        auto operator=(const Decoder&) -> Decoder& = delete;
+
+        /// Decompresses the next piece of the stream
+        /// @param output the decompressed bytes are appended to it
+        /// @returns false on corrupt input, the error is logged
+        auto Decode(std::string_view input, std::string *output) -> bool;
+
+        /// Ends the stream, a stream shorter than the format's magic bytes is plain text
+        /// @param output the bytes held back for the detection are appended to it
+        /// @returns false if the compressed stream was cut short, the error is logged
+        auto Finish(std::string *output) -> bool;
+
+        [[nodiscard]]
+        auto Get_Format() const -> Format
+        { return m_format; }
+
+    private:
+        struct State;
+
+        std::unique_ptr<State> m_state;
+        Format m_format = Plain;
+        bool m_is_detected = false;
+
+        /// The first bytes, held until there are enough of them to detect the format
+        std::string m_head;
+
+        auto Decode_Detected(std::string_view input, std::string *output) -> bool;
+    };
+
+    /// Decompresses a whole buffer
+    /// @param output replaced by the decompressed bytes
+    /// @returns false on corrupt input, the error is logged
+    auto Decode_All(std::string_view input, std::string *output) -> bool;
+} /* namespace Codec */
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <optional>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "codec.hpp"
+#include "tasks.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+/// Keeps the lines of a large buffer that nobody looked at for a while compressed, within a memory budget.
+//  A background pass measures the buffer and compresses the chunks left untouched for IDLE_MS, the oldest first,
+//  until the buffer fits in the budget, then the main thread empties their lines in the buffer.
+//  Chunks follow their lines when edits move them. An edit only thaws the chunks over the lines it rewrites,
+//  the main thread thaws a chunk the first time it reads one of its lines through Lines,
+//  and the workers decompress a copy through Reader, leaving the chunk frozen.
+namespace Cold {
+    /// Lines are compressed in chunks of about this many lines
+    static const int64_t CHUNK_LINES = 4096;
+
+    /// A chunk is only compressed once it went untouched for this long
+    static const int64_t IDLE_MS = 30 * 1000;
+
+    /// Passes are started at most this often
+    static const int64_t PASS_MS = 1000;
+
+    class
+    Store
+    {
+    public:
+        Store() = default;
+        ~Store();
+
+        Store(const Store&) = delete;
+        auto operator=(const Store&) -> Store& = delete;
+
+        /// Keeps the buffer under budget_bytes, its uncompressed lines and its compressed chunks together
+        void Start(int64_t budget_bytes);
+
+        /// Thaws the chunks over lines first to last, which count as touched
+        /// @returns true if a chunk was thawed
+        auto Thaw(Editor::Data *editor_data, int64_t first, int64_t last) -> bool;
+
+        /// Thaws every chunk, only for what is about to write every line out and quit
+        void Thaw_All(Editor::Data *editor_data);
+
+        /// Lines first to last were rewritten by an edit, which moved every line after them by line_shift.
+        //  Has to be called while the edit holds content_mutex, after it thawed the lines it rewrites.
+        void After_Edit(Editor::Data *editor_data, int64_t first, int64_t last, int64_t line_shift);
+
+        /// Thaws the chunks around the viewport and the cursor, freezes the chunks the pass compressed since the last call
+        //  and starts the next pass once the buffer is idle. Should be called once per frame on the main thread.
+        /// @returns true on "should render", or false on "nothing new"
+        auto Collect(Editor::Data *editor_data) -> bool;
+
+    private:
+        friend class Reader;
+
+        struct Chunk {
+            int64_t start;
+
+            /// The chunk's lines joined by line breaks and compressed, empty while they are in the buffer
+            std::string blob;
+            bool is_frozen = false;
+            std::chrono::steady_clock::time_point touched;
+        };
+
+        /// Lines first up to last compressed by a pass, on the buffer version they were read from
+        struct Compressed_Chunk {
+            int64_t first;
+            int64_t last;
+            uint64_t version;
+            std::string blob;
+        };
+
+        /* Only changed by the main thread while it holds content_mutex exclusively, workers read them under it */
+        std::vector<Chunk> m_chunks;
+        size_t m_frozen_count = 0;
+
+        /* Only touched by the main thread */
+        int64_t m_budget_bytes = 0;
+        Codec::Format m_format = Codec::Plain;
+        int64_t m_frozen_bytes = 0;
+        std::chrono::steady_clock::time_point m_pass_start;
+
+        /// The buffer version the last pass found under the budget, reset once a chunk is thawed
+        std::optional<uint64_t> m_settled_version;
+
+        /* Shared with the pass under m_mutex */
+        std::mutex m_mutex;
+        Tasks::Group m_jobs;
+        bool m_is_running = false;
+        bool m_is_passing = false;
+        std::optional<uint64_t> m_fitting_version;
+        std::vector<Compressed_Chunk> m_finished;
+
+        /// Finds the chunk holding line
+        [[nodiscard]]
+        auto Find_Chunk(int64_t line) const -> size_t;
+
+        /// The line after the last one of chunk index
+        [[nodiscard]]
+        auto Chunk_End(const Editor::Data *editor_data, size_t index) const -> int64_t;
+
+        /// Cuts the chunks into CHUNK_LINES, the first time and after edits made one grow past twice that
+        void Split_Chunks(Editor::Data *editor_data);
+
+        /// Measures the buffer, then compresses the candidate line ranges in order until it fits in the budget
+        /// @param frozen_bytes the size of the chunks compressed already
+        void Run_Pass(
+            Editor::Data *editor_data,
+            uint64_t version,
+            std::vector<std::pair<int64_t, int64_t>> candidates,
+            int64_t frozen_bytes
+        );
+
+        /// Empties the lines of the compressed chunks in the buffer, unless they were touched or edited since the pass
+        void Freeze(Editor::Data *editor_data, std::vector<Compressed_Chunk> compressed);
+
+        /// Puts the decompressed lines of a frozen chunk back into the buffer, content_mutex has to be held exclusively
+        void Install(Editor::Data *editor_data, size_t index, std::vector<std::string> lines);
+
+        void Stop();
+    };
+
+
+    /// The buffer as a worker reads it while it holds content_mutex, frozen lines are decompressed into a copy.
+    //  Only the last chunk read is kept, so a reader is meant for one pass over nearby lines.
+    class
+    Reader
+    {
+    public:
+        explicit Reader(const Editor::Data *editor_data);
+
+        auto at(size_t y) -> const std::string&;
+
+        [[nodiscard]]
+        auto size() const -> size_t;
+
+    private:
+        const Editor::Data *m_editor_data;
+        int64_t m_first = 0;
+        std::vector<std::string> m_lines;
+    };
+
+
+    /// The buffer as the main thread reads it, the chunk of a line is thawed the first time it is read
+    class
+    Lines
+    {
+    public:
+        explicit Lines(Editor::Data *editor_data) : m_editor_data(editor_data) {}
+
+        auto at(size_t y) const -> const std::string&;
+
+        [[nodiscard]]
+        auto size() const -> size_t;
+
+        [[nodiscard]]
+        auto empty() const -> bool
+        { return size() == 0; }
+
+    private:
+        Editor::Data *m_editor_data;
+    };
+} /* namespace Cold */
@@ -18,8 +18,15 @@ namespace Command {
 
         void Clear_Command();
 
+        /// Sets the character the command line starts with, ':' for commands, '/' and '?' for searches
+        void Set_Prompt(char prompt);
+
         auto Get_Command() -> std::string_view;
 
+        [[nodiscard]]
+        auto Get_Prompt() const -> char
+        { return prompt; }
+
         [[nodiscard]]
         auto Render(AppData *app_data) -> bool;
 
@@ -30,9 +37,32 @@ namespace Command {
         Cursor::Renderer *cursor_renderer{};
         std::string command;
         Position cursor{1, 0};
+        char prompt = ':';
+        bool is_opening = false;
     };
 
     namespace Logic {
+        /// A range of lines, both ends included, -1 when the command had no range
+        struct Range {
+            int64_t first = -1;
+            int64_t last = -1;
+        };
+
         auto Handle(std::string &cmd, Editor::Data *editor_data, AppData *app_data) -> bool;
+
+        /// Parses the range in front of a command: %, or one or two addresses separated by a comma.
+        //  An address is a line number, . for the cursor line or $ for the last line, with an optional +n or -n.
+        /// @param cmd the command, the range is removed from its front
+        /// @returns false if the range is outside the buffer
+        auto Parse_Range(Editor::Data *editor_data, std::string_view *cmd, Range *range) -> bool;
+
+        /// Runs :s/pattern/replacement/flags over range, the cursor line by default.
+        //  An empty pattern reuses the search pattern, & in the replacement is the match and \r a line break.
+        //  The only flag is g, which replaces every match of a line instead of the first one.
+        auto Substitute(Editor::Data *editor_data, Range range, std::string_view args) -> bool;
+
+        /// Runs :g/pattern/command over range, the whole buffer by default.
+        //  The command is d or a substitution, run on every matching line at once, or every other line for g! and v.
+        auto Global(Editor::Data *editor_data, Range range, std::string_view args, bool is_inverted) -> bool;
     }
 } /* namespace Command */
\ No newline at end of file
@@ -39,6 +39,10 @@ public:
     /// @returns true on success or false on failure.
     auto Parse_Config(std::filesystem::path &config_path) -> bool;
 
+    /// Returns every key / value pair of a section
+    /// @return will return an empty section when the section is not found
+    auto Get_Section(std::string_view section) -> config_section;
+
     /// Returns the value of a given section and key from the config file as a string
     /// @return will return an empty string_view when key/section are not found
     auto Get_Value(std::string_view section, std::string_view key) -> std::string;
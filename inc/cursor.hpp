@@ -29,6 +29,18 @@ namespace Cursor {
         Data() = default;
     };
 
+    /// Net movement of a burst of motions, applied and clamped once
+    struct Motion {
+        int64_t lines = 0;
+        int64_t columns = 0;
+        int64_t scroll = 0;
+
+        [[nodiscard]]
+        auto
+        Is_Empty() const -> bool
+        { return lines == 0 && columns == 0 && scroll == 0; }
+    };
+
     class
     Renderer
     {
@@ -73,6 +85,29 @@ namespace Cursor {
         static auto Move_Cursor_Down(struct Editor::Data *editor_data, bool is_lctrl_pressed) -> bool;
         static auto Move_Cursor_Up(struct Editor::Data *editor_data, bool is_lctrl_pressed) -> bool;
 
+        /// Moves the cursor count lines down, or up when count is negative
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Move_Cursor_Lines(struct Editor::Data *editor_data, int64_t count) -> bool;
+
+        /// Moves the cursor count characters right, or left when count is negative,
+        //  wrapping around line ends the same way a single right / left motion does
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Move_Cursor_Columns(struct Editor::Data *editor_data, int64_t count) -> bool;
+
+        /// Scrolls the view count lines down, or up when count is negative
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Scroll_Lines(struct Editor::Data *editor_data, int64_t count) -> bool;
+
+        /// Applies a whole burst of motions at once
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Apply_Motion(struct Editor::Data *editor_data, Motion motion) -> bool;
+
+        /// Returns the last valid x position of line y, based on the editor's mode
+        static auto Line_End(struct Editor::Data *editor_data, int64_t y) -> int64_t;
+
+        /// Scrolls the view just enough for the cursor to be visible
+        static void Scroll_To_Cursor(struct Editor::Data *editor_data);
+
         Logic() = delete;
 
     private:
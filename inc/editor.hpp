@@ -1,7 +1,19 @@
 #pragma once
 
+#include <shared_mutex>
+
 #include "sdl_helper.hpp"
+#include "recovery.hpp"
+#include "register.hpp"
+#include "trigram.hpp"
+#include "syntax.hpp"
 #include "cursor.hpp"
+#include "search.hpp"
+#include "viewer.hpp"
+#include "codec.hpp"
+#include "watch.hpp"
+#include "cold.hpp"
+#include "undo.hpp"
 
 
 namespace Editor {
@@ -13,10 +25,21 @@ namespace Editor {
         Visual,
     };
 
+    enum Visual_Type : uint8_t {
+        Visual_Char,
+        Visual_Line,
+        Visual_Block,
+    };
+
     struct Data {
         std::vector<std::string> file_content;
         std::filesystem::path file_path;
 
+        /// Bumped on every edit. Edits hold content_mutex exclusively,
+        //  background readers hold it shared and compare the version they started on.
+        uint64_t version = 0;
+        std::shared_mutex content_mutex;
+
         size_t last_rendered_line = 0;
         size_t max_editor_width = 0;
 
@@ -25,8 +48,40 @@ namespace Editor {
         Position cursor;
         int64_t cursor_max_x = 0;
 
+        /// Cursors added on top of the main one, every edit made in insert mode is made at each of them
+        std::vector<Position> extra_cursors;
+
+        /// The other end of the visual selection, the cursor being the moving end
+        Position visual_start;
+        Visual_Type visual_type = Visual_Char;
+
         std::unordered_map<std::string_view, Cache*> caches;
 
+        Register::Store registers;
+        Undo::History history;
+        std::unique_ptr<Recovery::Swap_Writer> swap;
+
+        /// Appends what other programs add to the file, and reports their other changes
+        std::unique_ptr<Watch::Watcher> watcher;
+
+        /// The compression of the file on disk, saves compress it the same way
+        Codec::Format file_format = Codec::Plain;
+
+        /// Set for files too large to load, the buffer is then a read-only window of the file
+        std::unique_ptr<View::Viewer> viewer;
+
+        /// Edits report to it while holding content_mutex, its worker relexes only what they invalidated
+        Syntax::Highlighter syntax;
+
+        /// Only built for large files, searches skip the chunks it rules out
+        std::unique_ptr<Trigram::Index> trigrams;
+
+        /// Declared after the content and the index, so its workers are stopped before either is destroyed
+        Search::Searcher search;
+
+        /// Compresses the lines nobody looked at for a while, declared after the content so its pass is stopped first
+        Cold::Store cold;
+
         Mode mode = Normal;
 
         Data(std::vector<std::string> &file, std::filesystem::path &_file_path) :
@@ -89,5 +144,14 @@ namespace Editor {
             Position position,
             std::string &line
         ) const -> bool;
+
+        /// Renders the visual selection over the visible lines, as few merged rectangles as possible
+        auto Render_Selection(AppData *app_data, int32_t text_x) const -> bool;
+
+        /// Renders the search matches found so far on the visible lines
+        auto Render_Search_Matches(AppData *app_data, int32_t text_x) const -> bool;
+
+        /// Renders the extra cursors that are on the visible lines
+        auto Render_Extra_Cursors(AppData *app_data, int32_t text_x) const -> bool;
     };
 } /* namespace Editor */
\ No newline at end of file
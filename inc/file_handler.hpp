@@ -5,10 +5,13 @@
 #include <string>
 #include <vector>
 
+#include "codec.hpp"
+
 
 namespace File {
 
-    /// Parses a file and put the text into a std::vector<std::string> type
+    /// Parses a file and put the text into a std::vector<std::string> type.
+    //  Large files are mapped and split into chunks at line breaks, parsed by the task pool in parallel.
     /// @param file_path the path to the specified file, must be of type 'regular_file'
     /// @param tab_size the amount of spaces that will be used to replace the \t character
     /// @return will return an empty vector on failure
@@ -21,12 +24,18 @@ namespace File {
     /// @returns A future that will hold a vector of strings or an emptyt one.
     auto Parse_File_Async(std::string &file_path, int32_t tab_size) -> std::future<std::vector<std::string>>;
 
+    /// Splits text into lines the way Parse_File does, trimming each on the right and expanding its tabs
+    /// @param tab_size the amount of spaces that will be used to replace the \t character
+    auto Parse_Text(std::string_view text, int32_t tab_size) -> std::vector<std::string>;
+
     /// Writes / save the file content to the file_path
     /// @param file_path the path to the file that will be written to
     /// @param file_content the new content of the file
+    /// @param format the compression the content is written with
     /// @returns true on success or false on failure.
     auto Write_File(
         std::filesystem::path &file_path,
-        const std::vector<std::string> &file_content
+        const std::vector<std::string> &file_content,
+        Codec::Format format = Codec::Plain
     ) -> bool;
 } /* namespace File */
\ No newline at end of file
@@ -2,27 +2,103 @@
 
 #include "command.hpp"
 #include "editor.hpp"
+#include "keymap.hpp"
 
 
 namespace Input {
+    /// A key press or a text input that reached the handler, as recorded into a macro
+    struct Recorded_Event {
+        /// Empty for key presses
+        std::string text;
+        SDL_Scancode code = SDL_SCANCODE_UNKNOWN;
+        SDL_Keymod mod = 0;
+    };
+
     class
     Handler
     {
     public:
         Handler() = default;
 
+        /// Loads the normal mode keymap from the config
+        void Init(ConfigParser *config);
+
         /// Handles input from an SDL_Scancode
         /// @param code SDL_Scancode type
+        /// @param mod the modifier state of the key press
         /// @param editor editor class used
         /// @returns true on "should render", or false on "do nothing"
-        auto Handle(SDL_Scancode code, Editor::UI *editor, AppData *app_data, Command::Handler *command_handler) -> bool;
+        auto Handle(
+            SDL_Scancode code,
+            SDL_Keymod mod,
+            Editor::UI *editor,
+            AppData *app_data,
+            Command::Handler *command_handler
+        ) -> bool;
+
+        /// Handles an SDL_EVENT_TEXT_INPUT payload
+        /// @returns true on "should render", or false on "do nothing"
+        auto Handle_Text_Input(
+            std::string_view text,
+            Editor::UI *editor,
+            AppData *app_data,
+            Command::Handler *command_handler
+        ) -> bool;
+
+        /// Applies every queued motion at once, should be called after all pending events are handled
+        /// @returns true on "should render", or false on "do nothing"
+        auto Flush_Motion(Editor::UI *editor) -> bool;
+
+        /// Queues a scroll of lines lines, used for mouse wheel ticks
+        void Queue_Scroll(int64_t lines);
 
     private:
         bool is_lshift_pressed;
         bool is_lctrl_pressed;
         SDL_Scancode code;
+        SDL_Keymod mod;
+        Editor::UI *editor;
         Editor::Data *editor_data;
         AppData *app_data;
+        Command::Handler *command_handler;
+
+        /// Repeated motions are folded here, and applied once per frame
+        Cursor::Motion m_motion;
+
+        Keymap m_keymap;
+        Key_Sequence m_sequence;
+
+        /// Macros recorded with q{register}, and replayed with [count]@{register}
+        std::unordered_map<char, std::vector<Recorded_Event>> m_macros;
+        std::vector<Recorded_Event> m_recording;
+        char m_recording_name = '\0';
+        char m_last_macro = '\0';
+        int32_t m_replay_depth = 0;
+
+        /// The search that was active when the search prompt opened, restored if it is cancelled
+        std::string m_previous_pattern;
+        bool m_was_backward = false;
+
+        /// Opens the command line with a prompt, ':' for commands, '/' and '?' for searches
+        auto Open_Command_Line(const Key_Command &command) -> bool;
+
+        /// Appends an event to the macro being recorded, replayed events are not recorded again
+        void Record_Event(Recorded_Event event);
+
+        auto Start_Recording(char name) -> bool;
+        void Stop_Recording();
+
+        /// Replays a macro count times without rendering in between
+        /// @returns true on "should render", or false on "do nothing"
+        auto Replay(char name, int64_t count) -> bool;
+
+        /// Returns the character typed by the current key, or '\0' if it is not printable
+        [[nodiscard]]
+        auto Get_Key_Char() const -> char;
+
+        /// Queues the current key if it is a plain motion
+        /// @returns true if the key was queued
+        auto Queue_Motion() -> bool;
 
         /// Handles all default inputs that doesnt need to be on a certain editor mode
         /// @returns true on "should render", or false on "do nothing"
@@ -34,6 +110,22 @@ namespace Input {
         auto Handle_Command_Mode(Command::Handler *command_handler, Editor::Data *editor_data) -> bool;
     };
 
+    /// The text an operator acts on, end is exclusive.
+    //  Linewise ranges only use the y of start and end, both lines included.
+    struct Text_Range {
+        Position start;
+        Position end;
+        bool is_linewise = false;
+    };
+
+    /// What is erased around every cursor before text is inserted at it
+    enum Cursor_Erase : uint8_t {
+        Erase_Nothing,
+        Erase_Char_Before,
+        Erase_Word_Before,
+        Erase_Chars_After,
+    };
+
     class
     Logic
     {
@@ -41,7 +133,96 @@ namespace Input {
         static auto Handle_Backspace(Editor::Data *editor_data, bool is_lctrl_pressed) -> bool;
         static auto Handle_Return(Editor::Data *editor_data) -> bool;
 
+        /// Inserts an SDL_EVENT_TEXT_INPUT payload, large or multi-line payloads are pasted
+        static auto Handle_Text_Input(Editor::Data *editor_data, AppData *app_data, std::string_view text) -> bool;
+
+        /// Pastes text at the cursor with a single buffer insert, recorded as its own undo step
+        static auto Paste(Editor::Data *editor_data, AppData *app_data, std::string_view text) -> bool;
+
+        /// Pastes the clipboard at the cursor
+        static auto Paste_Clipboard(Editor::Data *editor_data, AppData *app_data) -> bool;
+
+        /// Executes a parsed normal mode command, a count is applied as a single buffer operation
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Execute(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool;
+
+        /// Executes a command typed in visual mode, operators act on the whole selection at once
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Execute_Visual(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool;
+
+        /// Switches to insert mode, every edit until escape is one undo step
+        static void Enter_Insert_Mode(Editor::Data *editor_data, AppData *app_data);
+
+        /// Moves the cursor to the count-th match of the current search, n and N
+        /// @param is_reversed searches against the direction of the last search
+        static auto Find_Match(Editor::Data *editor_data, bool is_reversed, int64_t count) -> bool;
+
+        /// Starts a visual selection at the cursor, or leaves visual mode if it already is of that type
+        static auto Enter_Visual_Mode(Editor::Data *editor_data, Editor::Visual_Type type) -> bool;
+
+        /// Starts or stops SDL text input, unless a macro is being replayed
+        static void Set_Text_Input(AppData *app_data, bool is_enabled);
+
+        /// Applies the same edit at the cursor and every extra cursor in one pass, as one undo step
+        /// @param erase what is erased at each cursor before text is inserted
+        /// @param count the amount of characters Erase_Chars_After erases
+        /// @returns true on "should render", or false on "do nothing"
+        static auto Edit_Cursors(
+            Editor::Data *editor_data,
+            std::string_view text,
+            Cursor_Erase erase,
+            int64_t count = 1
+        ) -> bool;
+
+        /// Drops every extra cursor
+        /// @returns true if there were extra cursors
+        static auto Clear_Extra_Cursors(Editor::Data *editor_data) -> bool;
+
     private:
         static void Handle_Ctrl_Backspace(Editor::Data *editor_data);
+
+        /// Returns where a motion moves the cursor to
+        static auto Find_Motion_Target(Editor::Data *editor_data, const Key_Command &command) -> Position;
+
+        /// Fills range with the text a motion or text object covers from the cursor
+        /// @returns true on success or false if the range is empty.
+        static auto Find_Range(Editor::Data *editor_data, const Key_Command &command, Text_Range *range) -> bool;
+
+        static auto Apply_Operator(
+            Editor::Data *editor_data,
+            AppData *app_data,
+            Action operation,
+            Text_Range range,
+            char register_name
+        ) -> bool;
+        static auto Execute_Command(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool;
+
+        /// Applies an operator on a block selection, the block lines are rewritten with a single replace
+        static auto Apply_Block_Operator(Editor::Data *editor_data, AppData *app_data, Action operation, char register_name) -> bool;
+
+        /// Replaces a range of text, as one undo step
+        static void Replace_Text(Editor::Data *editor_data, Position start, Position end, std::string_view text);
+
+        /// Indents or dedents every line from first to last, as one undo step
+        static void Shift_Lines(Editor::Data *editor_data, AppData *app_data, int64_t first, int64_t last, bool is_dedent);
+
+        /// Joins count lines starting at the cursor, as one undo step
+        static auto Join(Editor::Data *editor_data, int64_t count) -> bool;
+
+        /// Inserts the text of a register count times with a single insert
+        static auto Put(Editor::Data *editor_data, int64_t count, bool is_before, char register_name) -> bool;
+
+        /// Keeps the cursor on a valid normal mode position and scrolls to it
+        static void Settle_Cursor(Editor::Data *editor_data);
+
+        /// Adds extra cursors at the next count matches of the word under the cursor,
+        //  at every match of it, or count lines below the lowest cursor
+        static auto Add_Cursors(Editor::Data *editor_data, Action action, int64_t count) -> bool;
+
+        /// Moves every extra cursor the way a motion or an insert command moves the cursor
+        static void Move_Extra_Cursors(Editor::Data *editor_data, const Key_Command &command);
+
+        /// Sorts the extra cursors, and drops the ones sharing a position with another cursor
+        static void Merge_Extra_Cursors(Editor::Data *editor_data);
     };
 } /* namespace Input */
\ No newline at end of file
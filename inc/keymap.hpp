@@ -0,0 +1,190 @@
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ConfigParser;
+
+
+namespace Input {
+    enum Action_Type : uint8_t {
+        Motion_Action,
+        Operator_Action,
+        Text_Object_Action,
+        Command_Action,
+    };
+
+    enum Action : uint8_t {
+        No_Action,
+
+        /* Motions */
+        Left,
+        Right,
+        Down,
+        Up,
+        Word_Forward,
+        Word_Backward,
+        Word_End,
+        Line_Start,
+        First_Non_Blank,
+        Line_End,
+        File_Start,
+        File_End,
+        Paragraph_Forward,
+        Paragraph_Backward,
+
+        /* Operators */
+        Delete,
+        Yank,
+        Change,
+        Indent,
+        Dedent,
+        Lowercase,
+        Uppercase,
+        Toggle_Case,
+
+        /* Text objects */
+        Inner_Word,
+        A_Word,
+        Inner_Paragraph,
+        A_Paragraph,
+
+        /* Commands */
+        Insert_Before,
+        Append_After,
+        Insert_Line_Start,
+        Append_Line_End,
+        Open_Below,
+        Open_Above,
+        Delete_Char,
+        Delete_Char_Before,
+        Delete_To_End,
+        Change_To_End,
+        Put_After,
+        Put_Before,
+        Join_Lines,
+        Undo_Change,
+        Command_Line,
+        Record_Macro,
+        Replay_Macro,
+        Visual_Mode,
+        Visual_Line_Mode,
+        Swap_Anchor,
+        Add_Cursor_Next_Match,
+        Add_Cursor_All_Matches,
+        Add_Cursor_Below,
+        Search_Forward,
+        Search_Backward,
+        Search_Next,
+        Search_Previous,
+    };
+
+    /// The trie root a key sequence is looked up from
+    enum Key_Mode : uint8_t {
+        Normal_Keys,
+        Pending_Keys,
+        Visual_Keys,
+    };
+
+    /// Returns the type of an action
+    auto Get_Action_Type(Action action) -> Action_Type;
+
+    /// A fully parsed normal mode key sequence, [count] [operator [count]] motion / text object / command
+    struct Key_Command {
+        Action operation = No_Action;
+        Action target = No_Action;
+        int64_t count = 1;
+        bool has_count = false;
+
+        /// True for doubled operators (dd, yy, >>), which act on count whole lines
+        bool is_linewise = false;
+
+        /// Set with a "x prefix, '"' is the unnamed register. Also the argument of q and @
+        char register_name = '"';
+    };
+
+    /// A trie of key sequences, loaded from the [keymap] section of the config
+    class
+    Keymap
+    {
+    public:
+        Keymap();
+
+        /// Loads the default keymap, then overrides it with the [keymap] and [visual_keymap] sections of the config
+        /// @returns true on success or false on an unknown action name.
+        auto Load(ConfigParser *config) -> bool;
+
+        /// Binds keys to action, replacing any previous binding.
+        //  Motions and operators are bound in visual mode as well.
+        void Bind(std::string_view keys, Action action);
+
+        /// Binds keys to action in visual mode only
+        void Bind_Visual(std::string_view keys, Action action);
+
+        /// Looks up a key sequence
+        /// @param keys the key sequence
+        /// @param mode text objects are only matched while an operator is pending
+        /// @param action will be filled with the bound action, or No_Action
+        /// @returns true if keys is a bound sequence or a prefix of one, false if it matches nothing
+        auto Find(std::string_view keys, Key_Mode mode, Action *action) const -> bool;
+
+    private:
+        struct Node {
+            std::unordered_map<char, uint32_t> children;
+            Action action = No_Action;
+        };
+
+        /// The first nodes are the roots, indexed by Key_Mode
+        std::vector<Node> m_nodes;
+
+        void Insert(uint32_t root, std::string_view keys, Action action);
+        void Clear();
+    };
+
+    /// Parses normal mode keys into Key_Commands, one key at a time
+    class
+    Key_Sequence
+    {
+    public:
+        enum Status : uint8_t {
+            Incomplete,
+            Complete,
+            Invalid,
+        };
+
+        /// Feeds a key to the parser
+        /// @param key the typed character
+        /// @param command will be filled once the sequence is complete
+        /// @param mode Visual_Keys completes operators right away, they act on the selection
+        /// @returns the status of the sequence
+        auto Feed(const Keymap &keymap, char key, Key_Command *command, Key_Mode mode = Normal_Keys) -> Status;
+
+        void Reset();
+
+        /// Checks if no key is pending
+        [[nodiscard]]
+        auto Is_Empty() const -> bool
+        {
+            return m_keys.empty() && m_count.empty() && m_operator == No_Action &&
+                   !m_is_register_pending && m_register_name == '"' && m_argument_action == No_Action;
+        }
+
+    private:
+        std::string m_keys;
+        std::string m_count;
+        int64_t m_operator_count = 1;
+        bool m_has_count = false;
+        Action m_operator = No_Action;
+        std::string m_operator_keys;
+        char m_register_name = '"';
+        bool m_is_register_pending = false;
+
+        /// A command waiting for its register argument, q and @
+        Action m_argument_action = No_Action;
+
+        /// Moves the typed count digits into a number, multiplying it with the previous count
+        void Commit_Count();
+    };
+} /* namespace Input */
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <cstdint>
+#include <thread>
+#include <string>
+#include <mutex>
+
+#include "utilities.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+namespace Recovery {
+    /// Returns the swap file path of file_path, .<file name>.swp next to the file
+    auto Swap_Path(const std::filesystem::path &file_path) -> std::filesystem::path;
+
+    /// Asks the user on the terminal whether the swap file should be replayed
+    /// @returns true if the user agreed, false otherwise or when stdin is not a terminal
+    auto Prompt_Recovery(const std::filesystem::path &swap_path) -> bool;
+
+    /// Appends every edit made to a buffer into its swap file.
+    //  Records are only copied into a pending batch on the caller's thread,
+    //  a background thread writes and fsyncs the batch on a timer.
+    class
+    Swap_Writer
+    {
+    public:
+        Swap_Writer() = default;
+        ~Swap_Writer();
+
+        Swap_Writer(const Swap_Writer&) = delete;
+        auto operator=(const Swap_Writer&) -> Swap_Writer& = delete;
+
+        /// Creates / truncates the swap file and starts the writer thread
+        /// @param file_path the path of the edited file
+        /// @param content_hash the hash of the content currently on disk
+        /// @param interval_ms how often the pending records are flushed, once a second if it is not positive
+        /// @returns true on success or false on failure.
+        auto Open(const std::filesystem::path &file_path, uint64_t content_hash, int64_t interval_ms) -> bool;
+
+        void Record_Insert(Position position, std::string_view text);
+        void Record_Erase(Position start, Position end);
+
+        /// Drops every record, should be called after the file is saved
+        /// @param content_hash the hash of the content that was just saved
+        void Reset(uint64_t content_hash);
+
+        /// Stops the writer thread and deletes the swap file
+        void Remove();
+
+    private:
+        std::filesystem::path m_swap_path;
+        int32_t m_fd = -1;
+
+        std::string m_pending;
+        std::mutex m_mutex;
+
+        /// Held while the swap file itself is written, so a reset never interleaves with a batch
+        std::mutex m_file_mutex;
+        std::condition_variable m_condition;
+        std::thread m_thread;
+        bool m_is_running = false;
+        bool m_is_dirty = false;
+
+        /// Writes and syncs the pending batch every interval, until stopped
+        void Writer_Loop(std::chrono::milliseconds interval);
+
+        /// Writes the pending batch into the swap file
+        /// @warning neither mutex should be held by the caller
+        void Flush();
+
+        void Stop();
+    };
+
+    /// Replays the swap file into the editor's buffer, every record goes through Buffer
+    //  so it ends up in both the undo history and the new swap file
+    /// @param records the content of the swap file, read before the new swap file is opened
+    /// @param content_hash the hash of the content the records will be applied on
+    /// @returns true on success or false on failure.
+    auto Replay(std::string_view records, uint64_t content_hash, Editor::Data *editor_data) -> bool;
+
+    /// Reads the swap file of file_path into a string
+    /// @returns an empty string on failure
+    auto Read_Swap(const std::filesystem::path &file_path) -> std::string;
+} /* namespace Recovery */
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <bitset>
+#include <string>
+#include <vector>
+#include <array>
+
+
+/// A regex engine without backtracking: patterns are compiled into NFAs,
+//  which are turned into DFA states lazily while matching, so matching is linear in the text.
+//  The syntax is vim's very magic one: . [] () | * + ? {n,m} ^ $ \d \w \s.
+namespace Regex {
+    using Byte_Set = std::bitset<256>;
+
+    enum State_Type : uint8_t {
+        Byte_State,
+        Split_State,
+        Line_Start_State,
+        Line_End_State,
+        Match_State,
+    };
+
+    struct State {
+        State_Type type;
+
+        /// Index into the byte sets, for Byte_State
+        int32_t set = -1;
+        int32_t out = -1;
+
+        /// The second branch of a Split_State
+        int32_t out1 = -1;
+    };
+
+    struct Nfa {
+        std::vector<State> states;
+        std::vector<Byte_Set> sets;
+        int32_t start = -1;
+    };
+
+    /// A compiled pattern, shared read-only between every thread that matches it
+    struct Program {
+        /// Finds every position a match starts at, scanning backward from the line end
+        Nfa reversed;
+
+        /// Finds the longest match from a start
+        Nfa anchored;
+    };
+
+    /// Compiles a pattern
+    /// @returns true on success or false on a syntax error, which is logged.
+    auto Compile(std::string_view pattern, Program *program) -> bool;
+
+    /// A match inside a line, length may be 0
+    struct Match {
+        int64_t start;
+        int64_t length;
+    };
+
+    /// A DFA built lazily from one of the NFAs of a program.
+    //  States are cached until there are too many, then the cache starts over.
+    class
+    Dfa
+    {
+    public:
+        explicit Dfa(const Nfa *nfa) : m_nfa(nfa) {}
+
+        /// The starting state, at_line_start is set when the scan starts on the line boundary
+        auto Start(bool at_line_start) -> int32_t;
+
+        /// The state after byte, the cached transition is taken without leaving the header
+        auto Step(int32_t state, uint8_t byte) -> int32_t
+        {
+            int32_t next = m_next[state][byte];
+            return (next >= 0 ? next : Compute_Step(state, byte));
+        }
+
+        [[nodiscard]]
+        auto Is_Match(int32_t state) const -> bool
+        { return m_is_match[state]; }
+
+        [[nodiscard]]
+        auto Is_Dead(int32_t state) const -> bool
+        { return m_sets[state].empty(); }
+
+        /// Checks if the state matches once the scan reaches the other line boundary
+        auto Is_Match_At_End(int32_t state) -> bool;
+
+        /// Counts the times the cache started over, which gives every state a new id
+        [[nodiscard]]
+        auto Get_Resets() const -> uint64_t
+        { return m_resets; }
+
+    private:
+        static const size_t MAX_STATES = 4096;
+
+        const Nfa *m_nfa;
+
+        /// The NFA states of each DFA state, sorted
+        std::vector<std::vector<int32_t>> m_sets;
+        std::vector<std::array<int32_t, 256>> m_next;
+        std::vector<bool> m_is_match;
+        std::vector<int8_t> m_is_match_at_end;
+        std::unordered_map<std::string, int32_t> m_ids;
+        std::array<int32_t, 2> m_starts = { -1, -1 };
+        uint64_t m_resets = 0;
+
+        /// Follows every empty transition from the states in set
+        void Close(std::vector<int32_t> *set, bool at_line_start, bool at_line_end) const;
+
+        /// Builds the transition of state on byte, a miss in the cache
+        auto Compute_Step(int32_t state, uint8_t byte) -> int32_t;
+
+        /// Returns the DFA state of a set of NFA states, creating it if needed
+        auto Intern(std::vector<int32_t> set) -> int32_t;
+
+        void Clear();
+    };
+
+    /// Matches a compiled program, each thread needs its own matcher
+    class
+    Matcher
+    {
+    public:
+        explicit Matcher(const Program *program);
+
+        /// Appends every leftmost-longest match of line into matches
+        void Find_All(std::string_view line, std::vector<Match> *matches);
+
+    private:
+        Dfa m_reversed;
+        Dfa m_anchored;
+
+        /// The positions of the line that a match starts at
+        std::vector<uint8_t> m_is_start;
+
+        /// The anchored states of the current scan, one per position after its start
+        std::vector<int32_t> m_trail;
+
+        /// Positions and anchored states an earlier scan went through after its last match, packed together.
+        //  A scan reaching one of them follows the same path from there, and cannot match again either.
+        std::unordered_set<uint64_t> m_doomed;
+    };
+} /* namespace Regex */
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <array>
+
+#include "utilities.hpp"
+
+
+namespace Register {
+    /// Register text, never modified once built, so registers and puts can share it
+    using Text = std::shared_ptr<const std::string>;
+
+    struct Entry {
+        Text text;
+
+        /// While the entry is live, text is null and the entry refers to this range of the buffer
+        Position start;
+        Position end;
+        bool is_live = false;
+
+        /// Linewise text always ends with a newline
+        bool is_linewise = false;
+
+        [[nodiscard]]
+        auto Is_Empty() const -> bool
+        { return !is_live && text == nullptr; }
+    };
+
+    /// Vim registers: "" "0-"9 "a-"z "- and the "_ black hole.
+    //  A yank only records the yanked range, the text is copied out of the buffer
+    //  right before something inside that range is modified.
+    class
+    Store
+    {
+    public:
+        Store() = default;
+
+        /// Checks if name can be used as a register name, uppercase letters append to their register
+        static auto Is_Valid_Name(char name) -> bool;
+
+        /// Yanks a range of content into a register, in O(1)
+        /// @param name the register name, '"' yanks into "0
+        void Yank(const std::vector<std::string> &content, char name, Position start, Position end, bool is_linewise);
+
+        /// Stores text that is not a single range of content into a register, such as a block
+        /// @param name the register name, '"' stores into "0
+        void Yank_Text(const std::vector<std::string> &content, char name, std::string text, bool is_linewise);
+
+        /// Stores deleted text into a register, shifting the numbered registers like vim does
+        /// @param name the register name, '"' stores into "1 or "-
+        void Delete(const std::vector<std::string> &content, char name, std::string text, bool is_linewise);
+
+        /// Returns a register, copying its text out of content if it is still live
+        /// @returns nullptr if the register is empty
+        auto Get(const std::vector<std::string> &content, char name) -> const Entry*;
+
+        /// Must be called before text is inserted into content
+        void Before_Insert(const std::vector<std::string> &content, Position position, std::string_view text);
+
+        /// Must be called before a range of content is erased
+        void Before_Erase(const std::vector<std::string> &content, Position start, Position end);
+
+        /// Checks if a live entry still refers to any of the lines first to last
+        [[nodiscard]]
+        auto Is_Live(int64_t first, int64_t last) const -> bool;
+
+    private:
+        static const size_t REGISTER_COUNT = 37;
+
+        std::array<Entry, REGISTER_COUNT> m_entries;
+
+        /// The register "" currently points to
+        char m_unnamed = '0';
+
+        /// @returns -1 for names that are not stored
+        static auto Index(char name) -> int32_t;
+
+        /// Stores entry into a register, appending to it for uppercase names
+        void Set(const std::vector<std::string> &content, char name, Entry entry);
+
+        /// Copies the text of a live entry out of content
+        static void Materialise(const std::vector<std::string> &content, Entry &entry);
+    };
+} /* namespace Register */
@@ -16,6 +16,9 @@ struct AppData {
     ConfigParser config;
 
     bool debug;
+
+    /// Set while a macro is replayed, nothing is rendered and SDL state is only synced at the end
+    bool is_headless = false;
 };
 
 
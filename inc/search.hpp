@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "utilities.hpp"
+#include "regex.hpp"
+#include "tasks.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+namespace Search {
+    struct Match {
+        Position start;
+        int64_t length;
+    };
+
+    /// Compiles pattern if it starts with \v, program is left empty for a literal pattern
+    /// @returns false if the regex does not compile, the error is logged
+    auto Compile(std::string_view pattern, std::shared_ptr<const Regex::Program> *program) -> bool;
+
+    /// Appends the matches of pattern in line, without overlaps
+    /// @param matcher a matcher of the compiled pattern, or nullptr for a literal pattern
+    void Find_In_Line(
+        std::string_view line,
+        std::string_view pattern,
+        Regex::Matcher *matcher,
+        std::vector<Regex::Match> *matches
+    );
+
+    /// Scans a buffer for a pattern on the task pool, chunk by chunk, starting with the viewport.
+    //  Patterns starting with \v are very magic regexes, anything else is matched literally.
+    //  Finished chunks are tagged with the search generation and the buffer version they were scanned on,
+    //  the main thread collects them once per frame and drops the stale ones.
+    class
+    Searcher
+    {
+    public:
+        Searcher() = default;
+        ~Searcher();
+
+        Searcher(const Searcher&) = delete;
+        auto operator=(const Searcher&) -> Searcher& = delete;
+
+        /// Starts searching for pattern, cancelling the previous search.
+        //  An empty pattern, or a regex that does not compile, clears the search.
+        /// @param is_backward the direction n moves in, ? searches backward
+        void Start(Editor::Data *editor_data, std::string_view pattern, bool is_backward);
+
+        /// Moves the chunks scanned by the worker into the results, and restarts the search if the buffer changed.
+        //  Should be called once per frame on the main thread.
+        /// @returns true on "should render", or false on "nothing new"
+        auto Collect(Editor::Data *editor_data) -> bool;
+
+        /// Finds the count-th match after from, or before it when is_backward is set, wrapping around the buffer.
+        //  Chunks the worker has not reached yet are scanned on the caller's thread.
+        /// @returns true if a match was found
+        auto Find_Next(Editor::Data *editor_data, Position from, bool is_backward, int64_t count, Position *match) -> bool;
+
+        /// Fills matches with the matches found on line y, sorted
+        /// @returns false if the line has not been scanned yet
+        [[nodiscard]]
+        auto Get_Line_Matches(int64_t y, std::vector<Match> *matches) const -> bool;
+
+        [[nodiscard]]
+        auto Get_Pattern() const -> std::string_view
+        { return m_pattern; }
+
+        [[nodiscard]]
+        auto Is_Backward() const -> bool
+        { return m_is_backward; }
+
+        /// Lines are scanned in chunks of this many lines
+        static const int64_t CHUNK_LINES = 16384;
+
+    private:
+        struct Chunk {
+            std::vector<Match> matches;
+            bool is_scanned = false;
+        };
+
+        struct Finished_Chunk {
+            uint64_t generation;
+            size_t index;
+            std::vector<Match> matches;
+        };
+
+        /// One search, shared by every worker, which claim its chunks in order
+        struct Job {
+            uint64_t generation;
+            std::string pattern;
+            std::shared_ptr<const Regex::Program> program;
+            uint64_t version;
+            size_t first_chunk;
+            Editor::Data *editor_data;
+            std::atomic<size_t> next_chunk = 0;
+        };
+
+        /* Owned by the main thread */
+        std::string m_pattern;
+        std::shared_ptr<const Regex::Program> m_program;
+        std::unique_ptr<Regex::Matcher> m_matcher;
+        bool m_is_backward = false;
+        uint64_t m_version = 0;
+        std::vector<Chunk> m_chunks;
+
+        /* Shared with the jobs */
+        std::mutex m_mutex;
+        std::atomic<uint64_t> m_generation = 0;
+        std::vector<Finished_Chunk> m_finished;
+
+        /// Cancels the jobs of the previous search that have not started yet
+        Tasks::Token m_token;
+        Tasks::Group m_jobs;
+
+        /// Scans chunks of job until every chunk is claimed, or the generation or the buffer changes
+        void Scan_Job(const std::shared_ptr<Job> &job);
+
+        /// Scans the lines of a chunk for pattern, with matcher if the pattern is a regex.
+        //  Literal patterns skip the chunk when the trigram index rules it out, before a compressed chunk is decompressed.
+        static auto Scan_Chunk(
+            const Editor::Data *editor_data,
+            size_t index,
+            std::string_view pattern,
+            Regex::Matcher *matcher
+        ) -> std::vector<Match>;
+
+        void Stop();
+    };
+} /* namespace Search */
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "tasks.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+namespace Cold {
+    class Reader;
+};
+
+
+/// Syntax highlighting: table-driven lexers that carry a state from one line to the next,
+//  so a line can be lexed on its own from the state the line before it ended in.
+namespace Syntax {
+    enum Token_Type : uint8_t {
+        Plain,
+        Keyword,
+        Type,
+        Number,
+        String,
+        Comment,
+        Preprocessor,
+    };
+
+    /// What a line ends inside of, the only thing one line passes on to the next
+    enum State : uint8_t {
+        Normal_State,
+        Block_Comment_State,
+        Long_String_State,
+    };
+
+    /// A highlighted part of a line, the text between runs is plain
+    struct Run {
+        int64_t start;
+        int64_t length;
+        Token_Type type;
+    };
+
+    /// The table a language is lexed from, an empty delimiter is a feature the language does not have
+    struct Language {
+        std::string_view name;
+
+        /// File extensions with the dot, or whole file names
+        std::vector<std::string_view> extensions;
+
+        std::string_view line_comment;
+        std::string_view block_comment_start;
+        std::string_view block_comment_end;
+
+        /// Opens and closes a string that may span lines, like python's """
+        std::string_view long_string;
+
+        /// Each character opens and closes a single line string
+        std::string_view quotes;
+
+        /// Lines starting with # are preprocessor directives
+        bool has_preprocessor = false;
+
+        /// Keywords and type names
+        std::unordered_map<std::string_view, Token_Type> words;
+    };
+
+    /// Finds the language of a file from its name or extension
+    /// @returns the language or nullptr if there is none for the file
+    auto Find_Language(const std::filesystem::path &file_path) -> const Language*;
+
+    /// Lexes line starting in state, appending the highlighted runs into runs when it is set
+    /// @returns the state at the end of the line
+    auto Lex_Line(const Language &language, std::string_view line, State state, std::vector<Run> *runs) -> State;
+
+    /// Highlights the buffer on the task pool one batch per job, the viewport first.
+    //  The worker keeps the state every few lines starts in as checkpoints, which follow their lines through edits,
+    //  so the viewport is lexed from the nearest checkpoint before it instead of from the start of the file.
+    //  An edit only invalidates the checkpoints after it, until one of them is reached in the same state as before.
+    //  Lexed lines are tagged with the buffer version they were lexed on, the main thread collects them
+    //  once per frame and drops the stale ones, lines without results are drawn plain.
+    class
+    Highlighter
+    {
+    public:
+        Highlighter() = default;
+        ~Highlighter();
+
+        Highlighter(const Highlighter&) = delete;
+        auto operator=(const Highlighter&) -> Highlighter& = delete;
+
+        /// Highlights the content of editor_data as language from scratch, nullptr stops highlighting
+        void Start(Editor::Data *editor_data, const Language *language);
+
+        [[nodiscard]]
+        auto Get_Language() const -> const Language*
+        { return m_language; }
+
+        /// Lines first to last were rewritten by an edit, which moved every line after them by line_shift.
+        //  Has to be called on the main thread while the edit holds content_mutex.
+        void After_Edit(int64_t first, int64_t last, int64_t line_shift);
+
+        /// Asks the worker for the lines around the viewport and takes the lines it lexed since the last call.
+        //  Should be called once per frame on the main thread.
+        /// @returns true on "should render", or false on "nothing new"
+        auto Collect(Editor::Data *editor_data) -> bool;
+
+        /// Fills runs with the highlighted runs of line y
+        /// @returns false if the line has not been highlighted yet
+        auto Get_Line_Runs(int64_t y, std::vector<Run> *runs) const -> bool;
+
+        /// The state a line starts in is kept every this many lines
+        static const int64_t CHECKPOINT_LINES = 1024;
+
+        /// The most lines the worker lexes while holding content_mutex
+        static const int64_t BATCH_LINES = 16384;
+
+    private:
+        struct Checkpoint {
+            int64_t line;
+            State state;
+        };
+
+        /// Lines the main thread asked for, or the worker lexed, and the version of the buffer
+        struct Range {
+            int64_t first = 0;
+            int64_t last = 0;
+            uint64_t version = 0;
+
+            auto operator==(const Range&) const -> bool = default;
+        };
+
+        struct Lexed_Lines {
+            Range range;
+            std::vector<std::vector<Run>> runs;
+        };
+
+        const Language *m_language = nullptr;
+        Editor::Data *m_editor_data = nullptr;
+
+        /* Only touched by the worker while it holds content_mutex shared and by edits while they hold it */
+        std::vector<Checkpoint> m_checkpoints;
+
+        /// Checkpoints before this index are up to date
+        size_t m_valid = 0;
+
+        /// The last line edits rewrote since every checkpoint was up to date, -1 if there is none
+        int64_t m_edited_end = -1;
+
+        /* Shared with the jobs under m_mutex */
+        std::mutex m_mutex;
+        Tasks::Group m_jobs;
+        bool m_is_running = false;
+        bool m_is_scheduled = false;
+        bool m_is_complete = false;
+        Range m_wanted;
+        Range m_published;
+        std::vector<Lexed_Lines> m_finished;
+
+        /* Main thread only */
+        std::unordered_map<int64_t, std::vector<Run>> m_shown;
+
+        /// Queues the next step unless one is queued already or there is nothing to do, m_mutex has to be held.
+        //  The viewport is lexed as an interactive job, the rest of the file as background ones.
+        void Schedule();
+
+        /// Lexes the viewport when it is asked for, or one batch of the rest of the file otherwise,
+        //  then queues the next step
+        void Run_Step();
+
+        /// Lexes up to BATCH_LINES lines from the last valid checkpoint, updating the checkpoints it passes
+        /// @returns true once every checkpoint is valid up to the end of the file
+        auto Extend(Cold::Reader &content) -> bool;
+
+        /// Finds the last valid checkpoint at or before line
+        [[nodiscard]]
+        auto Find_Checkpoint(int64_t line) const -> size_t;
+
+        /// Lexes the lines of range, starting from the checkpoint before it
+        [[nodiscard]]
+        auto Lex_Range(Cold::Reader &content, Range range) const -> Lexed_Lines;
+
+        void Stop();
+    };
+} /* namespace Syntax */
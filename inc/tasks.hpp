@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+#include <SDL3/SDL.h>
+
+
+/// One work-stealing thread pool shared by every background job of the process.
+//  Each worker owns a deque per priority, it pops its own jobs from the back and steals from the front of the others',
+//  and every interactive job anywhere is taken before any background one.
+namespace Tasks {
+    enum Priority : uint8_t {
+        /// Work the user is waiting on, like the viewport of a search or of the highlighter
+        Interactive,
+
+        /// Work nobody is waiting on, like indexing or highlighting the rest of a file
+        Background,
+    };
+
+    /// Shared between the jobs of a request and whoever may cancel it, cancelled jobs are skipped
+    //  and long jobs check it between units of work
+    class
+    Token
+    {
+    public:
+        Token() :
+            m_is_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+        void Cancel()
+        { *m_is_cancelled = true; }
+
+        [[nodiscard]]
+        auto Is_Cancelled() const -> bool
+        { return *m_is_cancelled; }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_is_cancelled;
+    };
+
+    /// Counts the jobs submitted with it that have not finished, so their owner can wait for them before it goes away
+    class
+    Group
+    {
+    public:
+        Group() = default;
+        ~Group();
+
+        Group(const Group&) = delete;
+        auto operator=(const Group&) -> Group& = delete;
+
+        /// Blocks until every job submitted with this group has finished
+        /// @warning Should not be called from a job of the same group.
+        void Wait();
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        int64_t m_count = 0;
+
+        friend void Submit(Priority priority, std::function<void()> job, Group *group, Token token);
+    };
+
+    /// Starts the workers and registers the completion event, should be called on the main thread after SDL_Init.
+    //  Jobs submitted before it start the workers themselves, their completions are then run by Run_Completions only.
+    /// @param thread_count the number of workers, 0 for one per hardware thread
+    void Start(uint32_t thread_count = 0);
+
+    /// Stops the workers once they have run the jobs still queued
+    void Stop();
+
+    [[nodiscard]]
+    auto Get_Thread_Count() -> uint32_t;
+
+    /// Queues job on the pool, the current worker's own deque when called from a job
+    /// @param group counts the job until it finishes, or nullptr
+    /// @param token skips the job if it is cancelled before it starts
+    void Submit(Priority priority, std::function<void()> job, Group *group = nullptr, Token token = {});
+
+    /// Queues job on the pool, and then on_done on the main thread, delivered through an SDL user event.
+    //  Neither runs if token is cancelled first.
+    void Submit_With_Completion(
+        Priority priority,
+        std::function<void()> job,
+        std::function<void()> on_done,
+        Group *group = nullptr,
+        Token token = {}
+    );
+
+    /// Queues on_main to run on the main thread, delivered through an SDL user event like a completion
+    void Run_On_Main(std::function<void()> on_main);
+
+    /// Checks if event is the completion event
+    [[nodiscard]]
+    auto Is_Completion_Event(const SDL_Event *event) -> bool;
+
+    /// Runs the completions of every job that finished so far, on the main thread
+    /// @returns true if any completion ran
+    auto Run_Completions() -> bool;
+} /* namespace Tasks */
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <shared_mutex>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tasks.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+/// A trigram index of the buffer, so literal searches can skip the lines that cannot contain their pattern
+namespace Trigram {
+    /// Keeps the set of trigrams found in each chunk of lines, built one chunk per background job on the task pool.
+    //  Chunks follow their lines when edits move them, so an edit only reindexes the chunks it touches.
+    //  Edits report to the index while they hold content_mutex, so readers holding it see both in sync.
+    class
+    Index
+    {
+    public:
+        Index() = default;
+        ~Index();
+
+        Index(const Index&) = delete;
+        auto operator=(const Index&) -> Index& = delete;
+
+        /// Indexes the content of editor_data from scratch, in the background
+        void Start(Editor::Data *editor_data);
+
+        /// Lines first to last were rewritten by an edit, which moved every line after them by line_shift.
+        //  Has to be called while the edit holds content_mutex.
+        void After_Edit(int64_t first, int64_t last, int64_t line_shift);
+
+        /// Checks if the lines from first up to last may contain pattern.
+        /// @returns false only if every chunk over those lines is indexed and misses one of the pattern's trigrams
+        [[nodiscard]]
+        auto May_Contain(int64_t first, int64_t last, std::string_view pattern) const -> bool;
+
+        /// Lines are indexed in chunks of about this many lines
+        static const int64_t CHUNK_LINES = 16384;
+
+    private:
+        struct Chunk {
+            int64_t start;
+
+            /// Sorted, each trigram packed into the low 24 bits
+            std::vector<uint32_t> trigrams;
+            bool is_indexed = false;
+        };
+
+        mutable std::shared_mutex m_mutex;
+        bool m_is_running = false;
+        bool m_is_scheduled = false;
+        Editor::Data *m_editor_data = nullptr;
+        std::vector<Chunk> m_chunks;
+        Tasks::Group m_jobs;
+
+        /// Queues a job for the next unindexed chunk unless one is queued already, m_mutex has to be held
+        void Schedule();
+
+        /// Indexes one chunk, then queues the job for the next one
+        void Index_Next_Chunk();
+
+        /// Finds the chunk that line is in
+        [[nodiscard]]
+        auto Find_Chunk(int64_t line) const -> size_t;
+
+        [[nodiscard]]
+        auto Has_Unindexed() const -> bool;
+
+        void Stop();
+    };
+} /* namespace Trigram */
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "utilities.hpp"
+
+#if __unix__
+    static const std::filesystem::path DEFAULT_CACHE_PATH = (
+        getenv("XDG_CACHE_HOME") != nullptr ?
+        std::filesystem::path(getenv("XDG_CACHE_HOME")) / "c+text" :
+        std::filesystem::path(getenv("HOME")) / ".cache/c+text"
+    );
+#elif _WIN32
+    static const std::filesystem::path DEFAULT_CACHE_PATH = std::filesystem::path(getenv("LOCALAPPDATA")) / "c+text";
+#else
+#   error "Unsupported platform!"
+#endif
+
+namespace Editor {
+    struct Data;
+};
+
+
+namespace Undo {
+    enum Type : uint8_t {
+        Insert,
+        Erase,
+    };
+
+    /// A single compact edit, text may span multiple lines
+    struct Operation {
+        Type type;
+        Position start;
+        Position end;
+        std::string text;
+
+        Operation(Type type, Position start, Position end, std::string_view text) :
+            type(type),
+            start(start),
+            end(end),
+            text(text) {}
+    };
+
+    /// A set of operations that will be undone / redone as one step
+    struct Group {
+        std::vector<Operation> operations;
+        Position cursor_before;
+        Position cursor_after;
+        size_t memory_usage = 0;
+
+        [[nodiscard]]
+        auto
+        Is_Empty() const -> bool
+        { return operations.empty(); }
+    };
+
+    /// An append-only binary journal that keeps the undo history of a file across sessions.
+    //  The journal is memory-mapped on open, only the record headers are walked,
+    //  groups are decoded lazily when they are undone.
+    class
+    Journal
+    {
+    public:
+        Journal() = default;
+        ~Journal();
+
+        Journal(const Journal&) = delete;
+        auto operator=(const Journal&) -> Journal& = delete;
+
+        /// Opens / creates the journal of file_path inside the cache directory
+        /// @param content_hash the hash of the file's content, history saved on another content is dropped
+        /// @returns true on success or false on failure.
+        auto Open(const std::filesystem::path &file_path, uint64_t content_hash) -> bool;
+
+        /// Appends groups to the journal, followed by a checkpoint of the saved content
+        /// @param groups the groups that have not yet been written
+        /// @param content_hash the hash of the content that was just saved
+        /// @returns true on success or false on failure.
+        auto Append(const std::deque<Group> &groups, size_t first, uint64_t content_hash) -> bool;
+
+        /// Decodes and pops the newest persisted group
+        /// @returns true on success or false when there are no persisted groups left
+        auto Pop_Group(Group &group) -> bool;
+
+        /// Pops the newest persisted group without decoding it,
+        //  used when the group is still held in memory
+        void Drop_Top();
+
+        /// Marks the journal as disconnected from the in-memory history, its groups can no longer be popped
+        //  and the next append will start the persisted history over
+        void Mark_Broken();
+
+        [[nodiscard]]
+        auto Is_Open() const -> bool
+        { return m_fd >= 0; }
+
+        [[nodiscard]]
+        auto Is_Broken() const -> bool
+        { return m_is_broken; }
+
+    private:
+        std::filesystem::path m_path;
+        int32_t m_fd = -1;
+        uint8_t *m_map = nullptr;
+        size_t m_map_size = 0;
+        size_t m_file_size = 0;
+
+        /// Offsets of every group record in the persisted history, newest at the back
+        std::vector<uint64_t> m_stack;
+        uint64_t m_pending_rewinds = 0;
+        bool m_is_broken = false;
+
+        /// Maps the whole journal file into memory
+        auto Map() -> bool;
+        void Unmap();
+
+        /// Walks the record headers, and rebuilds the persisted history
+        /// @returns the offset right after the last valid checkpoint matching content_hash, or 0
+        auto Walk_Records(uint64_t content_hash) -> size_t;
+
+        /// Rewrites the journal with only the live groups and a checkpoint of content_hash,
+        //  once the records rewound or started over outweigh them
+        void Compact(uint64_t content_hash);
+
+        auto Decode_Group(uint64_t offset, Group &group) const -> bool;
+    };
+
+    class
+    History
+    {
+    public:
+        History() = default;
+
+        /// Opens an undo group, every operation recorded until End_Group is called
+        //  will be undone / redone as a single step. Groups can be nested.
+        /// @param cursor the cursor position that will be restored on undo
+        void Begin_Group(Position cursor);
+
+        /// Closes the currently opened undo group
+        /// @param cursor the cursor position that will be restored on redo
+        void End_Group(Position cursor);
+
+        /// Records an insertion of text between start and end
+        void Record_Insert(Position start, Position end, std::string_view text);
+
+        /// Records an erasure of text between start and end
+        void Record_Erase(Position start, Position end, std::string_view text);
+
+        /// Reverts the last undo group
+        /// @returns true on "should render", or false on "nothing to undo"
+        auto Undo(Editor::Data *editor_data) -> bool;
+
+        /// Re-applies the last undone group
+        /// @returns true on "should render", or false on "nothing to redo"
+        auto Redo(Editor::Data *editor_data) -> bool;
+
+        /// Sets the maximum amount of bytes the history is allowed to hold,
+        //  the oldest groups will be dropped when the cap is exceeded
+        void Set_Memory_Cap(size_t bytes);
+
+        /// Drops every undo and redo group
+        void Clear();
+
+        /// Loads the persisted history of file_path, undoing past the
+        //  in-memory history will continue into the journal
+        /// @returns true on success or false on failure.
+        auto Open_Journal(const std::filesystem::path &file_path, uint64_t content_hash) -> bool;
+
+        /// Writes every group that is not yet persisted into the journal,
+        //  should be called after the file is saved
+        /// @returns true on success or false on failure.
+        auto Save_Journal(uint64_t content_hash) -> bool;
+
+    private:
+        std::deque<Group> m_undo_stack;
+        std::vector<Group> m_redo_stack;
+        Group m_current;
+        Journal m_journal;
+
+        /// Amount of groups, from the bottom of the undo stack, that are already in the journal
+        size_t m_written = 0;
+
+        uint32_t m_group_depth = 0;
+        size_t m_memory_usage = 0;
+        size_t m_memory_cap = SIZE_MAX;
+
+        /// Moves the current group into the undo stack
+        void Commit_Group();
+
+        /// Drops the oldest groups until the memory usage is under the cap
+        void Enforce_Memory_Cap();
+
+        /// Tries to merge the operation into the last recorded one
+        /// @returns true if merged, false if a new operation is needed
+        auto Merge_Operation(Type type, Position start, Position end, std::string_view text) -> bool;
+
+        /// Clamps the cursor into the bounds of the file content
+        static void Clamp_Cursor(Editor::Data *editor_data, Position cursor);
+    };
+} /* namespace Undo */
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 
 namespace Color {
@@ -44,6 +45,13 @@ struct Position {
     [[nodiscard]]
     auto Is_Zero() const -> bool
     { return x == 0 && y == 0; }
+
+    /// Checks if this position comes before other in the text
+    [[nodiscard]]
+    auto Is_Before(const Position &other) const -> bool
+    { return y < other.y || (y == other.y && x < other.x); }
+
+    auto operator==(const Position &other) const -> bool = default;
 };
 
 namespace Utils {
@@ -69,6 +77,27 @@ namespace Utils {
     /// Checks if checked_string is only composed of whitespaces
     auto Is_All_Space(std::string_view checked_string) -> bool;
 
+    /// The hash Hash_Content starts from, before its first line
+    static const uint64_t CONTENT_HASH_BASIS = 0xcbf29ce484222325;
+
+    /// Hashes the content of a buffer, lines are hashed as if they were joined with newlines
+    /// @returns a 64 bit hash of the content
+    auto Hash_Content(const std::vector<std::string> &content) -> uint64_t;
+
+    /// Adds the next line of a buffer to hash, for buffers that are not read as a vector
+    auto Hash_Line(std::string_view line, uint64_t hash) -> uint64_t;
+
+    /// Hashes a range of bytes, 8 bytes at a time
+    /// @param seed the starting hash, used to chain multiple ranges
+    auto Hash_Bytes(std::string_view bytes, uint64_t seed) -> uint64_t;
+
+    /// Returns the offset of every occurrence of byte in text, scanned 16 bytes at a time when SSE2 is available
+    auto Find_All_Bytes(std::string_view text, char byte) -> std::vector<size_t>;
+
+    /// Appends the offset of every occurrence of pattern in text into offsets, occurrences may overlap.
+    //  Candidates are filtered 16 at a time on the pattern's first and last byte, then verified.
+    void Find_Substrings(std::string_view text, std::string_view pattern, std::vector<size_t> *offsets);
+
     auto Path_To_String(const std::filesystem::path &path) -> std::string;
     auto String_To_Path(const std::string &utf8_string) -> std::filesystem::path;
 } /* namespace Utils */
\ No newline at end of file
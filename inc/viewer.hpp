@@ -0,0 +1,122 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace Editor {
+    struct Data;
+};
+
+
+/// Browses files too large to load, read-only, with the buffer only holding a window of lines around the cursor.
+//  A thread counts the lines of the whole file once and keeps the byte offset of every CHECKPOINT_LINES-th line,
+//  a jump to a line or a line number lookup scans from the nearest checkpoint before it.
+//  The file is only ever mapped a few megabytes at a time, so memory use does not grow with its size.
+namespace View {
+    /// The byte offset of every this many lines is kept
+    static const int64_t CHECKPOINT_LINES = 1024;
+
+    /// Lines held in the buffer at most
+    static const int64_t WINDOW_LINES = 4096;
+
+    /// Bytes of the file held in the buffer at most, so a file of long lines keeps a small window too
+    static const int64_t WINDOW_BYTES = 4 * 1024 * 1024;
+
+    /// The window is moved once the cursor comes this close to one of its ends
+    static const int64_t MARGIN_LINES = 512;
+
+    /// Longer lines are cut, only their start is shown
+    static const int64_t MAX_LINE_BYTES = 64 * 1024;
+
+    /// Bytes of the file mapped at once
+    static const int64_t MAP_BYTES = 16 * 1024 * 1024;
+
+    class
+    Viewer
+    {
+    public:
+        Viewer() = default;
+        ~Viewer();
+
+        Viewer(const Viewer&) = delete;
+        auto operator=(const Viewer&) -> Viewer& = delete;
+
+        /// Opens file_path, fills the buffer with its first lines and starts counting its lines
+        /// @param tab_size the amount of spaces that replace the \t character
+        /// @returns true on success or false on failure.
+        auto Open(Editor::Data *editor_data, int32_t tab_size) -> bool;
+
+        /// Moves the cursor to line, once the lines before it are counted
+        /// @param line 0-indexed, past the end of the file it goes to the last line
+        void Jump_To_Line(Editor::Data *editor_data, int64_t line);
+
+        /// Moves the cursor to the line holding the byte at offset
+        void Jump_To_Byte(Editor::Data *editor_data, int64_t offset);
+
+        /// Moves the cursor to the line holding the byte at percent of the file
+        void Jump_To_Percent(Editor::Data *editor_data, double percent);
+
+        /// Moves the window along with the cursor, numbers its lines once they are counted,
+        //  and makes a line jump once its line is counted. Should be called once per frame on the main thread.
+        /// @returns true if the buffer changed
+        auto Collect(Editor::Data *editor_data) -> bool;
+
+        /// The line number of the first line of the buffer, -1 until the lines before it are counted
+        [[nodiscard]]
+        auto Get_First_Line() const -> int64_t
+        { return m_first_line; }
+
+        /// The lines of the file counted so far
+        [[nodiscard]]
+        auto Get_Counted_Lines() -> int64_t;
+
+    private:
+        std::filesystem::path m_file_path;
+        int32_t m_fd = -1;
+        int64_t m_size = 0;
+        bool m_ends_with_break = false;
+        int32_t m_tab_size = 0;
+        std::thread m_thread;
+
+        /* Only touched by the main thread */
+        int64_t m_window_start = 0;
+        int64_t m_window_end = 0;
+        std::vector<int64_t> m_line_starts;
+        int64_t m_first_line = -1;
+        int64_t m_pending_line = -1;
+
+        /* Shared, under m_mutex */
+        std::mutex m_mutex;
+        std::vector<int64_t> m_checkpoints;
+        int64_t m_scanned_bytes = 0;
+        int64_t m_scanned_lines = 0;
+        bool m_is_scanned = false;
+        bool m_is_running = false;
+
+        /// Counts the lines of the file until its end or until stopped
+        void Scan_Loop();
+
+        /// Replaces the buffer with the lines from start on, start being the start of a line.
+        //  The window goes on at least until the line after the one starting at keep, so it can move past long lines.
+        void Load_Window(Editor::Data *editor_data, int64_t start, int64_t keep);
+
+        /// Loads the window around the line starting at line_start and moves the cursor onto it
+        void Move_To(Editor::Data *editor_data, int64_t line_start);
+
+        /// The start of the line count lines before the one starting at line_start, stopping early past WINDOW_BYTES / 2
+        //  but always going back one line if there is one
+        auto Find_Earlier_Line(int64_t line_start, int64_t count) -> int64_t;
+
+        /// The start of the line holding the byte at offset
+        auto Find_Line_Start(int64_t offset) -> int64_t;
+
+        /// The start of line, whose line break has to be counted already, or of the last line past the end
+        auto Find_Line(int64_t line) -> int64_t;
+
+        /// The line number of the line starting at line_start, or -1 if the lines before it are not counted yet
+        auto Find_Line_Number(int64_t line_start) -> int64_t;
+    };
+} /* namespace View */
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <cstdint>
+#include <thread>
+#include <string>
+#include <mutex>
+
+#include "codec.hpp"
+
+namespace Editor {
+    struct Data;
+};
+
+
+/// Follows the edited file on disk, or the stream the buffer is read from.
+//  A thread waits on inotify events of the file's directory, so a file replaced by a rename is seen too.
+//  When the file only grew, just the new bytes are read and appended to the buffer,
+//  any other change is told apart from a touch by a checksum of the content and reported once, :e! reloads it.
+//  A stream, like stdin, is read as its bytes arrive and appended the same way, a batch per frame.
+//  Streams go through a decoder first, so compressed input shows up as it is decompressed.
+namespace Watch {
+    /// Bytes before the known end of the file read again on every growth, to tell an append from a rewrite
+    static const size_t TAIL_BYTES = 4096;
+
+    /// A file changed in other ways than an append is only compared once it was left alone this long
+    static const int32_t SETTLE_MS = 100;
+
+    /// Bytes read at once when the whole file is checksummed
+    static const size_t READ_BYTES = 1024 * 1024;
+
+    /// Bytes appended to the buffer per frame at most, so a fast producer never stalls a frame
+    static const size_t BATCH_BYTES = 4 * 1024 * 1024;
+
+    /// A stream is not read further while this many bytes wait to be appended, which blocks its producer
+    static const size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+    class
+    Watcher
+    {
+    public:
+        Watcher() = default;
+        ~Watcher();
+
+        Watcher(const Watcher&) = delete;
+        auto operator=(const Watcher&) -> Watcher& = delete;
+
+        /// Starts watching file_path, whose content the buffer was just loaded from
+        /// @param tab_size the amount of spaces that replace the \t character of appended lines
+        /// @param version the version of the buffer that matches the file
+        /// @returns true on success or false on failure.
+        auto Start(const std::filesystem::path &file_path, int32_t tab_size, uint64_t version) -> bool;
+
+        /// Starts reading fd until its end, the buffer should be empty
+        /// @param tab_size the amount of spaces that replace the \t character of appended lines
+        /// @returns true on success or false on failure.
+        auto Start_Stream(int32_t fd, int32_t tab_size) -> bool;
+
+        /// Starts decompressing file_path as a stream, the buffer should be empty
+        /// @param tab_size the amount of spaces that replace the \t character of appended lines
+        /// @returns true on success or false on failure.
+        auto Start_Decoding(const std::filesystem::path &file_path, int32_t tab_size) -> bool;
+
+        /// Checks if the stream has not been read to its end, or its last lines are not in the buffer yet
+        [[nodiscard]]
+        auto Is_Loading() -> bool;
+
+        /// Keeps the cursor on the last line while lines are appended, like tail -f
+        void Set_Follow(bool is_following)
+        { m_is_following = is_following; }
+
+        [[nodiscard]]
+        auto Is_Following() const -> bool
+        { return m_is_following; }
+
+        /// Ignores changes to the file while the editor writes it itself, calls can be nested
+        void Pause();
+
+        /// Ends a Pause, and resyncs once the last one ends
+        void Resume(uint64_t version);
+
+        /// Takes the file as it now is on disk as the content of the buffer at version, after a save or a reload.
+        //  A stream has no file to resync with, it keeps being appended.
+        void Resync(uint64_t version);
+
+        /// Appends the lines added to the file since the last call if the buffer was not edited since it matched
+        //  the file, and reports any other change once. The lines of a stream are always appended.
+        //  Should be called on the main thread.
+        /// @returns true if the buffer changed
+        auto Collect(Editor::Data *editor_data) -> bool;
+
+    private:
+        /// What the watcher thread last read of the file
+        struct Snapshot {
+            uint64_t device = 0;
+            uint64_t inode = 0;
+            int64_t size = 0;
+            int64_t modified_ns = 0;
+            uint64_t checksum = 0;
+
+            /// The last TAIL_BYTES bytes of the file
+            std::string tail;
+
+            /// The bytes after the last line break, the unfinished last line
+            std::string partial;
+        };
+
+        std::filesystem::path m_file_path;
+        int32_t m_tab_size = 0;
+        int32_t m_stream_fd = -1;
+        bool m_owns_stream_fd = false;
+        int32_t m_inotify_fd = -1;
+        int32_t m_wake_fd = -1;
+        std::thread m_thread;
+
+        /* Only touched by the watcher thread */
+        Snapshot m_snapshot;
+        Codec::Decoder m_decoder;
+
+        /* Only touched by the main thread */
+        uint64_t m_synced_version = 0;
+        bool m_is_synced = true;
+        bool m_is_reported = false;
+        bool m_is_following = false;
+
+        /* Shared, under m_mutex */
+        std::mutex m_mutex;
+        std::string m_appended;
+        bool m_has_appended = false;
+        bool m_continues_line = false;
+        bool m_is_changed = false;
+        int32_t m_pauses = 0;
+        uint64_t m_generation = 0;
+        bool m_needs_snapshot = false;
+        bool m_is_running = false;
+        bool m_is_stream_done = false;
+        std::condition_variable m_drained;
+
+        /// Waits for inotify events until stopped
+        void Watch_Loop();
+
+        /// Reads the stream until its end or until stopped
+        void Stream_Loop();
+
+        /// Publishes bytes added after the last snapshot unless generation is outdated, and moves the snapshot past them
+        void Publish_Append(std::string_view added, uint64_t generation);
+
+        /// Reads the whole file, its checksum included
+        /// @returns false if the file could not be read
+        auto Read_Snapshot(int32_t fd, Snapshot *snapshot) -> bool;
+
+        /// Checks if the file only grew since the last snapshot, and publishes the new bytes unless generation is outdated
+        /// @returns false if the file changed in any other way
+        auto Check_Append(uint64_t generation) -> bool;
+
+        /// Compares the whole file with the last snapshot, and reports a change unless generation is outdated
+        void Check_Whole(uint64_t generation);
+
+        /// Drains inotify events until none came for SETTLE_MS, or until woken
+        void Wait_For_Quiet();
+
+        void Wake();
+        void Stop();
+    };
+} /* namespace Watch */
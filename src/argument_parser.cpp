@@ -5,6 +5,7 @@
 #include "../inc/logging_utility.hpp"
 #include "../inc/config_parser.hpp"
 #include "../inc/utilities.hpp"
+#include "../inc/recovery.hpp"
 
 #include "../inc/argument_parser.hpp"
 
@@ -24,7 +25,8 @@ ArgParser::ArgParser(int32_t argc, char **argv)
             continue;
         }
 
-        if (arg.starts_with('-')) {
+        /* A lone '-' is the stdin path, not an empty flag */
+        if (arg.starts_with('-') && arg != STDIN_PATH) {
             m_arg_list.at(0).emplace_back(false, arg.substr(1));
             previous_type = 0;
             continue;
@@ -146,7 +148,7 @@ ArgParser::Find_Option_Long(std::string &option, std::string_view long_arg) -> b
 
 
 auto
-ArgParser::Get_File_Path(ConfigParser *config, std::string &file_path) -> bool
+ArgParser::Get_File_Path(ConfigParser *config, std::string &file_path, bool *recover_swap) -> bool
 {
     if (!Option_Arg(file_path, { "-f", "--file" })) {;
         std::string back;
@@ -160,12 +162,16 @@ ArgParser::Get_File_Path(ConfigParser *config, std::string &file_path) -> bool
 
         if (back.empty()) {
             file_path = config->Get_Value("file", "new_file_name");
+            *recover_swap = Check_Swap_File(file_path);
             return true;
         }
 
         file_path = back;
     }
 
+    /* stdin is neither created nor recovered, it has no file */
+    if (file_path == STDIN_PATH) return true;
+
     if (!Utils::Is_Valid_File(file_path)) {
         std::filesystem::path path = file_path;
 
@@ -176,11 +182,26 @@ ArgParser::Get_File_Path(ConfigParser *config, std::string &file_path) -> bool
         out_file << "";
     }
 
+    *recover_swap = Check_Swap_File(file_path);
+
     std::ifstream in_file(file_path);
     return in_file.peek() == std::ifstream::traits_type::eof();
 }
 
 
+auto
+ArgParser::Check_Swap_File(const std::string &file_path) -> bool
+{
+    std::filesystem::path swap_path = Recovery::Swap_Path(file_path);
+    if (!Utils::Is_Valid_File(swap_path.string())) return false;
+
+    if (Recovery::Prompt_Recovery(swap_path)) return true;
+
+    std::filesystem::remove(swap_path);
+    return false;
+}
+
+
 auto
 ArgParser::Back() -> std::string
 {
@@ -205,7 +226,7 @@ ArgParser::Print_Help_Message(FILE *stream)
 {
     std::println(stream, "{}c+text{}, A Simple Text Editor", Color::Bold_White, Color::Reset);
     std::println(stream, "┌──");
-    std::println(stream, "├─{}Usage{}: c+text [options] [file path]", Color::Bold_White, Color::Reset);
+    std::println(stream, "├─{}Usage{}: c+text [options] [file path, or - for stdin]", Color::Bold_White, Color::Reset);
     std::println(stream, "│");
     std::println(stream, "├─{}Options{}:", Color::Bold_White, Color::Reset);
     std::println(stream, "│      {}-h,--help{}                show this message", Color::Bold_White, Color::Reset);
@@ -213,6 +234,8 @@ ArgParser::Print_Help_Message(FILE *stream)
     std::println(stream, "│      {}-f,--file{}                specifies the file path", Color::Bold_White, Color::Reset);
     std::println(stream, "│      {}-c,--config{}              specifies the config path", Color::Bold_White, Color::Reset);
     std::println(stream, "│      {}-d,--debug{}               provides more logs", Color::Bold_White, Color::Reset);
+    std::println(stream, "│      {}-R,--view{}                opens the file read-only in the viewer", Color::Bold_White, Color::Reset);
+    std::println(stream, "│      {}-b,--bench-load{}          times loading a file on 1 to N workers, then exits", Color::Bold_White, Color::Reset);
     std::println(stream, "│");
     std::println(stream, "╰─{}Version format{}:", Color::Bold_White, Color::Reset);
     std::println(stream, "    {}X{}.{}Y{}.{}Z{}", Color::Bold_Green, Color::Bold_White, Color::Bold_Yellow, Color::Bold_White, Color::Bold_Red, Color::Reset);
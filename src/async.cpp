@@ -0,0 +1,54 @@
+#include "../inc/logging_utility.hpp"
+#include "../inc/bulk_io.hpp"
+
+#include "../inc/async.hpp"
+
+
+void
+Async::Spawn(Task<void> task)
+{
+    std::coroutine_handle<Promise<void>> handle = task.Release();
+    handle.promise().is_detached = true;
+    handle.resume();
+}
+
+
+auto
+Async::Read_File(std::filesystem::path file_path) -> Pool_Awaiter<std::optional<std::string>>
+{
+    return On_Pool([file_path = std::move(file_path)]() -> std::optional<std::string> {
+        std::string text;
+        if (!Bulk_IO::Read_File(file_path, &text)) {
+            Log::Err("Failed to read file: {}", file_path.string());
+            return std::nullopt;
+        }
+        return text;
+    });
+}
+
+
+auto
+Async::Write_File(
+    std::filesystem::path file_path,
+    std::string text,
+    Codec::Format format,
+    Tasks::Group *group
+) -> Pool_Awaiter<bool>
+{
+    return On_Pool([file_path = std::move(file_path), text = std::move(text), format]() mutable {
+        std::error_code error;
+        if (file_path.has_parent_path()) std::filesystem::create_directories(file_path.parent_path(), error);
+
+        if (format != Codec::Plain) {
+            std::string compressed;
+            if (!Codec::Compress(format, text, &compressed)) return false;
+            text = std::move(compressed);
+        }
+
+        if (!Bulk_IO::Write_File(file_path, text)) {
+            Log::Err("Failed to write to file: {}", file_path.string());
+            return false;
+        }
+        return true;
+    }, Tasks::Interactive, group);
+}
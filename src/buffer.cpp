@@ -0,0 +1,290 @@
+#include <shared_mutex>
+#include <algorithm>
+
+#include "../inc/logging_utility.hpp"
+#include "../inc/editor.hpp"
+
+#include "../inc/buffer.hpp"
+
+
+namespace {
+    /// Appends the text between start and end to text
+    void
+    Append_Text(const std::vector<std::string> &content, Position start, Position end, std::string *text)
+    {
+        if (start.y == end.y) {
+            text->append(content.at(start.y), start.x, end.x - start.x);
+            return;
+        }
+
+        text->append(content.at(start.y), start.x);
+        for (int64_t y = start.y + 1; y < end.y; y++) {
+            *text += '\n';
+            *text += content.at(y);
+        }
+        *text += '\n';
+        text->append(content.at(end.y), 0, end.x);
+    }
+
+
+    /// The span between start and end, in bytes, counting newlines
+    auto
+    Text_Length(const std::vector<std::string> &content, Position start, Position end) -> size_t
+    {
+        if (start.y == end.y) return end.x - start.x;
+
+        size_t length = content.at(start.y).length() - start.x + end.x + 1;
+        for (int64_t y = start.y + 1; y < end.y; y++) length += content.at(y).length() + 1;
+        return length;
+    }
+
+
+    /// Checks if applying edits one by one would move the same text again and again:
+    //  an edit adding or removing lines shifts every line after it, edits sharing a line rewrite the rest of it
+    auto
+    Is_Dense(const std::vector<Buffer::Edit> &edits) -> bool
+    {
+        for (size_t i = 0; i < edits.size(); i++) {
+            const Buffer::Edit &edit = edits.at(i);
+            if (edit.start.y != edit.end.y || edit.text.find('\n') != std::string_view::npos) return true;
+            if (i > 0 && edit.start.y == edits.at(i - 1).end.y) return true;
+        }
+        return false;
+    }
+} /* Anonymous namespace */
+
+
+namespace Buffer {
+    auto
+    Insert_Text(std::vector<std::string> &content, Position position, std::string_view text) -> Position
+    {
+        std::string &line = content.at(position.y);
+
+        std::vector<size_t> newlines = Utils::Find_All_Bytes(text, '\n');
+        if (newlines.empty()) {
+            line.insert(position.x, text);
+            return { position.x + static_cast<int64_t>(text.length()), position.y };
+        }
+
+        std::string tail = line.substr(position.x);
+        line.erase(position.x);
+        line.append(text.substr(0, newlines.front()));
+
+        /* Builds every new line first so the vector only shifts once */
+        std::vector<std::string> inserted_lines;
+        inserted_lines.reserve(newlines.size());
+        for (size_t i = 1; i < newlines.size(); i++) {
+            size_t begin = newlines.at(i - 1) + 1;
+            inserted_lines.emplace_back(text.substr(begin, newlines.at(i) - begin));
+        }
+        inserted_lines.emplace_back(text.substr(newlines.back() + 1));
+
+        Position end = {
+            static_cast<int64_t>(inserted_lines.back().length()),
+            position.y + static_cast<int64_t>(inserted_lines.size())
+        };
+        inserted_lines.back().append(tail);
+
+        content.insert(
+            content.begin() + position.y + 1,
+            std::make_move_iterator(inserted_lines.begin()),
+            std::make_move_iterator(inserted_lines.end())
+        );
+        return end;
+    }
+
+
+    auto
+    Erase_Text(std::vector<std::string> &content, Position start, Position end) -> std::string
+    {
+        std::string &first_line = content.at(start.y);
+
+        if (start.y == end.y) {
+            std::string erased = first_line.substr(start.x, end.x - start.x);
+            first_line.erase(start.x, end.x - start.x);
+            return erased;
+        }
+
+        std::string erased = first_line.substr(start.x);
+        for (int64_t y = start.y + 1; y < end.y; y++) {
+            erased += '\n';
+            erased += content.at(y);
+        }
+        erased += '\n';
+        erased += content.at(end.y).substr(0, end.x);
+
+        first_line.erase(start.x);
+        first_line.append(content.at(end.y).substr(end.x));
+
+        content.erase(content.begin() + start.y + 1, content.begin() + end.y + 1);
+        return erased;
+    }
+
+
+    auto
+    Get_Text(const std::vector<std::string> &content, Position start, Position end) -> std::string
+    {
+        std::string text;
+        text.reserve(Text_Length(content, start, end));
+        Append_Text(content, start, end, &text);
+        return text;
+    }
+
+
+    auto
+    Apply_Insert(Editor::Data *editor_data, Position position, std::string_view text) -> Position
+    {
+        /* Only the rewritten line is thawed, the chunks after it move with their lines */
+        editor_data->cold.Thaw(editor_data, position.y, position.y);
+        editor_data->registers.Before_Insert(editor_data->file_content, position, text);
+        if (editor_data->swap != nullptr) editor_data->swap->Record_Insert(position, text);
+
+        std::unique_lock lock(editor_data->content_mutex);
+        editor_data->version++;
+        Position end = Insert_Text(editor_data->file_content, position, text);
+
+        if (editor_data->trigrams != nullptr) editor_data->trigrams->After_Edit(position.y, end.y, end.y - position.y);
+        editor_data->syntax.After_Edit(position.y, end.y, end.y - position.y);
+        editor_data->cold.After_Edit(editor_data, position.y, end.y, end.y - position.y);
+        return end;
+    }
+
+
+    auto
+    Apply_Erase(Editor::Data *editor_data, Position start, Position end) -> std::string
+    {
+        editor_data->cold.Thaw(editor_data, start.y, end.y);
+        editor_data->registers.Before_Erase(editor_data->file_content, start, end);
+        if (editor_data->swap != nullptr) editor_data->swap->Record_Erase(start, end);
+
+        std::unique_lock lock(editor_data->content_mutex);
+        editor_data->version++;
+        std::string erased = Erase_Text(editor_data->file_content, start, end);
+
+        if (editor_data->trigrams != nullptr) editor_data->trigrams->After_Edit(start.y, start.y, start.y - end.y);
+        editor_data->syntax.After_Edit(start.y, start.y, start.y - end.y);
+        editor_data->cold.After_Edit(editor_data, start.y, start.y, start.y - end.y);
+        return erased;
+    }
+
+
+    auto
+    Is_Read_Only(Editor::Data *editor_data) -> bool
+    {
+        if (editor_data->viewer == nullptr) return false;
+
+        Log::Err("{} is open read-only in the viewer", editor_data->file_path.string());
+        return true;
+    }
+
+
+    auto
+    Insert(Editor::Data *editor_data, Position position, std::string_view text) -> Position
+    {
+        if (text.empty() || Is_Read_Only(editor_data)) return position;
+
+        Position end = Apply_Insert(editor_data, position, text);
+        editor_data->history.Record_Insert(position, end, text);
+        return end;
+    }
+
+
+    auto
+    Erase(Editor::Data *editor_data, Position start, Position end) -> std::string
+    {
+        if ((start.y == end.y && start.x >= end.x) || Is_Read_Only(editor_data)) return "";
+
+        std::string erased = Apply_Erase(editor_data, start, end);
+        editor_data->history.Record_Erase(start, end, erased);
+        return erased;
+    }
+
+
+    auto
+    Replace_All(Editor::Data *editor_data, const std::vector<Edit> &edits) -> std::vector<Position>
+    {
+        std::vector<Position> ends(edits.size());
+        if (edits.empty()) return ends;
+
+        /* Nothing moves in a read-only buffer, every edit ends where it starts */
+        if (Is_Read_Only(editor_data)) {
+            std::ranges::transform(edits, ends.begin(), [](const Edit &edit) { return edit.start; });
+            return ends;
+        }
+
+        /* Clips overlapping edits, so that no edit touches text an earlier one replaced */
+        std::vector<Position> starts(edits.size());
+        for (size_t i = 0; i < edits.size(); i++) {
+            starts.at(i) = edits.at(i).start;
+            if (i > 0 && starts.at(i).Is_Before(edits.at(i - 1).end)) starts.at(i) = edits.at(i - 1).end;
+        }
+
+        editor_data->history.Begin_Group(editor_data->cursor);
+        /* Edits on lines of their own, such as typing at many cursors, stay as small as they are in the history */
+        if (edits.size() < BATCH_EDITS || !Is_Dense(edits)) {
+            for (size_t i = edits.size(); i-- > 0;) {
+                Position start = starts.at(i);
+                Position end = edits.at(i).end;
+                if (end.Is_Before(start)) end = start;
+
+                Erase(editor_data, start, end);
+                Insert(editor_data, start, edits.at(i).text);
+            }
+        } else {
+            /* The new text of the whole span is built front to back, then replaces the span in one go */
+            const std::vector<std::string> &content = editor_data->file_content;
+            Position first = starts.front();
+            Position last = first;
+
+            /* Only the lines of the span are read, an edit overlapping the next one may end the furthest */
+            int64_t last_line = std::ranges::max(edits, {}, [](const Edit &edit) { return edit.end.y; }).end.y;
+            editor_data->cold.Thaw(editor_data, first.y, last_line);
+
+            size_t length = 0;
+            for (size_t i = 0; i < edits.size(); i++) {
+                length += Text_Length(content, last, starts.at(i)) + edits.at(i).text.length();
+                last = std::max(edits.at(i).end, starts.at(i), [](Position a, Position b) { return a.Is_Before(b); });
+            }
+
+            std::string text;
+            text.reserve(length);
+            Position at = first;
+            for (size_t i = 0; i < edits.size(); i++) {
+                Append_Text(content, at, starts.at(i), &text);
+                text += edits.at(i).text;
+                at = std::max(edits.at(i).end, starts.at(i), [](Position a, Position b) { return a.Is_Before(b); });
+            }
+
+            Erase(editor_data, first, last);
+            Insert(editor_data, first, text);
+        }
+
+        /* Edits only move the text after them: a line shift, and a column shift on the line they end on */
+        int64_t line_shift = 0;
+        int64_t shifted_line = -1;
+        int64_t column_shift = 0;
+
+        for (size_t i = 0; i < edits.size(); i++) {
+            Position start = starts.at(i);
+            Position end = std::max(edits.at(i).end, start, [](Position a, Position b) { return a.Is_Before(b); });
+            std::string_view text = edits.at(i).text;
+
+            Position moved = { start.x + (start.y == shifted_line ? column_shift : 0), start.y + line_shift };
+            size_t newline = text.rfind('\n');
+
+            if (newline == std::string_view::npos) {
+                ends.at(i) = { moved.x + static_cast<int64_t>(text.length()), moved.y };
+            } else {
+                auto lines = static_cast<int64_t>(std::ranges::count(text, '\n'));
+                ends.at(i) = { static_cast<int64_t>(text.length() - newline - 1), moved.y + lines };
+            }
+
+            line_shift = ends.at(i).y - end.y;
+            shifted_line = end.y;
+            column_shift = ends.at(i).x - end.x;
+        }
+
+        editor_data->history.End_Group(ends.front());
+        return ends;
+    }
+} /* namespace Buffer */
\ No newline at end of file
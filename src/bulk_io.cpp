@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <mutex>
+
+#if __unix__
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <cerrno>
+#endif
+
+#if HAVE_LIBURING
+#   include <liburing.h>
+#endif
+
+#include "../inc/bulk_io.hpp"
+
+
+namespace {
+    struct Last_Transfers {
+        std::mutex mutex;
+        Bulk_IO::Transfer read;
+        Bulk_IO::Transfer write;
+    };
+
+
+    auto
+    Get_Last_Transfers() -> Last_Transfers&
+    {
+        static Last_Transfers last_transfers;
+        return last_transfers;
+    }
+
+
+    void
+    Record(bool is_write, size_t bytes, std::chrono::steady_clock::time_point start, const char *backend)
+    {
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        Last_Transfers &last_transfers = Get_Last_Transfers();
+
+        std::lock_guard lock(last_transfers.mutex);
+        (is_write ? last_transfers.write : last_transfers.read) = { bytes, seconds.count(), backend };
+    }
+
+
+#if HAVE_LIBURING
+    /// A block of the buffer being read or written by one request
+    struct Block {
+        size_t offset;
+        size_t length;
+    };
+
+
+    /// Transfers length bytes between data and fd, starting at offset 0, with up to QUEUE_DEPTH requests in flight
+    /// @returns the bytes transferred, fewer than length only if a read reached the end of the file, or -1 on failure
+    auto
+    Uring_Transfer(int fd, char *data, size_t length, bool is_write) -> int64_t
+    {
+        io_uring ring = {};
+        if (io_uring_queue_init(Bulk_IO::QUEUE_DEPTH, &ring, 0) < 0) return -1;
+
+        /* A registered buffer stays pinned, so the kernel does not map its pages again for every request */
+        iovec buffer = { data, length };
+        bool is_registered = (io_uring_register_buffers(&ring, &buffer, 1) == 0);
+
+        auto queue = [&](Block *block) {
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            char *address = data + block->offset;
+            auto count = static_cast<uint32_t>(block->length);
+
+            if (is_write && is_registered) io_uring_prep_write_fixed(sqe, fd, address, count, block->offset, 0);
+            else if (is_write) io_uring_prep_write(sqe, fd, address, count, block->offset);
+            else if (is_registered) io_uring_prep_read_fixed(sqe, fd, address, count, block->offset, 0);
+            else io_uring_prep_read(sqe, fd, address, count, block->offset);
+            io_uring_sqe_set_data(sqe, block);
+        };
+
+        std::vector<Block> blocks(Bulk_IO::QUEUE_DEPTH);
+        std::vector<Block*> idle;
+        for (auto &block : blocks) idle.push_back(&block);
+
+        size_t next = 0;
+        size_t end = length;
+        size_t in_flight = 0;
+        bool is_failed = false;
+        bool is_submit_failed = false;
+
+        for (;;) {
+            while (!is_failed && !idle.empty() && next < end) {
+                Block *block = idle.back();
+                idle.pop_back();
+                *block = { next, std::min<size_t>(end - next, Bulk_IO::BLOCK_BYTES) };
+                next += block->length;
+                queue(block);
+                in_flight++;
+            }
+
+            /* Requests still in flight write into data, so a failure waits for them before returning */
+            if (in_flight == 0) break;
+
+            /* Once submitting failed, the requests the kernel took are only waited for, the ones it did not take never run */
+            io_uring_cqe *waited = nullptr;
+            int result = (is_submit_failed ? io_uring_wait_cqe(&ring, &waited) : io_uring_submit_and_wait(&ring, 1));
+            if (result < 0 && result != -EINTR && result != -EAGAIN) {
+                /* Waiting itself failed, the ring cannot report anything anymore */
+                if (is_submit_failed) break;
+
+                is_failed = true;
+                is_submit_failed = true;
+                in_flight -= io_uring_sq_ready(&ring);
+                continue;
+            }
+
+            unsigned head = 0;
+            unsigned seen = 0;
+            io_uring_cqe *cqe = nullptr;
+            io_uring_for_each_cqe(&ring, head, cqe) {
+                seen++;
+                auto *block = static_cast<Block*>(io_uring_cqe_get_data(cqe));
+
+                if (!is_submit_failed && (cqe->res == -EINTR || cqe->res == -EAGAIN)) {
+                    queue(block);
+                    continue;
+                }
+
+                /* Short transfers are asked for again from where they stopped, reads past the end return 0 */
+                if (cqe->res > 0) {
+                    block->offset += static_cast<size_t>(cqe->res);
+                    block->length -= static_cast<size_t>(cqe->res);
+                } else if (cqe->res < 0 || is_write) {
+                    is_failed = true;
+                } else {
+                    end = std::min(end, block->offset);
+                }
+
+                if (!is_failed && block->length > 0 && block->offset < end) {
+                    queue(block);
+                    continue;
+                }
+                in_flight--;
+                idle.push_back(block);
+            }
+            io_uring_cq_advance(&ring, seen);
+        }
+
+        if (is_registered) io_uring_unregister_buffers(&ring);
+        io_uring_queue_exit(&ring);
+        return (is_failed ? -1 : static_cast<int64_t>(std::min(end, next)));
+    }
+#endif
+
+
+#if __unix__
+    /// Transfers length bytes between data and fd, starting at offset 0, with blocking calls
+    /// @returns the bytes transferred, fewer than length only if a read reached the end of the file, or -1 on failure
+    auto
+    Blocking_Transfer(int fd, char *data, size_t length, bool is_write) -> int64_t
+    {
+        size_t done = 0;
+        while (done < length) {
+            auto offset = static_cast<off_t>(done);
+            ssize_t result = (is_write ?
+                pwrite(fd, data + done, length - done, offset) :
+                pread(fd, data + done, length - done, offset)
+            );
+
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0 || (result == 0 && is_write)) return -1;
+            if (result == 0) break;
+            done += static_cast<size_t>(result);
+        }
+        return static_cast<int64_t>(done);
+    }
+
+
+    /// Picks io_uring for large transfers and falls back to blocking calls
+    auto
+    Run_Transfer(int fd, char *data, size_t length, bool is_write, const char **backend) -> int64_t
+    {
+#if HAVE_LIBURING
+        if (length >= Bulk_IO::URING_BYTES && Bulk_IO::Has_Uring()) {
+            int64_t result = Uring_Transfer(fd, data, length, is_write);
+            if (result >= 0) {
+                *backend = "io_uring";
+                return result;
+            }
+        }
+#endif
+        *backend = "blocking";
+        return Blocking_Transfer(fd, data, length, is_write);
+    }
+#endif
+} /* Anonymous namespace */
+
+
+auto
+Bulk_IO::Has_Uring() -> bool
+{
+#if HAVE_LIBURING
+    static const bool has_uring = [] {
+        io_uring ring = {};
+        if (io_uring_queue_init(1, &ring, 0) < 0) return false;
+        io_uring_queue_exit(&ring);
+        return true;
+    }();
+    return has_uring;
+#else
+    return false;
+#endif
+}
+
+
+auto
+Bulk_IO::Read_File(const std::filesystem::path &file_path, std::string *text) -> bool
+{
+    auto start = std::chrono::steady_clock::now();
+
+#if __unix__
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat status = {};
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return false;
+    }
+
+    /* The buffer is handed over unfilled, a file that shrank meanwhile just ends up shorter */
+    int64_t result = 0;
+    const char *backend = "blocking";
+    text->resize_and_overwrite(static_cast<size_t>(status.st_size), [&](char *data, size_t length) {
+        result = Run_Transfer(fd, data, length, false, &backend);
+        return static_cast<size_t>(std::max<int64_t>(result, 0));
+    });
+    close(fd);
+
+    if (result < 0) return false;
+    Record(false, text->length(), start, backend);
+    return true;
+#else
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    text->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (file.bad()) return false;
+
+    Record(false, text->length(), start, "stream");
+    return true;
+#endif
+}
+
+
+auto
+Bulk_IO::Write_File(const std::filesystem::path &file_path, std::string_view text) -> bool
+{
+    auto start = std::chrono::steady_clock::now();
+
+#if __unix__
+    int fd = open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+
+    /* Writes only read from the buffer, registering it needs a mutable pointer all the same */
+    const char *backend = "blocking";
+    int64_t result = Run_Transfer(fd, const_cast<char*>(text.data()), text.length(), true, &backend);
+
+    if (close(fd) != 0 || result != static_cast<int64_t>(text.length())) return false;
+    Record(true, text.length(), start, backend);
+    return true;
+#else
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file.write(text.data(), static_cast<std::streamsize>(text.length()));
+    file.close();
+    if (!file) return false;
+
+    Record(true, text.length(), start, "stream");
+    return true;
+#endif
+}
+
+
+auto
+Bulk_IO::Get_Last_Read() -> Transfer
+{
+    Last_Transfers &last_transfers = Get_Last_Transfers();
+    std::lock_guard lock(last_transfers.mutex);
+    return last_transfers.read;
+}
+
+
+auto
+Bulk_IO::Get_Last_Write() -> Transfer
+{
+    Last_Transfers &last_transfers = Get_Last_Transfers();
+    std::lock_guard lock(last_transfers.mutex);
+    return last_transfers.write;
+}
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <fstream>
+#include <array>
+
+#if HAVE_ZLIB
+#   include <zlib.h>
+#endif
+
+#if HAVE_ZSTD
+#   include <zstd.h>
+#endif
+
+#include "../inc/logging_utility.hpp"
+
+#include "../inc/codec.hpp"
+
+using Codec::Decoder;
+
+
+namespace {
+    const std::array<unsigned char, 2> GZIP_MAGIC = { 0x1f, 0x8b };
+    const std::array<unsigned char, 4> ZSTD_MAGIC = { 0x28, 0xb5, 0x2f, 0xfd };
+
+    /// Compression level of saved gzip files, the one gzip itself defaults to
+    const int GZIP_LEVEL = 6;
+
+    /// Compression level of saved zstd files, the one zstd itself defaults to
+    const int ZSTD_LEVEL = 3;
+
+    /// Compression levels of text kept in memory, gzip's fastest and one of zstd's fast levels
+    const int GZIP_FAST_LEVEL = 1;
+    const int ZSTD_FAST_LEVEL = -1;
+
+    /// Bytes handed to zlib per call, which counts them in 32 bits
+    const size_t SLICE_BYTES = 1024 * 1024 * 1024;
+
+
+    template<size_t SIZE>
+    auto
+    Starts_With(std::string_view head, const std::array<unsigned char, SIZE> &magic) -> bool
+    {
+        if (head.length() < SIZE) return false;
+        for (size_t index = 0; index < SIZE; index++) {
+            if (static_cast<unsigned char>(head[index]) != magic[index]) return false;
+        }
+        return true;
+    }
+} /* Anonymous namespace */
+
+
+struct Decoder::State {
+#if HAVE_ZLIB
+    z_stream zlib = {};
+    bool has_zlib = false;
+#endif
+#if HAVE_ZSTD
+    ZSTD_DStream *zstd = nullptr;
+#endif
+
+    /// The stream stopped in the middle of a gzip member or zstd frame
+    bool is_inside_frame = false;
+
+    ~State()
+    {
+#if HAVE_ZLIB
+        if (has_zlib) inflateEnd(&zlib);
+#endif
+#if HAVE_ZSTD
+        if (zstd != nullptr) ZSTD_freeDStream(zstd);
+#endif
+    }
+};
+
+
+auto
+Codec::Detect(std::string_view head) -> Format
+{
+    if (Starts_With(head, ZSTD_MAGIC)) return Zstd;
+    if (Starts_With(head, GZIP_MAGIC)) return Gzip;
+    return Plain;
+}
+
+
+auto
+Codec::Detect_File(const std::filesystem::path &file_path) -> Format
+{
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) return Plain;
+
+    std::array<char, MAGIC_BYTES> head = {};
+    file.read(head.data(), head.size());
+    Format format = Detect(std::string_view(head.data(), static_cast<size_t>(file.gcount())));
+
+    if (!Is_Supported(format)) {
+        Log::Err("{} is {} compressed, which this build cannot read, showing it as is", file_path.string(), Get_Name(format));
+        return Plain;
+    }
+    return format;
+}
+
+
+auto
+Codec::Is_Supported(Format format) -> bool
+{
+    switch (format) {
+    case Plain: return true;
+#if HAVE_ZLIB
+    case Gzip: return true;
+#endif
+#if HAVE_ZSTD
+    case Zstd: return true;
+#endif
+    default: return false;
+    }
+}
+
+
+auto
+Codec::Get_Name(Format format) -> const char*
+{
+    switch (format) {
+    case Plain: return "plain";
+    case Gzip: return "gzip";
+    case Zstd: return "zstd";
+    }
+    return "unknown";
+}
+
+
+auto
+Codec::Compress(Format format, std::string_view text, std::string *output, bool is_fast) -> bool
+{
+    output->clear();
+
+    switch (format) {
+    case Plain:
+        output->assign(text);
+        return true;
+
+    case Gzip: {
+#if HAVE_ZLIB
+        /* 16 added to the window bits asks for a gzip header and trailer instead of a zlib one */
+        z_stream zlib = {};
+        if (deflateInit2(&zlib, (is_fast ? GZIP_FAST_LEVEL : GZIP_LEVEL), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) break;
+
+        /* zlib counts the bytes of one call in 32 bits, larger texts are fed in slices */
+        int result = Z_OK;
+        size_t done = 0;
+        while (result == Z_OK) {
+            size_t slice = std::min<size_t>(text.length() - done, SLICE_BYTES);
+            bool is_last = (done + slice == text.length());
+            zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data() + done));
+            zlib.avail_in = static_cast<uInt>(slice);
+            done += slice;
+
+            do {
+                size_t start = output->length();
+                output->resize(start + OUTPUT_BYTES);
+                zlib.next_out = reinterpret_cast<Bytef*>(output->data() + start);
+                zlib.avail_out = static_cast<uInt>(OUTPUT_BYTES);
+
+                result = deflate(&zlib, (is_last ? Z_FINISH : Z_NO_FLUSH));
+                output->resize(start + OUTPUT_BYTES - zlib.avail_out);
+            } while (result == Z_OK && zlib.avail_out == 0);
+
+            if (is_last && result == Z_OK) result = Z_BUF_ERROR;
+        }
+        deflateEnd(&zlib);
+        if (result == Z_STREAM_END) return true;
+#endif
+        break;
+    }
+
+    case Zstd: {
+#if HAVE_ZSTD
+        output->resize(ZSTD_compressBound(text.length()));
+        size_t length = ZSTD_compress(output->data(), output->length(), text.data(), text.length(), (is_fast ? ZSTD_FAST_LEVEL : ZSTD_LEVEL));
+        if (!ZSTD_isError(length)) {
+            output->resize(length);
+            return true;
+        }
+#endif
+        break;
+    }
+    }
+
+    output->clear();
+    Log::Err("Failed to compress the text as {}", Get_Name(format));
+    return false;
+}
+
+
+Decoder::Decoder()
+    : m_state(std::make_unique<State>())
+{}
+
+
+Decoder::~Decoder() = default;
+
+
+auto
+Decoder::Decode(std::string_view input, std::string *output) -> bool
+{
+    if (m_is_detected) return Decode_Detected(input, output);
+
+    /* Nothing is decoded before enough bytes came to tell the formats apart */
+    m_head.append(input);
+    if (m_head.length() < MAGIC_BYTES) return true;
+
+    m_is_detected = true;
+    m_format = Detect(m_head);
+    if (!Is_Supported(m_format)) {
+        Log::Err("The input is {} compressed, which this build cannot read, showing it as is", Get_Name(m_format));
+        m_format = Plain;
+    }
+
+    std::string head = std::move(m_head);
+    m_head.clear();
+    return Decode_Detected(head, output);
+}
+
+
+auto
+Decoder::Finish(std::string *output) -> bool
+{
+    if (!m_is_detected) {
+        m_is_detected = true;
+        output->append(m_head);
+        m_head.clear();
+        return true;
+    }
+
+    if (m_state->is_inside_frame) {
+        Log::Err("The {} input ended in the middle of its data, it was cut short", Get_Name(m_format));
+        return false;
+    }
+    return true;
+}
+
+
+auto
+Decoder::Decode_Detected(std::string_view input, std::string *output) -> bool
+{
+    if (m_format == Plain) {
+        output->append(input);
+        return true;
+    }
+
+#if HAVE_ZLIB
+    if (m_format == Gzip) {
+        z_stream &zlib = m_state->zlib;
+        if (!m_state->has_zlib) {
+            /* 32 added to the window bits detects the gzip header itself */
+            if (inflateInit2(&zlib, 15 + 32) != Z_OK) {
+                Log::Err("Failed to start decompressing the gzip input");
+                return false;
+            }
+            m_state->has_zlib = true;
+        }
+
+        if (input.length() > SLICE_BYTES) {
+            return Decode_Detected(input.substr(0, SLICE_BYTES), output) &&
+                Decode_Detected(input.substr(SLICE_BYTES), output);
+        }
+
+        zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        zlib.avail_in = static_cast<uInt>(input.length());
+
+        while (zlib.avail_in > 0) {
+            size_t start = output->length();
+            output->resize(start + OUTPUT_BYTES);
+            zlib.next_out = reinterpret_cast<Bytef*>(output->data() + start);
+            zlib.avail_out = static_cast<uInt>(OUTPUT_BYTES);
+
+            int result = inflate(&zlib, Z_NO_FLUSH);
+            output->resize(start + OUTPUT_BYTES - zlib.avail_out);
+            m_state->is_inside_frame = (result != Z_STREAM_END);
+
+            if (result == Z_STREAM_END) {
+                /* Concatenated members, as written by appending to a .gz file, follow right after */
+                inflateReset(&zlib);
+            } else if (result != Z_OK) {
+                Log::Err("The gzip input is corrupt: {}", (zlib.msg != nullptr ? zlib.msg : "unknown error"));
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+#if HAVE_ZSTD
+    if (m_format == Zstd) {
+        if (m_state->zstd == nullptr) {
+            m_state->zstd = ZSTD_createDStream();
+            if (m_state->zstd == nullptr) {
+                Log::Err("Failed to start decompressing the zstd input");
+                return false;
+            }
+        }
+
+        ZSTD_inBuffer in = { input.data(), input.length(), 0 };
+        while (in.pos < in.size) {
+            size_t start = output->length();
+            output->resize(start + OUTPUT_BYTES);
+            ZSTD_outBuffer out = { output->data() + start, OUTPUT_BYTES, 0 };
+
+            /* Returns 0 once a frame is complete, the next frame then starts on its own */
+            size_t result = ZSTD_decompressStream(m_state->zstd, &out, &in);
+            output->resize(start + out.pos);
+
+            if (ZSTD_isError(result)) {
+                Log::Err("The zstd input is corrupt: {}", ZSTD_getErrorName(result));
+                return false;
+            }
+            m_state->is_inside_frame = (result != 0);
+        }
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+
+auto
+Codec::Decode_All(std::string_view input, std::string *output) -> bool
+{
+    output->clear();
+    Decoder decoder;
+    return decoder.Decode(input, output) && decoder.Finish(output);
+}
@@ -0,0 +1,391 @@
+#include <shared_mutex>
+#include <algorithm>
+
+#include "../inc/logging_utility.hpp"
+#include "../inc/editor.hpp"
+
+#include "../inc/cold.hpp"
+
+using Cold::Reader;
+using Cold::Store;
+using Cold::Lines;
+using Clock = std::chrono::steady_clock;
+
+
+namespace {
+    /// Decompresses blob and splits it back into its lines, which never hold a line break
+    auto
+    Decode_Lines(std::string_view blob) -> std::vector<std::string>
+    {
+        std::string text;
+        if (!Codec::Decode_All(blob, &text)) return {};
+
+        std::vector<std::string> lines;
+        size_t start = 0;
+        for (size_t end = text.find('\n'); end != std::string::npos; end = text.find('\n', start)) {
+            lines.emplace_back(text, start, end - start);
+            start = end + 1;
+        }
+        lines.emplace_back(text, start);
+        return lines;
+    }
+} /* Anonymous namespace */
+
+
+Store::~Store()
+{ Stop(); }
+
+
+void
+Store::Stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_running = false;
+    }
+    m_jobs.Wait();
+}
+
+
+void
+Store::Start(int64_t budget_bytes)
+{
+    Stop();
+
+    /* zstd's fast levels decompress several times quicker than gzip, which is only the fallback */
+    if (Codec::Is_Supported(Codec::Zstd)) m_format = Codec::Zstd;
+    else if (Codec::Is_Supported(Codec::Gzip)) m_format = Codec::Gzip;
+    else m_format = Codec::Plain;
+
+    if (m_format == Codec::Plain) {
+        Log::Err("This build has neither zstd nor zlib, every line is kept uncompressed");
+        return;
+    }
+
+    m_budget_bytes = budget_bytes;
+    std::lock_guard lock(m_mutex);
+    m_is_running = true;
+}
+
+
+
+
+auto
+Store::Find_Chunk(int64_t line) const -> size_t
+{
+    auto found = std::ranges::upper_bound(m_chunks, line, {}, &Chunk::start);
+    return static_cast<size_t>(std::max(found - m_chunks.begin() - 1, 0L));
+}
+
+
+auto
+Store::Chunk_End(const Editor::Data *editor_data, size_t index) const -> int64_t
+{
+    if (index + 1 < m_chunks.size()) return m_chunks.at(index + 1).start;
+    return static_cast<int64_t>(editor_data->file_content.size());
+}
+
+
+auto
+Store::Thaw(Editor::Data *editor_data, int64_t first, int64_t last) -> bool
+{
+    if (m_chunks.empty()) return false;
+
+    Clock::time_point now = Clock::now();
+    std::vector<std::pair<size_t, std::vector<std::string>>> thawed;
+    for (size_t i = Find_Chunk(first); i < m_chunks.size() && m_chunks.at(i).start <= last; i++) {
+        Chunk &chunk = m_chunks.at(i);
+        chunk.touched = now;
+        if (chunk.is_frozen) thawed.emplace_back(i, Decode_Lines(chunk.blob));
+    }
+    if (thawed.empty()) return false;
+
+    std::unique_lock lock(editor_data->content_mutex);
+    for (auto &[index, lines] : thawed) Install(editor_data, index, std::move(lines));
+    return true;
+}
+
+
+void
+Store::Thaw_All(Editor::Data *editor_data)
+{
+    Clock::time_point now = Clock::now();
+    for (auto &chunk : m_chunks) chunk.touched = now;
+    if (m_frozen_count == 0) return;
+
+    std::vector<size_t> frozen;
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        if (m_chunks.at(i).is_frozen) frozen.push_back(i);
+    }
+
+    /* Chunks are decompressed on the pool, the buffer is only held while their lines are moved in */
+    std::vector<std::vector<std::string>> thawed(frozen.size());
+    {
+        Tasks::Group jobs;
+        for (size_t i = 0; i < frozen.size(); i++) {
+            Tasks::Submit(Tasks::Interactive, [blob = std::string_view(m_chunks.at(frozen.at(i)).blob), lines = &thawed.at(i)] {
+                *lines = Decode_Lines(blob);
+            }, &jobs);
+        }
+        jobs.Wait();
+    }
+
+    std::unique_lock lock(editor_data->content_mutex);
+    for (size_t i = 0; i < frozen.size(); i++) Install(editor_data, frozen.at(i), std::move(thawed.at(i)));
+}
+
+
+void
+Store::Install(Editor::Data *editor_data, size_t index, std::vector<std::string> lines)
+{
+    std::vector<std::string> &content = editor_data->file_content;
+    Chunk &chunk = m_chunks.at(index);
+    int64_t last = Chunk_End(editor_data, index);
+
+    if (static_cast<int64_t>(lines.size()) != last - chunk.start) {
+        Log::Err("Failed to decompress lines {} to {}, they are left empty", chunk.start + 1, last);
+    } else {
+        std::ranges::move(lines, content.begin() + chunk.start);
+    }
+
+    m_frozen_bytes -= static_cast<int64_t>(chunk.blob.length());
+    m_frozen_count--;
+    std::string().swap(chunk.blob);
+    chunk.is_frozen = false;
+    m_settled_version.reset();
+}
+
+
+void
+Store::After_Edit(Editor::Data *editor_data, int64_t first, int64_t last, int64_t line_shift)
+{
+    if (m_chunks.empty()) return;
+
+    /* Chunks starting inside the rewritten lines are squeezed into them, the ones after move with their lines */
+    int64_t old_last = last - line_shift;
+    for (auto &chunk : m_chunks) {
+        if (chunk.start <= first) continue;
+
+        if (chunk.start <= old_last) chunk.start = std::min(chunk.start, last);
+        else chunk.start += line_shift;
+    }
+
+    /* The edit thawed every chunk over its lines, so the chunks squeezed away hold no blob */
+    for (size_t i = m_chunks.size(); i-- > 1;) {
+        if (m_chunks.at(i).start >= Chunk_End(editor_data, i)) m_chunks.erase(m_chunks.begin() + static_cast<int64_t>(i));
+    }
+}
+
+
+void
+Store::Split_Chunks(Editor::Data *editor_data)
+{
+    bool is_split = m_chunks.empty();
+    for (size_t i = 0; i < m_chunks.size() && !is_split; i++) {
+        is_split = (Chunk_End(editor_data, i) - m_chunks.at(i).start > 2 * CHUNK_LINES);
+    }
+    if (!is_split) return;
+
+    /* The workers read the chunks while they hold the buffer */
+    std::unique_lock lock(editor_data->content_mutex);
+    if (m_chunks.empty()) m_chunks.push_back({ 0, {}, false, Clock::now() });
+
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        int64_t end = Chunk_End(editor_data, i);
+        Chunk &chunk = m_chunks.at(i);
+        int64_t start = chunk.start;
+        Clock::time_point touched = chunk.touched;
+        bool is_frozen = chunk.is_frozen;
+
+        chunks.push_back(std::move(chunk));
+        if (is_frozen || end - start <= 2 * CHUNK_LINES) continue;
+
+        for (start += CHUNK_LINES; start < end; start += CHUNK_LINES) chunks.push_back({ start, {}, false, touched });
+    }
+    m_chunks = std::move(chunks);
+}
+
+
+auto
+Store::Collect(Editor::Data *editor_data) -> bool
+{
+    if (m_budget_bytes <= 0) return false;
+
+    Clock::time_point now = Clock::now();
+    Split_Chunks(editor_data);
+
+    /* A page above and below the viewport, and above that the lines the highlighter lexes the page from */
+    auto first = static_cast<int64_t>(editor_data->scroll.y);
+    auto last = static_cast<int64_t>(editor_data->last_rendered_line);
+    int64_t page = std::max(last - first, 0L);
+    bool is_thawed = Thaw(editor_data, first - page - Syntax::Highlighter::CHECKPOINT_LINES, last + page);
+    is_thawed |= Thaw(editor_data, editor_data->cursor.y, editor_data->cursor.y);
+
+    std::vector<Compressed_Chunk> finished;
+    std::optional<uint64_t> fitting_version;
+    bool is_passing = false;
+    {
+        std::lock_guard lock(m_mutex);
+        finished.swap(m_finished);
+        fitting_version.swap(m_fitting_version);
+        is_passing = m_is_passing;
+    }
+
+    if (fitting_version == editor_data->version) m_settled_version = fitting_version;
+    if (!finished.empty()) Freeze(editor_data, std::move(finished));
+
+    bool is_settled = (m_settled_version == editor_data->version);
+    if (is_passing || is_settled || now - m_pass_start < std::chrono::milliseconds(PASS_MS)) return is_thawed;
+
+    /* The chunk of the last line stays thawed, appends to the file read it before they edit it,
+    // and so do the lines a live register still has to copy out of the buffer */
+    std::vector<size_t> idle;
+    for (size_t i = 0; i + 1 < m_chunks.size(); i++) {
+        const Chunk &chunk = m_chunks.at(i);
+        if (chunk.is_frozen || now - chunk.touched < std::chrono::milliseconds(IDLE_MS)) continue;
+        if (editor_data->registers.Is_Live(chunk.start, Chunk_End(editor_data, i) - 1)) continue;
+        idle.push_back(i);
+    }
+    if (idle.empty()) return is_thawed;
+
+    std::ranges::stable_sort(idle, {}, [this](size_t index) { return m_chunks.at(index).touched; });
+
+    std::vector<std::pair<int64_t, int64_t>> candidates;
+    candidates.reserve(idle.size());
+    for (size_t index : idle) candidates.emplace_back(m_chunks.at(index).start, Chunk_End(editor_data, index));
+
+    m_pass_start = now;
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_passing = true;
+    }
+    Tasks::Submit(
+        Tasks::Background,
+        [this, editor_data, version = editor_data->version, candidates = std::move(candidates), frozen_bytes = m_frozen_bytes] {
+            Run_Pass(editor_data, version, candidates, frozen_bytes);
+        },
+        &m_jobs
+    );
+    return is_thawed;
+}
+
+
+void
+Store::Freeze(Editor::Data *editor_data, std::vector<Compressed_Chunk> compressed)
+{
+    std::unique_lock lock(editor_data->content_mutex);
+    std::vector<std::string> &content = editor_data->file_content;
+
+    for (auto &chunk : compressed) {
+        if (chunk.version != editor_data->version || m_chunks.empty()) continue;
+
+        /* Only a chunk still over the same lines, a split since the pass moved them to other chunks */
+        size_t index = Find_Chunk(chunk.first);
+        Chunk &stored = m_chunks.at(index);
+        if (stored.start != chunk.first || Chunk_End(editor_data, index) != chunk.last) continue;
+        if (stored.is_frozen || stored.touched > m_pass_start) continue;
+
+        for (int64_t y = chunk.first; y < chunk.last; y++) std::string().swap(content.at(y));
+
+        m_frozen_bytes += static_cast<int64_t>(chunk.blob.length());
+        m_frozen_count++;
+        stored.blob = std::move(chunk.blob);
+        stored.is_frozen = true;
+    }
+}
+
+
+void
+Store::Run_Pass(
+    Editor::Data *editor_data,
+    uint64_t version,
+    std::vector<std::pair<int64_t, int64_t>> candidates,
+    int64_t frozen_bytes
+)
+{
+    /* Frozen lines are empty, only the lines still in the buffer count */
+    int64_t excess = frozen_bytes - m_budget_bytes;
+    bool is_measured = false;
+    {
+        std::shared_lock content_lock(editor_data->content_mutex);
+        if (editor_data->version == version) {
+            for (const auto &line : editor_data->file_content) excess += static_cast<int64_t>(line.length());
+            is_measured = true;
+        }
+    }
+
+    for (auto [first, last] : candidates) {
+        if (!is_measured || excess <= 0) break;
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_is_running) break;
+        }
+
+        /* The lines are copied out under the lock, the compression runs without it */
+        std::string text;
+        {
+            std::shared_lock content_lock(editor_data->content_mutex);
+            if (editor_data->version != version) break;
+
+            const std::vector<std::string> &content = editor_data->file_content;
+            for (int64_t y = first; y < last; y++) {
+                if (y != first) text += '\n';
+                text += content.at(y);
+            }
+        }
+
+        std::string blob;
+        if (!Codec::Compress(m_format, text, &blob, true)) break;
+
+        excess -= static_cast<int64_t>(text.length()) - static_cast<int64_t>(blob.length());
+        std::lock_guard lock(m_mutex);
+        m_finished.push_back({ first, last, version, std::move(blob) });
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_is_passing = false;
+    if (is_measured && excess <= 0) m_fitting_version = version;
+}
+
+
+Reader::Reader(const Editor::Data *editor_data) : m_editor_data(editor_data) {}
+
+
+auto
+Reader::at(size_t y) -> const std::string&
+{
+    const Store &store = m_editor_data->cold;
+    const std::vector<std::string> &content = m_editor_data->file_content;
+    if (store.m_frozen_count == 0) return content.at(y);
+
+    auto line = static_cast<int64_t>(y);
+    if (line >= m_first && line - m_first < static_cast<int64_t>(m_lines.size())) return m_lines.at(line - m_first);
+
+    const Store::Chunk &chunk = store.m_chunks.at(store.Find_Chunk(line));
+    if (!chunk.is_frozen) return content.at(y);
+
+    /* A chunk that fails to decompress reads as the empty lines it left in the buffer */
+    m_lines = Decode_Lines(chunk.blob);
+    m_first = chunk.start;
+    if (line - m_first >= static_cast<int64_t>(m_lines.size())) return content.at(y);
+    return m_lines.at(line - m_first);
+}
+
+
+auto
+Reader::size() const -> size_t
+{ return m_editor_data->file_content.size(); }
+
+
+auto
+Lines::at(size_t y) const -> const std::string&
+{
+    m_editor_data->cold.Thaw(m_editor_data, static_cast<int64_t>(y), static_cast<int64_t>(y));
+    return m_editor_data->file_content.at(y);
+}
+
+
+auto
+Lines::size() const -> size_t
+{ return m_editor_data->file_content.size(); }
@@ -11,6 +11,13 @@ Handler::Init(Cursor::Renderer *cursor_renderer)
 void
 Handler::Update_Command(std::string &str)
 {
+    /* The key that opened the command line is also sent as text input */
+    if (is_opening) {
+        is_opening = false;
+        if (str.length() == 1 && str.front() == prompt) return;
+    }
+
+    if (command.empty()) Clear_Command();
     command.insert(cursor.x, str);
     cursor.x += str.length();
 }
@@ -20,18 +27,23 @@ void
 Handler::Clear_Command()
 {
     command.clear();
-    command = ":";
+    command = prompt;
     cursor.x = 1;
 }
 
 
+void
+Handler::Set_Prompt(char prompt)
+{
+    this->prompt = prompt;
+    is_opening = true;
+    Clear_Command();
+}
+
+
 auto
 Handler::Render(AppData *app_data) -> bool
 {
-    if (command == "::") {
-        command = ":";
-        cursor.x--;
-    }
     SDL_Color bg = app_data->config.Get_Color_Value("command", "background");
     int32_t padding = app_data->config.Get_Int_Value("command", "padding");
     TTF_Font *font = app_data->fonts.at("command");
@@ -71,7 +83,7 @@ Handler::Render(AppData *app_data) -> bool
 
     float text_y = panel.y + ((panel_height + padding - text_height) / 2.0F);
 
-    if (command.empty()) command = ":";
+    if (command.empty()) command = prompt;
 
     {
         SDL_Color fg = app_data->config.Get_Color_Value("command", "foreground");
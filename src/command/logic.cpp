@@ -1,27 +1,302 @@
+#include <charconv>
+#include <cctype>
+#include <deque>
+
 #include "../../inc/logging_utility.hpp"
+#include "../../inc/argument_parser.hpp"
 #include "../../inc/file_handler.hpp"
+#include "../../inc/bulk_io.hpp"
+#include "../../inc/buffer.hpp"
 #include "../../inc/editor.hpp"
+#include "../../inc/async.hpp"
 
 #include "../../inc/command.hpp"
 
 
+namespace {
+    /// Checks if args start with the delimiter of a pattern, any punctuation other than a backslash
+    auto
+    Has_Delimiter(std::string_view args) -> bool
+    { return !args.empty() && std::ispunct(static_cast<unsigned char>(args.front())) != 0 && args.front() != '\\'; }
+
+
+    /// Writes that have not finished yet
+    auto
+    Get_Saves() -> Tasks::Group&
+    {
+        static Tasks::Group saves;
+        return saves;
+    }
+
+
+    /// What :w and :e! ask of the file on disk
+    enum File_Job : uint8_t {
+        Write_Job,
+        Reload_Job,
+    };
+
+
+    /// The file jobs run one at a time in the order they were asked for, so a reload never reads a file a write cut short.
+    //  Asking for the job already last in line asks for nothing more, it will see the buffer or the file as they are then.
+    struct File_Queue {
+        bool is_running = false;
+        std::deque<File_Job> jobs;
+    };
+
+
+    auto
+    Get_File_Queue() -> File_Queue&
+    {
+        static File_Queue queue;
+        return queue;
+    }
+
+
+    /// A buffer read from stdin has no file to write to or reload from, its path only names the stream
+    auto
+    Is_Stdin(Editor::Data *editor_data) -> bool
+    {
+        if (editor_data->file_path != ArgParser::STDIN_PATH) return false;
+
+        Log::Err("No file name, the buffer was read from stdin");
+        return true;
+    }
+
+
+    /// A compressed file still being decompressed into the buffer would be written back cut short
+    auto
+    Is_Loading(Editor::Data *editor_data) -> bool
+    {
+        if (editor_data->file_format == Codec::Plain || editor_data->watcher == nullptr) return false;
+        if (!editor_data->watcher->Is_Loading()) return false;
+
+        Log::Err("{} is still loading, try again once it is done", editor_data->file_path.string());
+        return true;
+    }
+
+
+    /// The buffer joined into the text of the file, with its hash and the version it was read on
+    struct Snapshot {
+        std::string text;
+        uint64_t content_hash;
+        uint64_t version;
+    };
+
+
+    /// Writes a copy of the buffer on the pool, so a large file never stalls the editor.
+    //  The journal and the swap file are only reset if nothing was edited while the write ran.
+    auto
+    Write_Copy(Editor::Data *editor_data, bool debug) -> Async::Task<>
+    {
+        /* The buffer is joined on the pool while it holds content_mutex, edits only wait for the copy, not the write */
+        Snapshot snapshot = co_await Async::On_Pool([editor_data]() -> Snapshot {
+            std::shared_lock lock(editor_data->content_mutex);
+            Snapshot copy = { "", Utils::CONTENT_HASH_BASIS, editor_data->version };
+
+            /* Compressed lines are read from a decompressed copy so saving thaws nothing, they are empty in the buffer */
+            size_t length = editor_data->file_content.size();
+            for (const auto &line : editor_data->file_content) length += line.length();
+
+            Cold::Reader content(editor_data);
+            copy.text.reserve(length);
+            for (size_t i = 0; i < content.size(); i++) {
+                const std::string &line = content.at(i);
+                copy.content_hash = Utils::Hash_Line(line, copy.content_hash);
+                if (i != 0) copy.text += '\n';
+                copy.text += line;
+            }
+            return copy;
+        });
+
+        /* The watcher would take the editor's own write for a change made by someone else.
+        // It resyncs to the version that was written, edits made since then are the buffer's own, not the disk's. */
+        if (editor_data->watcher != nullptr) editor_data->watcher->Pause();
+        bool is_written = co_await Async::Write_File(
+            editor_data->file_path, std::move(snapshot.text), editor_data->file_format, &Get_Saves()
+        );
+        if (editor_data->watcher != nullptr) editor_data->watcher->Resume(snapshot.version);
+        if (!is_written) co_return;
+
+        if (debug) {
+            Bulk_IO::Transfer transfer = Bulk_IO::Get_Last_Write();
+            Log::Debug(
+                stdout,
+                "Wrote {} bytes with {} at {:.2f} GB/s\n",
+                transfer.bytes,
+                transfer.backend,
+                transfer.Get_Gigabytes_Per_Second()
+            );
+        }
+        if (editor_data->version != snapshot.version) co_return;
+
+        editor_data->history.Save_Journal(snapshot.content_hash);
+        if (editor_data->swap != nullptr) editor_data->swap->Reset(snapshot.content_hash);
+    }
+
+
+    /// Moves the viewer to :N, the N-th line of the file, :N% or :Nb, the N-th byte
+    auto
+    Jump(Editor::Data *editor_data, std::string_view args) -> bool
+    {
+        double number = 0;
+        auto [end, error] = std::from_chars(args.data(), args.data() + args.length(), number);
+        std::string_view unit = args.substr(end - args.data());
+
+        if (error != std::errc() || (unit != "" && unit != "%" && unit != "b")) {
+            Log::Err("Invalid jump, expected :N for a line, :N% for a percentage or :Nb for a byte");
+            return false;
+        }
+
+        if (unit == "%") editor_data->viewer->Jump_To_Percent(editor_data, number);
+        else if (unit == "b") editor_data->viewer->Jump_To_Byte(editor_data, static_cast<int64_t>(number));
+        else editor_data->viewer->Jump_To_Line(editor_data, static_cast<int64_t>(number) - 1);
+        return true;
+    }
+
+
+    /// Replaces the buffer with the file as it is on disk, as one undo step. The file is read and parsed on the pool.
+    auto
+    Reload(Editor::Data *editor_data, int32_t tab_size) -> Async::Task<>
+    {
+        Codec::Format format = editor_data->file_format;
+        std::optional<std::string> raw = co_await Async::Read_File(editor_data->file_path);
+        if (!raw) co_return;
+
+        /* Parse_File would queue its chunks behind this job and wait for them on a worker, Parse_Text parses in place */
+        std::optional<std::string> text = co_await Async::On_Pool([raw = std::move(*raw), tab_size, format]() mutable -> std::optional<std::string> {
+            std::vector<std::string> lines;
+            if (format == Codec::Plain) {
+                lines = File::Parse_Text(raw, tab_size);
+            } else {
+                std::string decoded;
+                if (!Codec::Decode_All(raw, &decoded)) return std::nullopt;
+                lines = File::Parse_Text(decoded, tab_size);
+            }
+
+            size_t length = lines.size();
+            for (const auto &line : lines) length += line.length();
+
+            std::string joined;
+            joined.reserve(length);
+            for (size_t i = 0; i < lines.size(); i++) {
+                if (i != 0) joined += '\n';
+                joined += lines.at(i);
+            }
+            return joined;
+        });
+
+        /* Decode_All logged why */
+        if (!text) co_return;
+
+        const std::vector<std::string> &content = editor_data->file_content;
+        auto last_line = static_cast<int64_t>(content.size()) - 1;
+        Position end = { static_cast<int64_t>(content.back().length()), last_line };
+        Buffer::Replace_All(editor_data, { { { 0, 0 }, end, *text } });
+
+        Position *cursor = &editor_data->cursor;
+        cursor->y = std::min(cursor->y, static_cast<int64_t>(content.size()) - 1);
+        cursor->x = std::min(cursor->x, static_cast<int64_t>(content.at(cursor->y).length()));
+        editor_data->cursor_max_x = cursor->x;
+        Cursor::Logic::Scroll_To_Cursor(editor_data);
+
+        if (editor_data->watcher != nullptr) editor_data->watcher->Resync(editor_data->version);
+    }
+
+
+    /// Queues a file job, then runs the queue unless it is running already
+    auto
+    Run_File_Job(Editor::Data *editor_data, File_Job job, bool debug, int32_t tab_size) -> Async::Task<>
+    {
+        File_Queue &queue = Get_File_Queue();
+        if (queue.jobs.empty() || queue.jobs.back() != job) queue.jobs.push_back(job);
+        if (queue.is_running) co_return;
+
+        queue.is_running = true;
+        while (!queue.jobs.empty()) {
+            File_Job next = queue.jobs.front();
+            queue.jobs.pop_front();
+
+            if (next == Write_Job) co_await Write_Copy(editor_data, debug);
+            else co_await Reload(editor_data, tab_size);
+        }
+        queue.is_running = false;
+    }
+} /* Anonymous namespace */
+
+
 namespace Command::Logic {
     auto
     Handle(std::string &cmd, Editor::Data *editor_data, AppData *app_data) -> bool
     {
-        if (cmd == "w" || cmd == "wq") {
-            if (!File::Write_File(editor_data->file_path, editor_data->file_content)) {
+        if (cmd == "w") {
+            if (Is_Stdin(editor_data) || Is_Loading(editor_data) || Buffer::Is_Read_Only(editor_data)) return false;
+            Async::Spawn(Run_File_Job(editor_data, Write_Job, app_data->debug, 0));
+            return true;
+        }
+
+        if (cmd == "e!") {
+            if (Is_Stdin(editor_data) || Is_Loading(editor_data) || Buffer::Is_Read_Only(editor_data)) return false;
+            auto tab_size = static_cast<int32_t>(app_data->config.Get_Int_Value("file", "tab_size"));
+            Async::Spawn(Run_File_Job(editor_data, Reload_Job, app_data->debug, tab_size));
+            return true;
+        }
+
+        if (cmd == "follow") {
+            if (editor_data->watcher == nullptr) {
+                Log::Err("The file is not watched, see watch in the [file] section of the config");
+                return false;
+            }
+            editor_data->watcher->Set_Follow(!editor_data->watcher->Is_Following());
+            Log::Info("Follow mode {}\n", (editor_data->watcher->Is_Following() ? "on" : "off"));
+            return true;
+        }
+
+        /* Quitting waits for the write */
+        if (cmd == "wq") {
+            if (Is_Stdin(editor_data) || Is_Loading(editor_data) || Buffer::Is_Read_Only(editor_data)) return false;
+
+            /* A :w still writing an older copy could land after this one */
+            Get_Saves().Wait();
+
+            /* Every line is written out and the editor quits right after, nothing is left to freeze again */
+            editor_data->cold.Thaw_All(editor_data);
+            if (!File::Write_File(editor_data->file_path, editor_data->file_content, editor_data->file_format)) {
                 Log::Err("Failed to write to file: {}", editor_data->file_path.string());
                 return false;
             }
-            if (cmd == "w") return true;
+            uint64_t content_hash = Utils::Hash_Content(editor_data->file_content);
+            editor_data->history.Save_Journal(content_hash);
+            if (editor_data->swap != nullptr) editor_data->swap->Reset(content_hash);
         }
 
         if (cmd == "q" || cmd == "wq") {
+            /* A :w still writing would be cut off by exit() */
+            Get_Saves().Wait();
+
+            /* exit() skips destructors, the swap file has to be removed here */
+            if (editor_data->swap != nullptr) editor_data->swap->Remove();
             SDL::Kill(app_data);
             exit(EXIT_SUCCESS);
         }
 
+        if (editor_data->viewer != nullptr && !cmd.empty() && std::isdigit(static_cast<unsigned char>(cmd.front())) != 0) {
+            return Jump(editor_data, cmd);
+        }
+
+        std::string_view command = cmd;
+        Range range;
+        if (!Parse_Range(editor_data, &command, &range)) return false;
+
+        if (command.starts_with('s') && Has_Delimiter(command.substr(1))) {
+            return Substitute(editor_data, range, command.substr(1));
+        }
+        if (command.starts_with("g!") && Has_Delimiter(command.substr(2))) {
+            return Global(editor_data, range, command.substr(2), true);
+        }
+        if ((command.starts_with('g') || command.starts_with('v')) && Has_Delimiter(command.substr(1))) {
+            return Global(editor_data, range, command.substr(1), command.front() == 'v');
+        }
+
         return true;
     }
 } /* namespace Command::Logic */
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <optional>
+#include <cctype>
+#include <deque>
+
+#include "../../inc/logging_utility.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/editor.hpp"
+#include "../../inc/tasks.hpp"
+
+#include "../../inc/command.hpp"
+
+using Command::Logic::Range;
+
+/* Reading a line through Content thaws it, if it was compressed */
+using Content = Cold::Lines;
+
+
+namespace {
+    /// Ranges shorter than this are matched on the calling thread
+    const int64_t PARTITION_LINES = 8192;
+
+
+    /// The replacements found in one partition of the range, the edits point into texts
+    struct Partition {
+        std::vector<Buffer::Edit> edits;
+        std::deque<std::string> texts;
+    };
+
+
+    /// Runs work(index, first, last) on contiguous partitions of range, one interactive job per partition
+    /// @returns the number of partitions
+    auto
+    Run_Partitions(Range range, const auto &work) -> size_t
+    {
+        int64_t lines = range.last - range.first + 1;
+        auto count = static_cast<int64_t>(Tasks::Get_Thread_Count());
+        count = std::clamp(lines / PARTITION_LINES, 1L, count);
+
+        if (count == 1) {
+            work(0, range.first, range.last + 1);
+            return 1;
+        }
+
+        Tasks::Group partitions;
+        for (int64_t i = 0; i < count; i++) {
+            int64_t first = range.first + (lines * i / count);
+            int64_t last = range.first + (lines * (i + 1) / count);
+            Tasks::Submit(Tasks::Interactive, [&work, i, first, last] { work(i, first, last); }, &partitions);
+        }
+
+        partitions.Wait();
+        return count;
+    }
+
+
+    /// Splits the next field off args, up to an unescaped delimiter. An escaped delimiter loses its backslash.
+    auto
+    Split_Field(std::string_view *args, char delimiter) -> std::string
+    {
+        std::string field;
+
+        size_t i = 0;
+        for (; i < args->length() && args->at(i) != delimiter; i++) {
+            if (args->at(i) == '\\' && i + 1 < args->length()) {
+                if (args->at(i + 1) != delimiter) field += '\\';
+                field += args->at(++i);
+                continue;
+            }
+            field += args->at(i);
+        }
+
+        args->remove_prefix(std::min(i + 1, args->length()));
+        return field;
+    }
+
+
+    /// Splits a replacement around its & into the literal parts, and resolves its escapes
+    auto
+    Parse_Replacement(std::string_view replacement) -> std::vector<std::string>
+    {
+        std::vector<std::string> parts(1);
+
+        for (size_t i = 0; i < replacement.length(); i++) {
+            char c = replacement.at(i);
+            if (c == '&') {
+                parts.emplace_back();
+                continue;
+            }
+            if (c != '\\' || i + 1 == replacement.length()) {
+                parts.back() += c;
+                continue;
+            }
+
+            switch (c = replacement.at(++i)) {
+            case 'r':
+            case 'n':
+                parts.back() += '\n';
+                break;
+            case 't':
+                parts.back() += '\t';
+                break;
+            default:
+                parts.back() += c;
+                break;
+            }
+        }
+        return parts;
+    }
+
+
+    /// Checks if cmd starts with name followed by a delimiter
+    auto
+    Is_Command(std::string_view cmd, std::string_view name) -> bool
+    {
+        if (!cmd.starts_with(name) || cmd.length() <= name.length()) return false;
+
+        auto delimiter = static_cast<unsigned char>(cmd.at(name.length()));
+        return std::ispunct(delimiter) != 0 && delimiter != '\\';
+    }
+
+
+    /// Resolves the pattern of a command, an empty one falls back to the search pattern
+    auto
+    Resolve_Pattern(Editor::Data *editor_data, std::string pattern, std::string *resolved) -> bool
+    {
+        if (pattern.empty()) pattern = editor_data->search.Get_Pattern();
+        if (pattern.empty()) {
+            Log::Err("No previous pattern");
+            return false;
+        }
+
+        *resolved = std::move(pattern);
+        return true;
+    }
+
+
+    /// Moves the cursor to the first non-blank of line y
+    void
+    Move_Cursor_To_Line(Editor::Data *editor_data, int64_t y)
+    {
+        const Content content(editor_data);
+        y = std::clamp(y, 0L, static_cast<int64_t>(content.size()) - 1);
+
+        int64_t x = 0;
+        while (x < static_cast<int64_t>(content.at(y).length()) && content.at(y).at(x) == ' ') x++;
+
+        editor_data->cursor = { x, y };
+        editor_data->cursor_max_x = x;
+        Cursor::Logic::Scroll_To_Cursor(editor_data);
+    }
+
+
+    /// Finds the lines of range that match pattern, in parallel
+    auto
+    Mark_Lines(Editor::Data *editor_data, Range range, std::string_view pattern, bool is_inverted, std::vector<uint8_t> *lines) -> bool
+    {
+        std::shared_ptr<const Regex::Program> program;
+        if (!Search::Compile(pattern, &program)) return false;
+
+        lines->assign(editor_data->file_content.size(), 0);
+
+        /* Each partition decompresses the lines it matches into its own copy, nothing is thawed */
+        Run_Partitions(range, [&](int64_t, int64_t first, int64_t last) {
+            Cold::Reader content(editor_data);
+            std::optional<Regex::Matcher> matcher;
+            if (program) matcher.emplace(program.get());
+
+            std::vector<Regex::Match> matches;
+            for (int64_t y = first; y < last; y++) {
+                matches.clear();
+                Search::Find_In_Line(content.at(y), pattern, matcher ? &*matcher : nullptr, &matches);
+                lines->at(y) = (matches.empty() == is_inverted ? 1 : 0);
+            }
+        });
+        return true;
+    }
+
+
+    /// Substitutes on the lines of range, or only on the marked ones when lines is set
+    /// @param fallback the pattern an empty pattern stands for, instead of the search pattern
+    auto
+    Run_Substitute(
+        Editor::Data *editor_data,
+        Range range,
+        std::string_view args,
+        const std::vector<uint8_t> *lines,
+        std::string_view fallback
+    ) -> bool
+    {
+        char delimiter = args.front();
+        args.remove_prefix(1);
+
+        std::string pattern = Split_Field(&args, delimiter);
+        if (pattern.empty()) pattern = fallback;
+        if (!Resolve_Pattern(editor_data, pattern, &pattern)) return false;
+
+        std::vector<std::string> parts = Parse_Replacement(Split_Field(&args, delimiter));
+
+        bool is_global = false;
+        for (char flag : args) {
+            if (flag != 'g') {
+                Log::Err("Unknown substitute flag: {}", flag);
+                return false;
+            }
+            is_global = true;
+        }
+
+        std::shared_ptr<const Regex::Program> program;
+        if (!Search::Compile(pattern, &program)) return false;
+
+        /* Every partition matches its own lines, the edits are only applied once all of them are done */
+        std::vector<Partition> partitions(Tasks::Get_Thread_Count() + 1);
+
+        /* Only the lines the edits land on are thawed, by Replace_All */
+        size_t count = Run_Partitions(range, [&](int64_t index, int64_t first, int64_t last) {
+            Cold::Reader content(editor_data);
+            Partition &partition = partitions.at(index);
+            std::optional<Regex::Matcher> matcher;
+            if (program) matcher.emplace(program.get());
+
+            std::vector<Regex::Match> matches;
+            for (int64_t y = first; y < last; y++) {
+                if (lines != nullptr && lines->at(y) == 0) continue;
+
+                matches.clear();
+                Search::Find_In_Line(content.at(y), pattern, matcher ? &*matcher : nullptr, &matches);
+                if (!is_global && matches.size() > 1) matches.resize(1);
+
+                for (const auto &match : matches) {
+                    std::string_view text = parts.front();
+
+                    if (parts.size() > 1) {
+                        std::string_view matched = std::string_view(content.at(y)).substr(match.start, match.length);
+                        std::string &expanded = partition.texts.emplace_back(parts.front());
+
+                        for (size_t i = 1; i < parts.size(); i++) {
+                            expanded += matched;
+                            expanded += parts.at(i);
+                        }
+                        text = expanded;
+                    }
+
+                    partition.edits.push_back({ { match.start, y }, { match.start + match.length, y }, text });
+                }
+            }
+        });
+
+        std::vector<Buffer::Edit> edits;
+        for (size_t i = 0; i < count; i++) {
+            edits.insert(edits.end(), partitions.at(i).edits.begin(), partitions.at(i).edits.end());
+        }
+
+        if (edits.empty()) {
+            Log::Err("Pattern not found: {}", pattern);
+            return false;
+        }
+
+        std::vector<Position> ends = Buffer::Replace_All(editor_data, edits);
+        Move_Cursor_To_Line(editor_data, ends.back().y);
+
+        Log::Info("{} substitutions\n", edits.size());
+        return true;
+    }
+
+
+    /// Deletes the marked lines of range, each run of consecutive lines as one edit
+    auto
+    Delete_Lines(Editor::Data *editor_data, Range range, const std::vector<uint8_t> &lines) -> bool
+    {
+        const Content content(editor_data);
+        auto last_line = static_cast<int64_t>(content.size()) - 1;
+
+        std::vector<Buffer::Edit> edits;
+        for (int64_t y = range.first; y <= range.last; y++) {
+            if (lines.at(y) == 0) continue;
+
+            int64_t first = y;
+            while (y < range.last && lines.at(y + 1) != 0) y++;
+
+            /* The last line has no newline after it, the one before it goes instead */
+            if (y < last_line) {
+                edits.push_back({ { 0, first }, { 0, y + 1 }, "" });
+            } else if (first > 0) {
+                edits.push_back({
+                    { static_cast<int64_t>(content.at(first - 1).length()), first - 1 },
+                    { static_cast<int64_t>(content.at(y).length()), y },
+                    ""
+                });
+            } else {
+                edits.push_back({ { 0, 0 }, { static_cast<int64_t>(content.at(y).length()), y }, "" });
+            }
+        }
+
+        if (edits.empty()) return true;
+
+        std::vector<Position> ends = Buffer::Replace_All(editor_data, edits);
+        Move_Cursor_To_Line(editor_data, ends.back().y);
+        return true;
+    }
+} /* Anonymous namespace */
+
+
+namespace Command::Logic {
+    auto
+    Parse_Range(Editor::Data *editor_data, std::string_view *cmd, Range *range) -> bool
+    {
+        auto last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+
+        if (cmd->starts_with('%')) {
+            cmd->remove_prefix(1);
+            *range = { 0, last_line };
+            return true;
+        }
+
+        auto parse_number = [cmd]() {
+            int64_t number = 0;
+            while (!cmd->empty() && std::isdigit(static_cast<unsigned char>(cmd->front())) != 0) {
+                number = (number * 10) + (cmd->front() - '0');
+                cmd->remove_prefix(1);
+            }
+            return number;
+        };
+
+        /* Addresses are 1-indexed like the line numbers, an offset alone is relative to the cursor line */
+        auto parse_address = [&](int64_t *line) {
+            if (cmd->empty()) return false;
+
+            char c = cmd->front();
+            if (c == '.' || c == '$') {
+                *line = (c == '.' ? editor_data->cursor.y : last_line);
+                cmd->remove_prefix(1);
+            } else if (std::isdigit(static_cast<unsigned char>(c)) != 0) {
+                *line = parse_number() - 1;
+            } else if (c == '+' || c == '-') {
+                *line = editor_data->cursor.y;
+            } else {
+                return false;
+            }
+
+            while (!cmd->empty() && (cmd->front() == '+' || cmd->front() == '-')) {
+                int64_t sign = (cmd->front() == '+' ? 1 : -1);
+                cmd->remove_prefix(1);
+
+                bool has_number = !cmd->empty() && std::isdigit(static_cast<unsigned char>(cmd->front())) != 0;
+                *line += sign * (has_number ? parse_number() : 1);
+            }
+            return true;
+        };
+
+        *range = Range();
+        if (!parse_address(&range->first)) return true;
+        range->last = range->first;
+
+        if (cmd->starts_with(',')) {
+            cmd->remove_prefix(1);
+            if (!parse_address(&range->last)) range->last = editor_data->cursor.y;
+        }
+
+        if (range->last < range->first) std::swap(range->first, range->last);
+        if (range->first < 0 || range->last > last_line) {
+            Log::Err("Invalid range");
+            return false;
+        }
+        return true;
+    }
+
+
+    auto
+    Substitute(Editor::Data *editor_data, Range range, std::string_view args) -> bool
+    {
+        if (range.first < 0) range = { editor_data->cursor.y, editor_data->cursor.y };
+        return Run_Substitute(editor_data, range, args, nullptr, "");
+    }
+
+
+    auto
+    Global(Editor::Data *editor_data, Range range, std::string_view args, bool is_inverted) -> bool
+    {
+        if (range.first < 0) range = { 0, static_cast<int64_t>(editor_data->file_content.size()) - 1 };
+
+        char delimiter = args.front();
+        args.remove_prefix(1);
+
+        std::string pattern;
+        if (!Resolve_Pattern(editor_data, Split_Field(&args, delimiter), &pattern)) return false;
+
+        std::vector<uint8_t> lines;
+        if (!Mark_Lines(editor_data, range, pattern, is_inverted, &lines)) return false;
+
+        if (args == "d") return Delete_Lines(editor_data, range, lines);
+        if (Is_Command(args, "s")) return Run_Substitute(editor_data, range, args.substr(1), &lines, pattern);
+
+        Log::Err("Unsupported command for :g: {}", args);
+        return false;
+    }
+} /* namespace Command::Logic */
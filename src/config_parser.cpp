@@ -85,6 +85,15 @@ ConfigParser::Parse_Config(std::filesystem::path &config_path) -> bool
 }
 
 
+auto
+ConfigParser::Get_Section(std::string_view section) -> config_section
+{
+    auto section_it = data.find(std::string(section));
+    if (section_it == data.end()) return {};
+    return section_it->second;
+}
+
+
 auto
 ConfigParser::Get_Value(std::string_view section, std::string_view key) -> std::string
 {
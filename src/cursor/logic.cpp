@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "../../inc/editor.hpp"
 #include "../../inc/cursor.hpp"
 
@@ -7,7 +9,7 @@ using Cursor::Logic;
 auto
 Logic::Move_Cursor_Right(Editor::Data *editor_data, bool is_lctrl_pressed) -> bool
 {
-    int64_t line_len = editor_data->file_content.at(editor_data->cursor.y).length();
+    int64_t line_len = Cold::Lines(editor_data).at(editor_data->cursor.y).length();
     if (editor_data->mode == Editor::Normal && line_len > 0) line_len--;
 
     Position *cursor = &editor_data->cursor;
@@ -40,7 +42,7 @@ Logic::Move_Cursor_Right(Editor::Data *editor_data, bool is_lctrl_pressed) -> bo
 void
 Logic::Ctrl_Cursor_Right(Editor::Data *editor_data)
 {
-    std::string line = editor_data->file_content.at(editor_data->cursor.y);
+    std::string line = Cold::Lines(editor_data).at(editor_data->cursor.y);
     int64_t line_len = line.length();
 
     if (editor_data->mode == Editor::Normal && line_len > 0) line_len--;
@@ -76,7 +78,7 @@ Logic::Move_Cursor_Left(Editor::Data *editor_data, bool is_lctrl_pressed) -> boo
     }
 
     if (cursor->y > 0 && cursor->x <= 0) {
-        int64_t len = editor_data->file_content.at(cursor->y - 1).length() - position_offset;
+        int64_t len = Cold::Lines(editor_data).at(cursor->y - 1).length() - position_offset;
         cursor->y--;
         cursor->x = std::max(len, 0L);
         editor_data->cursor_max_x = cursor->x;
@@ -90,7 +92,7 @@ void
 Logic::Ctrl_Cursor_Left(Editor::Data *editor_data)
 {
     Position *cursor = &editor_data->cursor;
-    std::string line = editor_data->file_content.at(cursor->y);
+    std::string line = Cold::Lines(editor_data).at(cursor->y);
     uint8_t position_offset = (editor_data->mode == Editor::Normal ? 1 : 0);
 
     if (
@@ -126,7 +128,7 @@ Logic::Move_Cursor_Down(Editor::Data *editor_data, bool is_lctrl_pressed) -> boo
     editor_data->scroll.y = std::min(cursor->y, editor_data->scroll.y);
 
     int64_t line_len =
-        editor_data->file_content.at(cursor->y).length();
+        Cold::Lines(editor_data).at(cursor->y).length();
     if (editor_data->mode == Editor::Normal && line_len > 0) line_len--;
 
     cursor->x = editor_data->cursor_max_x;
@@ -151,10 +153,112 @@ Logic::Move_Cursor_Up(Editor::Data *editor_data, bool is_lctrl_pressed) -> bool
     if (cursor->y <= 0) return false;
     editor_data->scroll.y = std::min(--cursor->y, editor_data->scroll.y);
 
-    int64_t line_len = editor_data->file_content.at(cursor->y).length();
+    int64_t line_len = Cold::Lines(editor_data).at(cursor->y).length();
     if (editor_data->mode == Editor::Normal && line_len > 0) { line_len--; }
 
     cursor->x = editor_data->cursor_max_x;
     cursor->x = std::min(cursor->x, line_len);
     return true;
+}
+
+
+auto
+Logic::Line_End(Editor::Data *editor_data, int64_t y) -> int64_t
+{
+    /* Every motion that lands on a line asks for its end first */
+    int64_t line_len = Cold::Lines(editor_data).at(y).length();
+    bool is_on_char = (editor_data->mode == Editor::Normal || editor_data->mode == Editor::Visual);
+    if (is_on_char && line_len > 0) line_len--;
+    return line_len;
+}
+
+
+void
+Logic::Scroll_To_Cursor(Editor::Data *editor_data)
+{
+    Position *cursor = &editor_data->cursor;
+    int64_t last_rendered_line = editor_data->last_rendered_line;
+
+    if (cursor->y >= last_rendered_line) {
+        editor_data->scroll.y += cursor->y - last_rendered_line + 1;
+        editor_data->last_rendered_line = cursor->y + 1;
+    }
+    editor_data->scroll.y = std::min(cursor->y, editor_data->scroll.y);
+}
+
+
+auto
+Logic::Move_Cursor_Lines(Editor::Data *editor_data, int64_t count) -> bool
+{
+    Position *cursor = &editor_data->cursor;
+    int64_t last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+    int64_t target = std::clamp(cursor->y + count, 0L, std::max(last_line, 0L));
+
+    if (target == cursor->y) return false;
+
+    cursor->y = target;
+    cursor->x = std::min(editor_data->cursor_max_x, Line_End(editor_data, target));
+    Scroll_To_Cursor(editor_data);
+    return true;
+}
+
+
+auto
+Logic::Move_Cursor_Columns(Editor::Data *editor_data, int64_t count) -> bool
+{
+    Position *cursor = &editor_data->cursor;
+    Position start = *cursor;
+    int64_t last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+
+    /* Every line end crossed costs one motion, only the crossed lines are visited */
+    while (count > 0) {
+        int64_t room = Line_End(editor_data, cursor->y) - cursor->x;
+        if (count <= room || cursor->y >= last_line) {
+            cursor->x += std::min(count, std::max(room, 0L));
+            break;
+        }
+        count -= room + 1;
+        cursor->y++;
+        cursor->x = 0;
+    }
+
+    while (count < 0) {
+        if (-count <= cursor->x || cursor->y <= 0) {
+            cursor->x = std::max(cursor->x + count, 0L);
+            break;
+        }
+        count += cursor->x + 1;
+        cursor->y--;
+        cursor->x = Line_End(editor_data, cursor->y);
+    }
+
+    editor_data->cursor_max_x = cursor->x;
+    Scroll_To_Cursor(editor_data);
+    return cursor->x != start.x || cursor->y != start.y;
+}
+
+
+auto
+Logic::Scroll_Lines(Editor::Data *editor_data, int64_t count) -> bool
+{
+    int64_t last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+    int64_t target = std::clamp(editor_data->scroll.y + count, 0L, std::max(last_line, 0L));
+
+    if (target == editor_data->scroll.y) return false;
+
+    editor_data->scroll.y = target;
+    return true;
+}
+
+
+auto
+Logic::Apply_Motion(Editor::Data *editor_data, Motion motion) -> bool
+{
+    bool should_render = false;
+
+    if (motion.lines != 0) should_render |= Move_Cursor_Lines(editor_data, motion.lines);
+    if (motion.columns != 0) should_render |= Move_Cursor_Columns(editor_data, motion.columns);
+    if (motion.scroll != 0) should_render |= Scroll_Lines(editor_data, motion.scroll);
+
+    return should_render;
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 
 #include <SDL3_ttf/SDL_ttf.h>
@@ -10,6 +11,23 @@
 using Editor::UI;
 
 
+namespace {
+    auto
+    Get_Token_Color(ConfigParser *config, Syntax::Token_Type type) -> SDL_Color
+    {
+        switch (type) {
+        case Syntax::Keyword:      return config->Get_Color_Value("syntax", "keyword");
+        case Syntax::Type:         return config->Get_Color_Value("syntax", "type");
+        case Syntax::Number:       return config->Get_Color_Value("syntax", "number");
+        case Syntax::String:       return config->Get_Color_Value("syntax", "string");
+        case Syntax::Comment:      return config->Get_Color_Value("syntax", "comment");
+        case Syntax::Preprocessor: return config->Get_Color_Value("syntax", "preprocessor");
+        default:                   return config->Get_Color_Value("editor", "foreground");
+        }
+    }
+} /* Anonymous namespace */
+
+
 UI::UI(
     bool *return_code,
     std::string &file_path,
@@ -71,12 +89,14 @@ UI::Render(AppData *app_data) -> bool
 
     /* Offset used to render text line by line initialised with the editor's position */
     int32_t y_offset = m_editor_data->position.y;
+    int32_t text_x = m_editor_data->position.x;
     for (size_t i = m_editor_data->scroll.y; i < m_editor_data->last_rendered_line; i++) {
         int32_t line_number_width = 0;
         Render_Line_Number(app_data, i, { m_editor_data->position.x, y_offset }, &line_number_width);
 
         Position render_pos = { m_editor_data->position.x + line_number_width, y_offset };
         Render_Text(app_data, render_pos, i);
+        text_x = render_pos.x;
 
         Position cursor_pos = {
             render_pos.x,
@@ -90,7 +110,11 @@ UI::Render(AppData *app_data) -> bool
         y_offset += line_height;
     }
 
-    return true;
+    return (
+        Render_Search_Matches(app_data, text_x) &&
+        Render_Selection(app_data, text_x) &&
+        Render_Extra_Cursors(app_data, text_x)
+    );
 }
 
 
@@ -102,6 +126,8 @@ UI::Render_Line_Number(
     int32_t *line_number_width
 ) const -> bool
 {
+    /* The viewer only holds a window of the file, numbered from where it starts once that is known */
+    int64_t first_line = (m_editor_data->viewer != nullptr ? m_editor_data->viewer->Get_First_Line() : 0);
     int64_t line = line_index;
     bool zero_indexing = app_data->config.Get_Bool_Value("editor", "zero_indexing");
     bool relative = app_data->config.Get_Bool_Value("editor", "relative_line_number");
@@ -111,6 +137,9 @@ UI::Render_Line_Number(
         is_current_line
     );
     size_t file_size = m_editor_data->file_content.size();
+    if (m_editor_data->viewer != nullptr) {
+        file_size = std::max<size_t>(first_line + file_size, m_editor_data->viewer->Get_Counted_Lines());
+    }
 
     if (line_index < m_editor_data->cursor.y) {
         line_index++;
@@ -119,8 +148,10 @@ UI::Render_Line_Number(
     std::string text;
     if (relative && !is_current_line) {
         text = std::to_string(std::abs(m_editor_data->cursor.y - line) - (zero_indexing ? 1 : 0));
+    } else if (first_line < 0) {
+        text = "?";
     } else {
-        text = std::to_string(line - (zero_indexing ? 0 : -1));
+        text = std::to_string(first_line + line - (zero_indexing ? 0 : -1));
     }
 
     int32_t total_spaces = std::log10(file_size) + 4 - text.length() - (padding ? 2 : 0);
@@ -148,12 +179,42 @@ UI::Render_Text(AppData *app_data, Position position, int64_t line_index) const
     SDL_Color color = app_data->config.Get_Color_Value("editor", "foreground");
     TTF_Font *font = app_data->fonts.at("editor");
 
-    return SDL::Draw_Text_Closed(
-        { app_data->renderer, font, color, position },
-        m_editor_data->max_editor_width,
-        m_editor_data->file_content.at(line_index),
-        nullptr
-    );
+    /* Lines the syntax worker has not reached yet are drawn plain, and recoloured once it has */
+    std::vector<Syntax::Run> runs;
+    if (!m_editor_data->syntax.Get_Line_Runs(line_index, &runs)) {
+        return SDL::Draw_Text_Closed(
+            { app_data->renderer, font, color, position },
+            m_editor_data->max_editor_width,
+            m_editor_data->file_content.at(line_index),
+            nullptr
+        );
+    }
+
+    int32_t char_width = 0;
+    if (!SDL::Get_Char_Size(font, ' ', &char_width, nullptr)) return false;
+
+    std::string_view line = m_editor_data->file_content.at(line_index);
+    if (m_editor_data->max_editor_width != 0 && char_width > 0) {
+        line = line.substr(0, std::min(line.length(), m_editor_data->max_editor_width / char_width));
+    }
+
+    /* The line is drawn in segments, plain text between the runs in the foreground colour */
+    auto draw = [&](int64_t start, int64_t end, SDL_Color segment_color) -> bool {
+        end = std::min(end, static_cast<int64_t>(line.length()));
+        if (end <= start) return true;
+
+        std::string segment(line.substr(start, end - start));
+        Position segment_position(position.x + (start * char_width), position.y);
+        return SDL::Draw_Text({ app_data->renderer, font, segment_color, segment_position }, segment, nullptr);
+    };
+
+    int64_t x = 0;
+    for (const auto &run : runs) {
+        if (!draw(x, run.start, color)) return false;
+        if (!draw(run.start, run.start + run.length, Get_Token_Color(&app_data->config, run.type))) return false;
+        x = run.start + run.length;
+    }
+    return draw(x, static_cast<int64_t>(line.length()), color);
 }
 
 
@@ -169,4 +230,155 @@ UI::Render_Cursor(AppData *app_data, Position position, std::string &line) const
     else if (m_editor_data->mode == Insert) { cursor_data.type = Cursor::Type::Beam; }
 
     return m_cursor_renderer->Render(app_data, &cursor_data, "editor");
-}
\ No newline at end of file
+}
+
+
+auto
+UI::Render_Selection(AppData *app_data, int32_t text_x) const -> bool
+{
+    if (m_editor_data->mode != Visual) return true;
+
+    TTF_Font *font = app_data->fonts.at("editor");
+    int32_t line_height = TTF_GetFontHeight(font);
+    int32_t char_width = 0;
+    if (!SDL::Get_Char_Size(font, ' ', &char_width, nullptr)) return false;
+
+    Position start = m_editor_data->visual_start;
+    Position end = m_editor_data->cursor;
+    if (end.Is_Before(start)) std::swap(start, end);
+
+    int64_t first = std::max(start.y, m_editor_data->scroll.y);
+    int64_t last = std::min(end.y, static_cast<int64_t>(m_editor_data->last_rendered_line) - 1);
+    auto full_width = static_cast<float>(m_editor_data->max_editor_width - (text_x - m_editor_data->position.x));
+
+    int64_t left = std::min(m_editor_data->visual_start.x, m_editor_data->cursor.x);
+    int64_t right = std::max(m_editor_data->visual_start.x, m_editor_data->cursor.x) + 1;
+
+    /* Vertically adjacent rows covering the same columns are merged into one rect */
+    std::vector<SDL_FRect> rects;
+    for (int64_t y = first; y <= last; y++) {
+        float x1 = 0;
+        float x2 = full_width;
+
+        if (m_editor_data->visual_type == Visual_Block) {
+            x1 = static_cast<float>(left * char_width);
+            x2 = static_cast<float>(right * char_width);
+        } else if (m_editor_data->visual_type == Visual_Char) {
+            if (y == start.y) x1 = static_cast<float>(start.x * char_width);
+            if (y == end.y) x2 = static_cast<float>((end.x + 1) * char_width);
+        }
+
+        SDL_FRect row = {
+            static_cast<float>(text_x) + x1,
+            static_cast<float>(m_editor_data->position.y + ((y - m_editor_data->scroll.y) * line_height)),
+            x2 - x1,
+            static_cast<float>(line_height)
+        };
+
+        if (!rects.empty() && rects.back().x == row.x && rects.back().w == row.w) {
+            rects.back().h += row.h;
+            continue;
+        }
+        rects.push_back(row);
+    }
+
+    if (rects.empty()) return true;
+
+    SDL_Color color = app_data->config.Get_Color_Value("editor", "selection");
+    if (!SDL::Set_Draw_Color_Blend(app_data->renderer, color)) return false;
+    if (!SDL_RenderFillRects(app_data->renderer, rects.data(), static_cast<int32_t>(rects.size()))) {
+        Log::SDL_Err("Failed to render selection");
+        return false;
+    }
+    return true;
+}
+
+
+auto
+UI::Render_Extra_Cursors(AppData *app_data, int32_t text_x) const -> bool
+{
+    if (m_editor_data->extra_cursors.empty() || m_editor_data->mode == Command) return true;
+
+    TTF_Font *font = app_data->fonts.at("editor");
+    int32_t line_height = TTF_GetFontHeight(font);
+    int32_t char_width = 0;
+    if (!SDL::Get_Char_Size(font, ' ', &char_width, nullptr)) return false;
+
+    auto width = static_cast<float>(app_data->config.Get_Int_Value("cursor", "width"));
+    bool is_beam = (m_editor_data->mode == Insert);
+
+    /* Extra cursors are sorted, so only the visible ones are visited */
+    auto first = std::ranges::lower_bound(
+        m_editor_data->extra_cursors, Position(0, m_editor_data->scroll.y),
+        [](Position a, Position b) { return a.Is_Before(b); }
+    );
+
+    /* Every outline of every cursor is filled with a single draw call */
+    std::vector<SDL_FRect> rects;
+    for (auto extra = first; extra != m_editor_data->extra_cursors.end(); extra++) {
+        if (extra->y >= static_cast<int64_t>(m_editor_data->last_rendered_line)) break;
+
+        SDL_FRect cell = {
+            static_cast<float>(text_x + (extra->x * char_width)),
+            static_cast<float>(m_editor_data->position.y + ((extra->y - m_editor_data->scroll.y) * line_height)),
+            static_cast<float>(char_width),
+            static_cast<float>(line_height)
+        };
+
+        rects.push_back({ cell.x, cell.y, width, cell.h });
+        if (is_beam) continue;
+
+        rects.push_back({ cell.x, cell.y, cell.w, width });
+        rects.push_back({ cell.x + cell.w - width, cell.y, width, cell.h });
+        rects.push_back({ cell.x, cell.y + cell.h - width, cell.w, width });
+    }
+
+    if (rects.empty()) return true;
+
+    SDL_Color color = app_data->config.Get_Color_Value("cursor", "color");
+    if (!SDL::Set_Draw_Color_Blend(app_data->renderer, color)) return false;
+    if (!SDL_RenderFillRects(app_data->renderer, rects.data(), static_cast<int32_t>(rects.size()))) {
+        Log::SDL_Err("Failed to render extra cursors");
+        return false;
+    }
+    return true;
+}
+
+
+auto
+UI::Render_Search_Matches(AppData *app_data, int32_t text_x) const -> bool
+{
+    const Search::Searcher &search = m_editor_data->search;
+    if (search.Get_Pattern().empty()) return true;
+
+    TTF_Font *font = app_data->fonts.at("editor");
+    int32_t line_height = TTF_GetFontHeight(font);
+    int32_t char_width = 0;
+    if (!SDL::Get_Char_Size(font, ' ', &char_width, nullptr)) return false;
+
+    /* Lines the workers have not reached yet are simply drawn without highlights */
+    std::vector<SDL_FRect> rects;
+    std::vector<Search::Match> matches;
+    for (auto y = static_cast<int64_t>(m_editor_data->scroll.y); y < m_editor_data->last_rendered_line; y++) {
+        if (!search.Get_Line_Matches(y, &matches)) continue;
+
+        auto row_y = static_cast<float>(m_editor_data->position.y + ((y - m_editor_data->scroll.y) * line_height));
+        for (const auto &match : matches) {
+            /* Empty regex matches still get a one character mark */
+            auto width = static_cast<float>(std::max(match.length, 1L) * char_width);
+            rects.push_back({
+                static_cast<float>(text_x + (match.start.x * char_width)), row_y, width, static_cast<float>(line_height)
+            });
+        }
+    }
+
+    if (rects.empty()) return true;
+
+    SDL_Color color = app_data->config.Get_Color_Value("editor", "search");
+    if (!SDL::Set_Draw_Color_Blend(app_data->renderer, color)) return false;
+    if (!SDL_RenderFillRects(app_data->renderer, rects.data(), static_cast<int32_t>(rects.size()))) {
+        Log::SDL_Err("Failed to render search matches");
+        return false;
+    }
+    return true;
+}
@@ -1,11 +1,134 @@
+#include <algorithm>
+#include <iterator>
 #include <fstream>
+#include <cctype>
+
+#if __unix__
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#endif
 
 #include "../inc/utilities.hpp"
 #include "../inc/logging_utility.hpp"
+#include "../inc/bulk_io.hpp"
+#include "../inc/tasks.hpp"
 
 #include "../inc/file_handler.hpp"
 
 
+namespace {
+    /// Files smaller than this are parsed on the calling thread
+    const size_t PARALLEL_BYTES = 4 * 1024 * 1024;
+
+    /// Chunks are never smaller than this, so each job is worth queuing
+    const size_t MIN_CHUNK_BYTES = 1024 * 1024;
+
+    /// Chunks per worker, so a worker that finishes early steals the chunks of a slow one
+    const size_t CHUNKS_PER_WORKER = 4;
+
+
+    /// The whole content of a file, read through io_uring when it is large and available,
+    //  mapped when the platform allows it and read into memory otherwise
+    class
+    File_Text
+    {
+    public:
+        File_Text() = default;
+        ~File_Text()
+        {
+#if __unix__
+            if (m_map != nullptr) munmap(m_map, m_size);
+#endif
+        }
+
+        File_Text(const File_Text&) = delete;
+        auto operator=(const File_Text&) -> File_Text& = delete;
+
+        /// @returns false if the file could not be opened
+        auto Open(const std::string &file_path) -> bool
+        {
+#if __unix__
+            int fd = open(file_path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+
+            struct stat status = {};
+            if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= Bulk_IO::URING_BYTES && Bulk_IO::Has_Uring()) {
+                close(fd);
+                return Bulk_IO::Read_File(file_path, &m_buffer);
+            }
+            if (status.st_size > 0) {
+                void *map = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED) {
+                    m_map = map;
+                    m_size = status.st_size;
+                    madvise(m_map, m_size, MADV_WILLNEED);
+                }
+            }
+            close(fd);
+            if (m_map != nullptr || status.st_size == 0) return true;
+#endif
+            std::ifstream file(file_path, std::ios::binary);
+            if (!file.is_open()) return false;
+
+            m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        [[nodiscard]]
+        auto Get_Text() const -> std::string_view
+        {
+            if (m_map != nullptr) return { static_cast<const char*>(m_map), m_size };
+            return m_buffer;
+        }
+
+    private:
+        void *m_map = nullptr;
+        size_t m_size = 0;
+        std::string m_buffer;
+    };
+
+
+    /// Counts the lines std::getline would split text into
+    auto
+    Count_Lines(std::string_view text) -> size_t
+    {
+        if (text.empty()) return 0;
+        return static_cast<size_t>(std::ranges::count(text, '\n')) + (text.back() == '\n' ? 0 : 1);
+    }
+
+
+    /// Splits text into lines like std::getline, trimming each on the right and expanding its tabs.
+    //  lines has to have room for Count_Lines(text) lines.
+    void
+    Parse_Lines(std::string_view text, int32_t tab_size, std::string *lines)
+    {
+        size_t start = 0;
+        while (start < text.length()) {
+            size_t end = std::min(text.find('\n', start), text.length());
+            std::string_view line = text.substr(start, end - start);
+            start = end + 1;
+
+            size_t length = line.length();
+            while (length > 0 && std::isspace(static_cast<unsigned char>(line[length - 1])) != 0) length--;
+            line = line.substr(0, length);
+
+            auto tabs = static_cast<size_t>(std::ranges::count(line, '\t'));
+            std::string &parsed = *lines++;
+            parsed.reserve(line.length() + (tabs * std::max(tab_size - 1, 0)));
+
+            for (size_t tab = line.find('\t'); tab != std::string_view::npos; tab = line.find('\t')) {
+                parsed.append(line.substr(0, tab));
+                parsed.append(static_cast<size_t>(tab_size), ' ');
+                line.remove_prefix(tab + 1);
+            }
+            parsed.append(line);
+        }
+    }
+} /* Anonymous namespace */
+
+
 namespace File {
     auto
     Parse_File(std::string &file_path, int32_t tab_size, bool first_init) -> std::vector<std::string>
@@ -16,46 +139,93 @@ namespace File {
             return file_content; /* Returns an empty vector */
         }
 
-        std::ifstream file(file_path);
+        File_Text file;
 
-        if (!file.is_open()) {
+        if (!file.Open(file_path)) {
             if (first_init) Log::Failed_Msg();
             Log::Err("Failed to open file: {}", file_path);
             return file_content; /* Returns an empty vector */
         }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            Utils::Trim_String(line, Right);
+        std::string_view text = file.Get_Text();
+        size_t worker_count = Tasks::Get_Thread_Count();
+        size_t chunk_count = std::clamp(text.length() / MIN_CHUNK_BYTES, size_t(1), worker_count * CHUNKS_PER_WORKER);
+        if (text.length() < PARALLEL_BYTES || worker_count == 1 || chunk_count == 1) {
+            file_content.resize(Count_Lines(text));
+            Parse_Lines(text, tab_size, file_content.data());
+            return file_content;
+        }
+
+        /* Every chunk but the first starts right after a line break, so no line is split between two of them */
+        std::vector<size_t> bounds(chunk_count + 1, text.length());
+        bounds.front() = 0;
+        for (size_t i = 1; i < chunk_count; i++) {
+            size_t bound = std::max(text.length() * i / chunk_count, bounds.at(i - 1));
+            size_t line_break = text.find('\n', bound - 1);
+            bounds.at(i) = (line_break == std::string_view::npos ? text.length() : line_break + 1);
+        }
 
-            /* Changes all \t characters */
-            size_t position = 0;
-            while ((position = line.find('\t', position)) != std::string::npos) {
-                line.replace(position, 1, std::string(tab_size, ' '));
-            }
+        /* Each chunk counts its lines first, so the second pass parses them straight into their place */
+        std::vector<std::string_view> chunks;
+        for (size_t i = 0; i < chunk_count; i++) chunks.push_back(text.substr(bounds.at(i), bounds.at(i + 1) - bounds.at(i)));
 
-            file_content.emplace_back(std::move(line));
+        std::vector<size_t> offsets(chunk_count + 1, 0);
+        {
+            Tasks::Group jobs;
+            for (size_t i = 0; i < chunk_count; i++) {
+                Tasks::Submit(Tasks::Interactive, [chunk = chunks.at(i), count = &offsets.at(i + 1)] {
+                    *count = Count_Lines(chunk);
+                }, &jobs);
+            }
+            jobs.Wait();
         }
+        for (size_t i = 0; i < chunk_count; i++) offsets.at(i + 1) += offsets.at(i);
 
+        file_content.resize(offsets.back());
+        {
+            Tasks::Group jobs;
+            for (size_t i = 0; i < chunk_count; i++) {
+                std::string *lines = file_content.data() + offsets.at(i);
+                Tasks::Submit(Tasks::Interactive, [chunk = chunks.at(i), tab_size, lines] {
+                    Parse_Lines(chunk, tab_size, lines);
+                }, &jobs);
+            }
+            jobs.Wait();
+        }
         return file_content;
     }
 
 
+    auto
+    Parse_Text(std::string_view text, int32_t tab_size) -> std::vector<std::string>
+    {
+        std::vector<std::string> lines(Count_Lines(text));
+        Parse_Lines(text, tab_size, lines.data());
+        return lines;
+    }
+
+
     auto
     Parse_File_Async(std::string &file_path, int32_t tab_size) -> std::future<std::vector<std::string>>
     {
-        return std::async(std::launch::async, [file_path, tab_size]() -> std::vector<std::string> {
+        auto promise = std::make_shared<std::promise<std::vector<std::string>>>();
+        std::future<std::vector<std::string>> future = promise->get_future();
+
+        /* Loading is waited on, so it goes ahead of every background job */
+        Tasks::Submit(Tasks::Interactive, [promise, file_path, tab_size]() {
             std::vector<std::string> file_content;
 
             if (!Utils::Is_Valid_File(file_path)) {
-                return { " " }; /* Returns an empty vector */
+                promise->set_value({ " " });
+                return;
             }
 
             std::ifstream file(file_path);
 
             if (!file.is_open()) {
                 Log::Err("Failed to open file: {}", file_path);
-                return file_content; /* Returns an empty vector */
+                promise->set_value(std::move(file_content)); /* An empty vector */
+                return;
             }
 
             std::string line;
@@ -74,34 +244,38 @@ namespace File {
             }
 
             file.close();
-            return file_content;
+            promise->set_value(std::move(file_content));
         });
+        return future;
     }
 
 
     auto
     Write_File(
         std::filesystem::path &file_path,
-        const std::vector<std::string> &file_content
+        const std::vector<std::string> &file_content,
+        Codec::Format format
     ) -> bool
     {
         if (!Utils::Is_Valid_File(file_path.string()) && file_path.string().contains('/')) {
             std::filesystem::create_directory(file_path.relative_path());
         }
 
-        std::ofstream file(file_path);
-
-        if (!file.is_open()) {
-            Log::Err("Failed to open file: {}", file_path.string());
-            return false;
-        }
+        size_t length = file_content.size();
+        for (const auto &line : file_content) length += line.length();
 
+        std::string text;
+        text.reserve(length);
         for (size_t i = 0; i < file_content.size(); i++) {
-            std::string inserted_string = file_content[i];
-            if (i != file_content.size() - 1) inserted_string += "\n";
-            file << inserted_string;
+            if (i != 0) text += '\n';
+            text += file_content[i];
         }
 
-        return true;
+        if (format != Codec::Plain) {
+            std::string compressed;
+            if (!Codec::Compress(format, text, &compressed)) return false;
+            text = std::move(compressed);
+        }
+        return Bulk_IO::Write_File(file_path, text);
     }
 }  /* namespace File */
\ No newline at end of file
@@ -1,39 +1,190 @@
+#include <cctype>
+
+#include "../../inc/logging_utility.hpp"
 #include "../../inc/command.hpp"
 #include "../../inc/cursor.hpp"
+#include "../../inc/buffer.hpp"
 
 #include "../../inc/input.hpp"
 
 using Input::Handler;
 
 
+void
+Handler::Init(ConfigParser *config)
+{ m_keymap.Load(config); }
+
+
 auto
-Handler::Handle(SDL_Scancode code, Editor::UI *editor, AppData *app_data, Command::Handler *command_handler) -> bool
+Handler::Handle(
+    SDL_Scancode code,
+    SDL_Keymod mod,
+    Editor::UI *editor,
+    AppData *app_data,
+    Command::Handler *command_handler
+) -> bool
 {
-    is_lshift_pressed = (SDL_GetModState() & SDL_KMOD_LSHIFT) != 0U;
-    is_lctrl_pressed = (SDL_GetModState() & SDL_KMOD_LCTRL) != 0U;
+    is_lshift_pressed = (mod & SDL_KMOD_LSHIFT) != 0U;
+    is_lctrl_pressed = (mod & SDL_KMOD_LCTRL) != 0U;
     editor_data = editor->Get_Data();
     this->code = code;
+    this->mod = mod;
+    this->editor = editor;
     this->app_data = app_data;
+    this->command_handler = command_handler;
+
+    Record_Event({ "", code, mod });
+
+    if (Queue_Motion()) return false;
+
+    /* Any other key might depend on the cursor, so queued motions are applied first */
+    bool should_render = Flush_Motion(editor);
 
     if (Handle_Global()) return true;
 
     switch (editor_data->mode) {
     case Editor::Normal:
-        return Handle_Normal_Mode();
+        return Handle_Normal_Mode() || should_render;
 
     case Editor::Insert:
-        return Handle_Insert_Mode();
+        return Handle_Insert_Mode() || should_render;
 
     case Editor::Command:
-        return Handle_Command_Mode(command_handler, editor_data);
+        return Handle_Command_Mode(command_handler, editor_data) || should_render;
+
+    case Editor::Visual:
+        return Handle_Visual_Mode() || should_render;
+
+    default:
+        return should_render;
+    }
+    return should_render;
+}
+
+
+auto
+Handler::Handle_Text_Input(
+    std::string_view text,
+    Editor::UI *editor,
+    AppData *app_data,
+    Command::Handler *command_handler
+) -> bool
+{
+    if (text.empty()) return false;
+
+    auto *editor_data = editor->Get_Data();
+    Record_Event({ std::string(text), SDL_SCANCODE_UNKNOWN, 0 });
+
+    if (editor_data->mode == Editor::Command) {
+        std::string command(text);
+        command_handler->Update_Command(command);
+
+        /* Searches are incremental, every typed character restarts the background scan */
+        char prompt = command_handler->Get_Prompt();
+        if (prompt != ':') editor_data->search.Start(editor_data, command_handler->Get_Command(), prompt == '?');
+        return true;
+    }
+
+    if (editor_data->mode == Editor::Insert) {
+        Flush_Motion(editor);
+        Input::Logic::Handle_Text_Input(editor_data, app_data, text);
+    }
+    return true;
+}
+
+
+auto
+Handler::Flush_Motion(Editor::UI *editor) -> bool
+{
+    if (m_motion.Is_Empty()) return false;
+
+    bool should_render = Cursor::Logic::Apply_Motion(editor->Get_Data(), m_motion);
+    m_motion = Cursor::Motion();
+    return should_render;
+}
+
+
+void
+Handler::Queue_Scroll(int64_t lines)
+{ m_motion.scroll += lines; }
+
 
-    // case Visual:
-    //     return Handle_Visual_Mode();
+auto
+Handler::Queue_Motion() -> bool
+{
+    bool is_normal = editor_data->mode == Editor::Normal;
+    bool is_visual = editor_data->mode == Editor::Visual;
+
+    /* Folded motions only move the cursor, motions that move extra cursors too are executed one by one */
+    if (!editor_data->extra_cursors.empty()) return false;
+    int64_t lines = 0;
+    int64_t columns = 0;
+
+    Action action = No_Action;
+
+    switch (code) {
+    case SDL_SCANCODE_RIGHT:
+        action = Right;
+        break;
+    case SDL_SCANCODE_LEFT:
+        action = Left;
+        break;
+    case SDL_SCANCODE_DOWN:
+        action = Down;
+        break;
+    case SDL_SCANCODE_UP:
+        action = Up;
+        break;
+
+    default:
+        /* Keys typed after a count or an operator belong to the key sequence */
+        if ((!is_normal && !is_visual) || !m_sequence.Is_Empty()) return false;
+
+        char key = Get_Key_Char();
+        Key_Mode mode = (is_visual ? Visual_Keys : Normal_Keys);
+        if (key == '\0' || !m_keymap.Find(std::string(1, key), mode, &action)) return false;
+        break;
+    }
+
+    switch (action) {
+    case Right:
+    case Left:
+        if (is_lctrl_pressed) return false;
+        columns = (action == Right ? 1 : -1);
+        break;
+
+    case Down:
+    case Up:
+        if (is_lctrl_pressed) {
+            m_motion.scroll += (action == Down ? 1 : -1);
+            return true;
+        }
+        lines = (action == Down ? 1 : -1);
+        break;
 
     default:
         return false;
     }
-    return false;
+
+    /* Only motions along the same axis are folded, so their order is kept */
+    if ((lines != 0 && m_motion.columns != 0) || (columns != 0 && m_motion.lines != 0)) {
+        Cursor::Logic::Apply_Motion(editor_data, { m_motion.lines, m_motion.columns, 0 });
+        m_motion.lines = 0;
+        m_motion.columns = 0;
+    }
+
+    m_motion.lines += lines;
+    m_motion.columns += columns;
+    return true;
+}
+
+
+auto
+Handler::Get_Key_Char() const -> char
+{
+    SDL_Keycode key = SDL_GetKeyFromScancode(code, mod, false);
+    if (key >= 128 || std::isprint(static_cast<int>(key)) == 0) return '\0';
+    return static_cast<char>(key);
 }
 
 
@@ -53,7 +204,7 @@ Handler::Handle_Global() -> bool
         return Cursor::Logic::Move_Cursor_Up(editor_data, is_lctrl_pressed);
 
     case SDL_SCANCODE_END: {
-        size_t line_len = editor_data->file_content.at(cursor->y).length();
+        size_t line_len = Cold::Lines(editor_data).at(cursor->y).length();
         if (line_len == 0) return false;
 
         if (editor_data->mode != Editor::Insert) { cursor->x = line_len - 1; }
@@ -76,9 +227,13 @@ Handler::Handle_Insert_Mode() -> bool
 {
     switch (code) {
     case SDL_SCANCODE_ESCAPE:
-        SDL_StopTextInput(app_data->window);
+        Input::Logic::Set_Text_Input(app_data, false);
         editor_data->mode = Editor::Normal;
+        editor_data->history.End_Group(editor_data->cursor);
         if (editor_data->cursor.x > 0) editor_data->cursor.x--;
+        for (auto &extra : editor_data->extra_cursors) {
+            if (extra.x > 0) extra.x--;
+        }
         return true;
 
     case SDL_SCANCODE_BACKSPACE:
@@ -87,11 +242,13 @@ Handler::Handle_Insert_Mode() -> bool
     case SDL_SCANCODE_RETURN:
         return Input::Logic::Handle_Return(editor_data);
 
+    case SDL_SCANCODE_V:
+        if (is_lctrl_pressed) return Input::Logic::Paste_Clipboard(editor_data, app_data);
+        return false;
+
     case SDL_SCANCODE_TAB: {
         int32_t tab_size = app_data->config.Get_Int_Value("file", "tab_size");
-        editor_data->file_content.at(editor_data->cursor.y).insert(editor_data->cursor.x, std::string(tab_size, ' '));
-        editor_data->cursor.x += tab_size;
-        return true;
+        return Input::Logic::Handle_Text_Input(editor_data, app_data, std::string(tab_size, ' '));
     }
 
     default:
@@ -103,51 +260,198 @@ Handler::Handle_Insert_Mode() -> bool
 auto
 Handler::Handle_Normal_Mode() -> bool
 {
-    switch (code) {
-    case SDL_SCANCODE_I:
-        SDL_StartTextInput(app_data->window);
-        editor_data->mode = Editor::Insert;
-        return true;
+    if (code == SDL_SCANCODE_ESCAPE) {
+        m_sequence.Reset();
+        return Input::Logic::Clear_Extra_Cursors(editor_data);
+    }
 
-    case SDL_SCANCODE_A:
-        SDL_StartTextInput(app_data->window);
-        {
-            auto *cursor = &editor_data->cursor;
-            if (cursor->x < editor_data->file_content.at(cursor->y).length()) cursor->x++;
+    if (is_lctrl_pressed) {
+        switch (code) {
+        case SDL_SCANCODE_R:
+            Input::Logic::Clear_Extra_Cursors(editor_data);
+            return editor_data->history.Redo(editor_data);
+        case SDL_SCANCODE_V:
+            return Input::Logic::Enter_Visual_Mode(editor_data, Editor::Visual_Block);
+
+        case SDL_SCANCODE_L:
+            return Cursor::Logic::Move_Cursor_Right(editor_data, is_lctrl_pressed);
+        case SDL_SCANCODE_H:
+            return Cursor::Logic::Move_Cursor_Left(editor_data, is_lctrl_pressed);
+
+        default:
+            return false;
         }
-        editor_data->mode = Editor::Insert;
+    }
+
+    char key = Get_Key_Char();
+    if (key == '\0') return false;
+
+    /* While recording, the key that starts a recording stops it instead */
+    Action action = No_Action;
+    if (
+        m_recording_name != '\0' && m_sequence.Is_Empty() &&
+        m_keymap.Find(std::string(1, key), Normal_Keys, &action) && action == Record_Macro
+    ) {
+        Stop_Recording();
         return true;
+    }
 
-    case SDL_SCANCODE_SEMICOLON:
-        if (is_lshift_pressed) {
-            SDL_StartTextInput(app_data->window);
-            editor_data->mode = Editor::Command;
-            return true;
-        }
-        return false;
+    Key_Command command;
+    if (m_sequence.Feed(m_keymap, key, &command) != Key_Sequence::Complete) return false;
 
-    case SDL_SCANCODE_L:
-        return Cursor::Logic::Move_Cursor_Right(editor_data, is_lctrl_pressed);
-    case SDL_SCANCODE_H:
-        return Cursor::Logic::Move_Cursor_Left(editor_data, is_lctrl_pressed);
-    case SDL_SCANCODE_J:
-        return Cursor::Logic::Move_Cursor_Down(editor_data, is_lctrl_pressed);
-    case SDL_SCANCODE_K:
-        return Cursor::Logic::Move_Cursor_Up(editor_data, is_lctrl_pressed);
+    switch (command.operation) {
+    case Command_Line:
+    case Search_Forward:
+    case Search_Backward:
+        return Open_Command_Line(command);
 
+    case Record_Macro:
+        return Start_Recording(command.register_name);
+    case Replay_Macro:
+        return Replay(command.register_name, command.count);
     default:
+        return Input::Logic::Execute(editor_data, app_data, command);
+    }
+}
+
+
+auto
+Handler::Handle_Visual_Mode() -> bool
+{
+    if (code == SDL_SCANCODE_ESCAPE) {
+        m_sequence.Reset();
+        editor_data->mode = Editor::Normal;
+        return true;
+    }
+
+    if (is_lctrl_pressed) {
+        if (code == SDL_SCANCODE_V) return Input::Logic::Enter_Visual_Mode(editor_data, Editor::Visual_Block);
         return false;
     }
+
+    char key = Get_Key_Char();
+    if (key == '\0') return false;
+
+    Key_Command command;
+    if (m_sequence.Feed(m_keymap, key, &command, Visual_Keys) != Key_Sequence::Complete) return false;
+
+    return Input::Logic::Execute_Visual(editor_data, app_data, command);
+}
+
+
+auto
+Handler::Open_Command_Line(const Key_Command &command) -> bool
+{
+    char prompt = ':';
+    if (command.operation == Search_Forward) prompt = '/';
+    if (command.operation == Search_Backward) prompt = '?';
+
+    m_previous_pattern = editor_data->search.Get_Pattern();
+    m_was_backward = editor_data->search.Is_Backward();
+    command_handler->Set_Prompt(prompt);
+    return Input::Logic::Execute(editor_data, app_data, command);
+}
+
+
+void
+Handler::Record_Event(Recorded_Event event)
+{
+    if (m_recording_name == '\0' || m_replay_depth > 0) return;
+    m_recording.emplace_back(std::move(event));
+}
+
+
+auto
+Handler::Start_Recording(char name) -> bool
+{
+    if (std::isalnum(static_cast<unsigned char>(name)) == 0) return false;
+
+    m_recording_name = name;
+    m_recording.clear();
+    return true;
+}
+
+
+void
+Handler::Stop_Recording()
+{
+    /* Drops the key that stopped the recording */
+    if (!m_recording.empty()) m_recording.pop_back();
+
+    char name = static_cast<char>(std::tolower(static_cast<unsigned char>(m_recording_name)));
+    std::vector<Recorded_Event> &macro = m_macros[name];
+
+    if (std::isupper(static_cast<unsigned char>(m_recording_name)) != 0) {
+        macro.insert(macro.end(), std::make_move_iterator(m_recording.begin()), std::make_move_iterator(m_recording.end()));
+    } else {
+        macro = std::move(m_recording);
+    }
+
+    m_recording.clear();
+    m_recording_name = '\0';
+}
+
+
+auto
+Handler::Replay(char name, int64_t count) -> bool
+{
+    const int32_t MAX_REPLAY_DEPTH = 100;
+
+    if (name == '@') name = m_last_macro;
+    auto macro = m_macros.find(static_cast<char>(std::tolower(static_cast<unsigned char>(name))));
+    if (macro == m_macros.end() || macro->second.empty()) return false;
+
+    if (m_replay_depth >= MAX_REPLAY_DEPTH) {
+        Log::Err("Macro @{} is nested too deeply", name);
+        return false;
+    }
+    m_last_macro = name;
+
+    /* The macro may be re-recorded while it is replayed, so a copy is replayed instead */
+    std::vector<Recorded_Event> events = macro->second;
+    Editor::UI *editor = this->editor;
+    AppData *app_data = this->app_data;
+    Command::Handler *command_handler = this->command_handler;
+
+    bool was_headless = app_data->is_headless;
+    app_data->is_headless = true;
+    m_replay_depth++;
+
+    /* Whether each event should render is ignored, the caller renders once after the replay */
+    for (int64_t i = 0; i < count; i++) {
+        for (const auto &event : events) {
+            if (!event.text.empty()) Handle_Text_Input(event.text, editor, app_data, command_handler);
+            else Handle(event.code, event.mod, editor, app_data, command_handler);
+        }
+    }
+
+    m_replay_depth--;
+    app_data->is_headless = was_headless;
+    Flush_Motion(editor);
+
+    /* Text input is synced once with the mode the replay ended in */
+    Editor::Mode mode = editor->Get_Data()->mode;
+    Input::Logic::Set_Text_Input(app_data, mode == Editor::Insert || mode == Editor::Command);
+    return true;
 }
 
 
 auto
 Handler::Handle_Command_Mode(Command::Handler *command_handler, Editor::Data *editor_data) -> bool
 {
+    char prompt = command_handler->Get_Prompt();
+    bool is_search = (prompt != ':');
+
     switch (code) {
     case SDL_SCANCODE_RETURN: {
         std::string cmd(command_handler->Get_Command());
-        if (!Command::Logic::Handle(cmd, editor_data, app_data)) return false;
+        if (is_search) {
+            /* An empty pattern repeats the previous search */
+            if (cmd.empty()) editor_data->search.Start(editor_data, m_previous_pattern, prompt == '?');
+            Input::Logic::Find_Match(editor_data, false, 1);
+        } else if (!Command::Logic::Handle(cmd, editor_data, app_data)) {
+            return false;
+        }
         command_handler->Clear_Command();
 
         editor_data->mode = Editor::Normal;
@@ -155,12 +459,15 @@ Handler::Handle_Command_Mode(Command::Handler *command_handler, Editor::Data *ed
     }
 
     case SDL_SCANCODE_ESCAPE:
+        if (is_search) editor_data->search.Start(editor_data, m_previous_pattern, m_was_backward);
         command_handler->Clear_Command();
         editor_data->mode = Editor::Normal;
         return true;
 
     case SDL_SCANCODE_BACKSPACE:
-        return command_handler->Handle_Backspace();
+        if (!command_handler->Handle_Backspace()) return false;
+        if (is_search) editor_data->search.Start(editor_data, command_handler->Get_Command(), prompt == '?');
+        return true;
 
     default:
         return false;
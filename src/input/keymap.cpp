@@ -0,0 +1,377 @@
+#include <cctype>
+#include <array>
+
+#include "../../inc/logging_utility.hpp"
+#include "../../inc/config_parser.hpp"
+#include "../../inc/register.hpp"
+
+#include "../../inc/keymap.hpp"
+
+using Input::Key_Sequence;
+using Input::Keymap;
+
+
+namespace {
+    const uint32_t ROOT_COUNT = 3;
+    const int64_t MAX_COUNT = 999999999;
+
+    const std::unordered_map<std::string_view, Input::Action> ACTION_NAMES = {
+        { "left", Input::Left },
+        { "right", Input::Right },
+        { "down", Input::Down },
+        { "up", Input::Up },
+        { "word_forward", Input::Word_Forward },
+        { "word_backward", Input::Word_Backward },
+        { "word_end", Input::Word_End },
+        { "line_start", Input::Line_Start },
+        { "first_non_blank", Input::First_Non_Blank },
+        { "line_end", Input::Line_End },
+        { "file_start", Input::File_Start },
+        { "file_end", Input::File_End },
+        { "paragraph_forward", Input::Paragraph_Forward },
+        { "paragraph_backward", Input::Paragraph_Backward },
+
+        { "delete", Input::Delete },
+        { "yank", Input::Yank },
+        { "change", Input::Change },
+        { "indent", Input::Indent },
+        { "dedent", Input::Dedent },
+        { "lowercase", Input::Lowercase },
+        { "uppercase", Input::Uppercase },
+        { "toggle_case", Input::Toggle_Case },
+
+        { "inner_word", Input::Inner_Word },
+        { "a_word", Input::A_Word },
+        { "inner_paragraph", Input::Inner_Paragraph },
+        { "a_paragraph", Input::A_Paragraph },
+
+        { "insert_before", Input::Insert_Before },
+        { "append_after", Input::Append_After },
+        { "insert_line_start", Input::Insert_Line_Start },
+        { "append_line_end", Input::Append_Line_End },
+        { "open_below", Input::Open_Below },
+        { "open_above", Input::Open_Above },
+        { "delete_char", Input::Delete_Char },
+        { "delete_char_before", Input::Delete_Char_Before },
+        { "delete_to_end", Input::Delete_To_End },
+        { "change_to_end", Input::Change_To_End },
+        { "put_after", Input::Put_After },
+        { "put_before", Input::Put_Before },
+        { "join_lines", Input::Join_Lines },
+        { "undo", Input::Undo_Change },
+        { "command_line", Input::Command_Line },
+        { "record_macro", Input::Record_Macro },
+        { "replay_macro", Input::Replay_Macro },
+        { "visual", Input::Visual_Mode },
+        { "visual_line", Input::Visual_Line_Mode },
+        { "swap_anchor", Input::Swap_Anchor },
+        { "add_cursor_next_match", Input::Add_Cursor_Next_Match },
+        { "add_cursor_all_matches", Input::Add_Cursor_All_Matches },
+        { "add_cursor_below", Input::Add_Cursor_Below },
+        { "search_forward", Input::Search_Forward },
+        { "search_backward", Input::Search_Backward },
+        { "search_next", Input::Search_Next },
+        { "search_previous", Input::Search_Previous },
+    };
+
+    struct Binding {
+        std::string_view keys;
+        Input::Action action;
+    };
+
+    const std::array<Binding, 52> DEFAULT_BINDINGS = {
+        {
+            { "h", Input::Left },
+            { "l", Input::Right },
+            { "j", Input::Down },
+            { "k", Input::Up },
+            { "w", Input::Word_Forward },
+            { "b", Input::Word_Backward },
+            { "e", Input::Word_End },
+            { "0", Input::Line_Start },
+            { "^", Input::First_Non_Blank },
+            { "$", Input::Line_End },
+            { "gg", Input::File_Start },
+            { "G", Input::File_End },
+            { "}", Input::Paragraph_Forward },
+            { "{", Input::Paragraph_Backward },
+
+            { "d", Input::Delete },
+            { "y", Input::Yank },
+            { "c", Input::Change },
+            { ">", Input::Indent },
+            { "<", Input::Dedent },
+            { "gu", Input::Lowercase },
+            { "gU", Input::Uppercase },
+            { "g~", Input::Toggle_Case },
+
+            { "iw", Input::Inner_Word },
+            { "aw", Input::A_Word },
+            { "ip", Input::Inner_Paragraph },
+            { "ap", Input::A_Paragraph },
+
+            { "i", Input::Insert_Before },
+            { "a", Input::Append_After },
+            { "I", Input::Insert_Line_Start },
+            { "A", Input::Append_Line_End },
+            { "o", Input::Open_Below },
+            { "O", Input::Open_Above },
+            { "x", Input::Delete_Char },
+            { "X", Input::Delete_Char_Before },
+            { "D", Input::Delete_To_End },
+            { "C", Input::Change_To_End },
+            { "p", Input::Put_After },
+            { "P", Input::Put_Before },
+            { "J", Input::Join_Lines },
+            { "u", Input::Undo_Change },
+            { ":", Input::Command_Line },
+            { "q", Input::Record_Macro },
+            { "@", Input::Replay_Macro },
+            { "v", Input::Visual_Mode },
+            { "V", Input::Visual_Line_Mode },
+            { "gn", Input::Add_Cursor_Next_Match },
+            { "gA", Input::Add_Cursor_All_Matches },
+            { "gj", Input::Add_Cursor_Below },
+            { "/", Input::Search_Forward },
+            { "?", Input::Search_Backward },
+            { "n", Input::Search_Next },
+            { "N", Input::Search_Previous },
+        }
+    };
+
+    const std::array<Binding, 7> DEFAULT_VISUAL_BINDINGS = {
+        {
+            { "x", Input::Delete },
+            { "u", Input::Lowercase },
+            { "U", Input::Uppercase },
+            { "~", Input::Toggle_Case },
+            { "o", Input::Swap_Anchor },
+            { "v", Input::Visual_Mode },
+            { "V", Input::Visual_Line_Mode },
+        }
+    };
+} /* Anonymous namespace */
+
+
+auto
+Input::Get_Action_Type(Action action) -> Action_Type
+{
+    if (action >= Delete && action <= Toggle_Case) return Operator_Action;
+    if (action >= Inner_Word && action <= A_Paragraph) return Text_Object_Action;
+    if (action >= Insert_Before) return Command_Action;
+    return Motion_Action;
+}
+
+
+Keymap::Keymap()
+{ Clear(); }
+
+
+void
+Keymap::Clear()
+{
+    m_nodes.clear();
+    m_nodes.resize(ROOT_COUNT);
+}
+
+
+auto
+Keymap::Load(ConfigParser *config) -> bool
+{
+    Clear();
+    for (const auto &binding : DEFAULT_BINDINGS) {
+        Bind(binding.keys, binding.action);
+    }
+    for (const auto &binding : DEFAULT_VISUAL_BINDINGS) {
+        Bind_Visual(binding.keys, binding.action);
+    }
+
+    bool return_code = true;
+    for (std::string_view section : { "keymap", "visual_keymap" }) {
+        for (const auto &[keys, name] : config->Get_Section(section)) {
+            auto action = ACTION_NAMES.find(name);
+            if (action == ACTION_NAMES.end()) {
+                Log::Err("Unknown keymap action: {} = {}", keys, name);
+                return_code = false;
+                continue;
+            }
+
+            if (section == "keymap") Bind(keys, action->second);
+            else Bind_Visual(keys, action->second);
+        }
+    }
+    return return_code;
+}
+
+
+void
+Keymap::Bind(std::string_view keys, Action action)
+{
+    if (keys.empty()) return;
+
+    Action_Type type = Get_Action_Type(action);
+
+    /* Motions are valid both on their own and after an operator */
+    if (type != Text_Object_Action) Insert(Normal_Keys, keys, action);
+    if (type == Motion_Action || type == Text_Object_Action) Insert(Pending_Keys, keys, action);
+    if (type == Motion_Action || type == Operator_Action) Insert(Visual_Keys, keys, action);
+}
+
+
+void
+Keymap::Bind_Visual(std::string_view keys, Action action)
+{
+    if (!keys.empty()) Insert(Visual_Keys, keys, action);
+}
+
+
+void
+Keymap::Insert(uint32_t root, std::string_view keys, Action action)
+{
+    uint32_t node = root;
+    for (char key : keys) {
+        auto child = m_nodes.at(node).children.find(key);
+        if (child != m_nodes.at(node).children.end()) {
+            node = child->second;
+            continue;
+        }
+
+        m_nodes.emplace_back();
+        m_nodes.at(node).children.emplace(key, m_nodes.size() - 1);
+        node = m_nodes.size() - 1;
+    }
+    m_nodes.at(node).action = action;
+}
+
+
+auto
+Keymap::Find(std::string_view keys, Key_Mode mode, Action *action) const -> bool
+{
+    uint32_t node = mode;
+    *action = No_Action;
+
+    for (char key : keys) {
+        auto child = m_nodes.at(node).children.find(key);
+        if (child == m_nodes.at(node).children.end()) return false;
+        node = child->second;
+    }
+
+    *action = m_nodes.at(node).action;
+    return true;
+}
+
+
+auto
+Key_Sequence::Feed(const Keymap &keymap, char key, Key_Command *command, Key_Mode mode) -> Status
+{
+    if (m_argument_action != No_Action) {
+        *command = { m_argument_action, No_Action, m_operator_count, m_has_count, false, key };
+        Reset();
+        return Complete;
+    }
+
+    if (m_is_register_pending) {
+        m_is_register_pending = false;
+        if (!Register::Store::Is_Valid_Name(key)) {
+            Reset();
+            return Invalid;
+        }
+
+        m_register_name = key;
+        return Incomplete;
+    }
+
+    /* A register is selected before the operator, "a3dw */
+    if (key == '"' && m_keys.empty() && m_operator == No_Action) {
+        m_is_register_pending = true;
+        return Incomplete;
+    }
+
+    /* 0 is a motion unless a count is being typed */
+    if (m_keys.empty() && std::isdigit(key) != 0 && (key != '0' || !m_count.empty())) {
+        if (m_count.length() < std::to_string(MAX_COUNT).length()) m_count += key;
+        return Incomplete;
+    }
+
+    m_keys += key;
+
+    /* Doubled operators, such as dd or >>, act on whole lines */
+    if (m_operator != No_Action && m_keys == m_operator_keys) {
+        Commit_Count();
+        *command = { m_operator, No_Action, m_operator_count, m_has_count, true, m_register_name };
+        Reset();
+        return Complete;
+    }
+
+    Action action = No_Action;
+    bool operator_pending = (m_operator != No_Action);
+
+    if (!keymap.Find(m_keys, operator_pending ? Pending_Keys : mode, &action)) {
+        /* The operator's own keys may still be a prefix of the typed keys */
+        if (operator_pending && m_operator_keys.starts_with(m_keys)) return Incomplete;
+        Reset();
+        return Invalid;
+    }
+
+    if (action == No_Action) return Incomplete;
+
+    Commit_Count();
+    if (Get_Action_Type(action) == Operator_Action) {
+        if (mode == Visual_Keys) {
+            *command = { action, No_Action, m_operator_count, m_has_count, false, m_register_name };
+            Reset();
+            return Complete;
+        }
+
+        if (operator_pending) {
+            Reset();
+            return Invalid;
+        }
+
+        m_operator = action;
+        m_operator_keys = m_keys;
+        m_keys.clear();
+        return Incomplete;
+    }
+
+    if (m_operator == No_Action && (action == Record_Macro || action == Replay_Macro)) {
+        m_argument_action = action;
+        m_keys.clear();
+        return Incomplete;
+    }
+
+    *command = { m_operator, action, m_operator_count, m_has_count, false, m_register_name };
+    if (m_operator == No_Action) {
+        command->operation = action;
+        command->target = No_Action;
+    }
+
+    Reset();
+    return Complete;
+}
+
+
+void
+Key_Sequence::Commit_Count()
+{
+    if (m_count.empty()) return;
+
+    m_operator_count = std::min<int64_t>(m_operator_count * std::stoll(m_count), MAX_COUNT);
+    m_has_count = true;
+    m_count.clear();
+}
+
+
+void
+Key_Sequence::Reset()
+{
+    m_keys.clear();
+    m_count.clear();
+    m_operator_count = 1;
+    m_has_count = false;
+    m_operator = No_Action;
+    m_operator_keys.clear();
+    m_register_name = '"';
+    m_is_register_pending = false;
+    m_argument_action = No_Action;
+}
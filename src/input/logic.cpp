@@ -1,13 +1,51 @@
+#include <cstring>
+
+#include "../../inc/logging_utility.hpp"
+#include "../../inc/buffer.hpp"
+
 #include "../../inc/input.hpp"
 
 using Input::Logic;
 
 
+namespace {
+    /// Payloads this long are treated as a paste rather than typing
+    const size_t PASTE_THRESHOLD = 256;
+
+
+    auto
+    Has_Byte(std::string_view text, char byte) -> bool
+    { return std::memchr(text.data(), byte, text.length()) != nullptr; }
+
+
+    /// Converts CRLF line endings into LF and tabs into spaces, like File::Parse_File does
+    auto
+    Normalise_Text(std::string_view text, int64_t tab_size) -> std::string
+    {
+        std::string normalised;
+        normalised.reserve(text.length());
+
+        for (size_t i = 0; i < text.length(); i++) {
+            char c = text[i];
+            if (c == '\r' && i + 1 < text.length() && text[i + 1] == '\n') continue;
+
+            if (c == '\t') normalised.append(tab_size, ' ');
+            else normalised += c;
+        }
+        return normalised;
+    }
+} /* Anonymous namespace */
+
+
 auto
 Logic::Handle_Backspace(Editor::Data *editor_data, bool is_lctrl_pressed) -> bool
 {
     Position *cursor = &editor_data->cursor;
 
+    if (!editor_data->extra_cursors.empty()) {
+        return Edit_Cursors(editor_data, "", (is_lctrl_pressed ? Erase_Word_Before : Erase_Char_Before));
+    }
+
     if (cursor->Is_Zero()) return false;
 
     if (is_lctrl_pressed) {
@@ -16,21 +54,17 @@ Logic::Handle_Backspace(Editor::Data *editor_data, bool is_lctrl_pressed) -> boo
     }
 
     if (cursor->x <= 0 && cursor->y > 0) {
-        size_t moved_line_len = editor_data->file_content.at(cursor->y).length();
-
-        editor_data->file_content.at(cursor->y - 1)
-            .append(editor_data->file_content.at(cursor->y));
-        editor_data->file_content.erase(
-            editor_data->file_content.begin() + cursor->y
-        );
+        Position joined = {
+            static_cast<int64_t>(Cold::Lines(editor_data).at(cursor->y - 1).length()),
+            cursor->y - 1
+        };
 
-        cursor->y--;
-        cursor->x =
-            editor_data->file_content.at(cursor->y).length() - moved_line_len;
+        Buffer::Erase(editor_data, joined, *cursor);
+        *cursor = joined;
         return true;
     }
 
-    editor_data->file_content.at(cursor->y).erase(cursor->x - 1, 1);
+    Buffer::Erase(editor_data, { cursor->x - 1, cursor->y }, *cursor);
     cursor->x--;
     return true;
 }
@@ -40,27 +74,20 @@ void
 Logic::Handle_Ctrl_Backspace(Editor::Data *editor_data)
 {
     Position *cursor = &editor_data->cursor;
+    const std::string &line = Cold::Lines(editor_data).at(cursor->y);
+    int64_t word_start = cursor->x;
 
-    while (
-        cursor->x > 0 &&
-        Utils::Is_Word_Bound(
-            editor_data->file_content.at(cursor->y).at(cursor->x - 1)
-        )
-    ) {
-        editor_data->file_content.at(cursor->y).erase(cursor->x - 1, 1);
-        cursor->x--;
+    /* Finds the start of the word first, then erases it in one go */
+    while (word_start > 0 && Utils::Is_Word_Bound(line.at(word_start - 1))) {
+        word_start--;
     }
 
-    while (
-        cursor->x > 0 &&
-        !Utils::Is_Word_Bound(
-            editor_data->file_content.at(cursor->y).at(cursor->x - 1)
-        )
-    ) {
-        editor_data->file_content.at(cursor->y).erase(cursor->x - 1, 1);
-        cursor->x--;
+    while (word_start > 0 && !Utils::Is_Word_Bound(line.at(word_start - 1))) {
+        word_start--;
     }
 
+    Buffer::Erase(editor_data, { word_start, cursor->y }, *cursor);
+    cursor->x = word_start;
     editor_data->cursor_max_x = cursor->x;
 }
 
@@ -68,21 +95,69 @@ Logic::Handle_Ctrl_Backspace(Editor::Data *editor_data)
 auto
 Logic::Handle_Return(Editor::Data *editor_data) -> bool
 {
-    std::string_view line = editor_data->file_content.at(editor_data->cursor.y);
-    std::string insert_line;
+    if (!editor_data->extra_cursors.empty()) return Edit_Cursors(editor_data, "\n", Erase_Nothing);
+
+    editor_data->cursor = Buffer::Insert(editor_data, editor_data->cursor, "\n");
+    editor_data->cursor_max_x = 0;
+    return true;
+}
+
+
+auto
+Logic::Handle_Text_Input(Editor::Data *editor_data, AppData *app_data, std::string_view text) -> bool
+{
+    if (text.length() >= PASTE_THRESHOLD || Has_Byte(text, '\n') || Has_Byte(text, '\r')) {
+        return Paste(editor_data, app_data, text);
+    }
+
+    if (!editor_data->extra_cursors.empty()) return Edit_Cursors(editor_data, text, Erase_Nothing);
+
+    editor_data->cursor = Buffer::Insert(editor_data, editor_data->cursor, text);
+    editor_data->cursor_max_x = editor_data->cursor.x;
+    return true;
+}
+
+
+auto
+Logic::Paste(Editor::Data *editor_data, AppData *app_data, std::string_view text) -> bool
+{
+    if (text.empty()) return false;
+
+    /* Most pastes need no conversion, and are inserted straight from the source buffer */
+    std::string normalised;
+    if (Has_Byte(text, '\r') || Has_Byte(text, '\t')) {
+        normalised = Normalise_Text(text, app_data->config.Get_Int_Value("file", "tab_size"));
+        text = normalised;
+    }
 
-    if (!line.empty() || !Utils::Is_All_Space(line)) {
-        insert_line = line.substr(editor_data->cursor.x);
-        editor_data->file_content.at(editor_data->cursor.y).erase(editor_data->cursor.x);
+    /* The paste is split out of the current insert session, so it can be undone on its own */
+    bool is_grouped = (editor_data->mode == Editor::Insert);
+    if (is_grouped) editor_data->history.End_Group(editor_data->cursor);
+
+    if (!editor_data->extra_cursors.empty()) {
+        Edit_Cursors(editor_data, text, Erase_Nothing);
     } else {
-        insert_line = "";
+        editor_data->cursor = Buffer::Insert(editor_data, editor_data->cursor, text);
+        editor_data->cursor_max_x = editor_data->cursor.x;
     }
 
-    editor_data->file_content.insert(
-        editor_data->file_content.begin() + editor_data->cursor.y + 1,
-        insert_line
-    );
-    editor_data->cursor.y++;
-    editor_data->cursor.x = 0;
+    if (is_grouped) editor_data->history.Begin_Group(editor_data->cursor);
     return true;
-}
\ No newline at end of file
+}
+
+
+auto
+Logic::Paste_Clipboard(Editor::Data *editor_data, AppData *app_data) -> bool
+{
+    if (!SDL_HasClipboardText()) return false;
+
+    char *clipboard = SDL_GetClipboardText();
+    if (clipboard == nullptr) {
+        Log::Err("Failed to get clipboard text: {}", SDL_GetError());
+        return false;
+    }
+
+    bool should_render = Paste(editor_data, app_data, clipboard);
+    SDL_free(clipboard);
+    return should_render;
+}
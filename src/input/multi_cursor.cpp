@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cctype>
+
+#include "../../inc/cursor.hpp"
+#include "../../inc/buffer.hpp"
+
+#include "../../inc/input.hpp"
+
+using Input::Logic;
+
+/* Reading a line through Content thaws it, if it was compressed */
+using Content = Cold::Lines;
+
+
+namespace {
+    auto
+    Is_Word_Char(char c) -> bool
+    { return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_'; }
+
+
+    auto
+    Before(Position a, Position b) -> bool
+    { return a.Is_Before(b); }
+
+
+    /// Clamps position into the bounds of content, extra cursors are not moved by every edit
+    auto
+    Clamp(const Content &content, Position position) -> Position
+    {
+        int64_t y = std::clamp(position.y, 0L, std::max(static_cast<int64_t>(content.size()) - 1, 0L));
+        int64_t x = std::clamp(position.x, 0L, static_cast<int64_t>(content.at(y).length()));
+        return { x, y };
+    }
+
+
+    /// Finds the word under position
+    /// @returns false if position is not on a word
+    auto
+    Word_At(const Content &content, Position position, Position *start, int64_t *length) -> bool
+    {
+        const std::string &line = content.at(position.y);
+        if (position.x >= static_cast<int64_t>(line.length()) || !Is_Word_Char(line.at(position.x))) return false;
+
+        int64_t begin = position.x;
+        int64_t end = position.x;
+        while (begin > 0 && Is_Word_Char(line.at(begin - 1))) begin--;
+        while (end < static_cast<int64_t>(line.length()) && Is_Word_Char(line.at(end))) end++;
+
+        *start = { begin, position.y };
+        *length = end - begin;
+        return true;
+    }
+
+
+    /// Checks if word is found at x as a whole word
+    auto
+    Is_Whole_Word(const std::string &line, size_t x, size_t length) -> bool
+    {
+        if (x > 0 && Is_Word_Char(line.at(x - 1))) return false;
+        return x + length >= line.length() || !Is_Word_Char(line.at(x + length));
+    }
+
+
+    /// Finds the first whole word match of word after position, wrapping around the end of content
+    /// @returns false if there is no other match
+    auto
+    Find_Next_Word(const Content &content, std::string_view word, Position position, Position *match) -> bool
+    {
+        auto lines = static_cast<int64_t>(content.size());
+
+        /* The line of position is visited twice, after position first, then before it once wrapped */
+        for (int64_t i = 0; i <= lines; i++) {
+            int64_t y = (position.y + i) % lines;
+            const std::string &line = content.at(y);
+            size_t from = (i == 0 ? position.x + 1 : 0);
+
+            for (size_t x = line.find(word, from); x != std::string::npos; x = line.find(word, x + 1)) {
+                if (i == lines && static_cast<int64_t>(x) >= position.x) break;
+                if (!Is_Whole_Word(line, x, word.length())) continue;
+
+                *match = { static_cast<int64_t>(x), y };
+                return *match != position;
+            }
+        }
+        return false;
+    }
+} /* Anonymous namespace */
+
+
+auto
+Logic::Add_Cursors(Editor::Data *editor_data, Action action, int64_t count) -> bool
+{
+    const Content content(editor_data);
+    std::vector<Position> &extra_cursors = editor_data->extra_cursors;
+    Position *cursor = &editor_data->cursor;
+
+    if (action == Add_Cursor_Below) {
+        Position lowest = *cursor;
+        for (const auto &extra : extra_cursors) lowest = std::max(lowest, extra, Before);
+
+        int64_t last = std::min(lowest.y + count, static_cast<int64_t>(content.size()) - 1);
+        for (int64_t y = lowest.y + 1; y <= last; y++) {
+            extra_cursors.push_back(Clamp(content, { editor_data->cursor_max_x, y }));
+        }
+
+        Merge_Extra_Cursors(editor_data);
+        return last > lowest.y;
+    }
+
+    Position word_start;
+    int64_t length = 0;
+    if (!Word_At(content, *cursor, &word_start, &length)) return false;
+
+    std::string word = content.at(cursor->y).substr(word_start.x, length);
+    *cursor = word_start;
+    editor_data->cursor_max_x = cursor->x;
+
+    if (action == Add_Cursor_All_Matches) {
+        extra_cursors.clear();
+
+        /* Every line is searched without thawing it, only the lines edited later are */
+        Cold::Reader lines(editor_data);
+        for (size_t y = 0; y < lines.size(); y++) {
+            const std::string &line = lines.at(y);
+            for (size_t x = line.find(word); x != std::string::npos; x = line.find(word, x + word.length())) {
+                if (!Is_Whole_Word(line, x, word.length())) continue;
+                extra_cursors.push_back({ static_cast<int64_t>(x), static_cast<int64_t>(y) });
+            }
+        }
+
+        Merge_Extra_Cursors(editor_data);
+        return !extra_cursors.empty();
+    }
+
+    /* The cursor moves on to each new match, so the next match continues from it */
+    bool is_added = false;
+    for (int64_t i = 0; i < count; i++) {
+        Position match;
+        if (!Find_Next_Word(content, word, *cursor, &match)) break;
+        if (std::ranges::find(extra_cursors, match) != extra_cursors.end()) break;
+
+        extra_cursors.push_back(*cursor);
+        *cursor = match;
+        is_added = true;
+    }
+
+    if (!is_added) return false;
+
+    Merge_Extra_Cursors(editor_data);
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+void
+Logic::Move_Extra_Cursors(Editor::Data *editor_data, const Key_Command &command)
+{
+    if (editor_data->extra_cursors.empty()) return;
+
+    const Content content(editor_data);
+    Position cursor = editor_data->cursor;
+    int64_t cursor_max_x = editor_data->cursor_max_x;
+
+    for (auto &extra : editor_data->extra_cursors) {
+        extra = Clamp(content, extra);
+
+        switch (command.operation) {
+        case Append_After:
+            if (extra.x < static_cast<int64_t>(content.at(extra.y).length())) extra.x++;
+            break;
+        case Append_Line_End:
+            extra.x = static_cast<int64_t>(content.at(extra.y).length());
+            break;
+        case Insert_Line_Start:
+            extra.x = 0;
+            while (extra.x < static_cast<int64_t>(content.at(extra.y).length()) && content.at(extra.y).at(extra.x) == ' ') {
+                extra.x++;
+            }
+            break;
+
+        default:
+            /* Motions are found from the cursor, so each extra cursor takes its place in turn */
+            editor_data->cursor = extra;
+            extra = Clamp(content, Find_Motion_Target(editor_data, command));
+            extra.x = std::min(extra.x, Cursor::Logic::Line_End(editor_data, extra.y));
+            break;
+        }
+    }
+
+    editor_data->cursor = cursor;
+    editor_data->cursor_max_x = cursor_max_x;
+    Merge_Extra_Cursors(editor_data);
+}
+
+
+void
+Logic::Merge_Extra_Cursors(Editor::Data *editor_data)
+{
+    std::vector<Position> &extra_cursors = editor_data->extra_cursors;
+
+    std::ranges::sort(extra_cursors, Before);
+    auto duplicates = std::ranges::unique(extra_cursors);
+    extra_cursors.erase(duplicates.begin(), duplicates.end());
+
+    auto cursor = std::ranges::lower_bound(extra_cursors, editor_data->cursor, Before);
+    if (cursor != extra_cursors.end() && *cursor == editor_data->cursor) extra_cursors.erase(cursor);
+}
+
+
+auto
+Logic::Clear_Extra_Cursors(Editor::Data *editor_data) -> bool
+{
+    if (editor_data->extra_cursors.empty()) return false;
+
+    editor_data->extra_cursors.clear();
+    return true;
+}
+
+
+auto
+Logic::Edit_Cursors(Editor::Data *editor_data, std::string_view text, Cursor_Erase erase, int64_t count) -> bool
+{
+    const Content content(editor_data);
+    std::vector<Position> &extra_cursors = editor_data->extra_cursors;
+
+    /* The cursor takes part in the edit as one more extra cursor, found again by its index */
+    Merge_Extra_Cursors(editor_data);
+    auto at = std::ranges::lower_bound(extra_cursors, editor_data->cursor, Before);
+    auto cursor_index = static_cast<size_t>(at - extra_cursors.begin());
+    extra_cursors.insert(at, editor_data->cursor);
+
+    std::vector<Buffer::Edit> edits;
+    edits.reserve(extra_cursors.size());
+
+    for (auto &position : extra_cursors) {
+        position = Clamp(content, position);
+        Position start = position;
+        Position end = position;
+        const std::string &line = content.at(position.y);
+
+        switch (erase) {
+        case Erase_Char_Before:
+            if (start.x > 0) start.x--;
+            else if (start.y > 0) start = { static_cast<int64_t>(content.at(start.y - 1).length()), start.y - 1 };
+            break;
+
+        case Erase_Word_Before:
+            while (start.x > 0 && !Is_Word_Char(line.at(start.x - 1))) start.x--;
+            while (start.x > 0 && Is_Word_Char(line.at(start.x - 1))) start.x--;
+            break;
+
+        case Erase_Chars_After:
+            end.x = std::min(end.x + count, static_cast<int64_t>(line.length()));
+            break;
+
+        default:
+            break;
+        }
+
+        edits.push_back({ start, end, text });
+    }
+
+    std::vector<Position> ends = Buffer::Replace_All(editor_data, edits);
+
+    editor_data->cursor = ends.at(cursor_index);
+    editor_data->cursor_max_x = editor_data->cursor.x;
+    ends.erase(ends.begin() + static_cast<int64_t>(cursor_index));
+    extra_cursors = std::move(ends);
+
+    Merge_Extra_Cursors(editor_data);
+    Cursor::Logic::Scroll_To_Cursor(editor_data);
+    return true;
+}
@@ -0,0 +1,950 @@
+#include <algorithm>
+#include <cctype>
+
+#include "../../inc/logging_utility.hpp"
+#include "../../inc/cursor.hpp"
+#include "../../inc/buffer.hpp"
+
+#include "../../inc/input.hpp"
+
+using Input::Text_Range;
+using Input::Logic;
+
+/* Reading a line through Content thaws it, if it was compressed */
+using Content = Cold::Lines;
+
+
+namespace {
+    enum Char_Class : uint8_t {
+        Blank_Class,
+        Word_Class,
+        Punct_Class,
+    };
+
+
+    auto
+    Line_Length(const Content &content, int64_t y) -> int64_t
+    { return static_cast<int64_t>(content.at(y).length()); }
+
+
+    auto
+    Last_Line(const Content &content) -> int64_t
+    { return static_cast<int64_t>(content.size()) - 1; }
+
+
+    /// Line ends count as blank characters
+    auto
+    Class_At(const Content &content, Position position) -> Char_Class
+    {
+        const std::string &line = content.at(position.y);
+        if (position.x >= static_cast<int64_t>(line.length())) return Blank_Class;
+
+        auto c = static_cast<unsigned char>(line.at(position.x));
+        if (std::isspace(c) != 0) return Blank_Class;
+        if (std::isalnum(c) != 0 || c == '_') return Word_Class;
+        return Punct_Class;
+    }
+
+
+    auto
+    Is_Empty_Line(const Content &content, Position position) -> bool
+    { return position.x == 0 && content.at(position.y).empty(); }
+
+
+    /// Moves position one character forward, the line end is a position of its own
+    /// @returns false at the end of the content
+    auto
+    Next(const Content &content, Position *position) -> bool
+    {
+        if (position->x < Line_Length(content, position->y)) {
+            position->x++;
+            return true;
+        }
+        if (position->y >= Last_Line(content)) return false;
+
+        *position = { 0, position->y + 1 };
+        return true;
+    }
+
+
+    /// @returns false at the start of the content
+    auto
+    Previous(const Content &content, Position *position) -> bool
+    {
+        if (position->x > 0) {
+            position->x--;
+            return true;
+        }
+        if (position->y <= 0) return false;
+
+        *position = { Line_Length(content, position->y - 1), position->y - 1 };
+        return true;
+    }
+
+
+    auto
+    Next_Word_Start(const Content &content, Position position) -> Position
+    {
+        Char_Class start = Class_At(content, position);
+        if (start != Blank_Class) {
+            while (Class_At(content, position) == start) {
+                if (!Next(content, &position)) return position;
+            }
+        } else if (!Next(content, &position)) {
+            return position;
+        }
+
+        /* Empty lines are words of their own */
+        while (Class_At(content, position) == Blank_Class && !Is_Empty_Line(content, position)) {
+            if (!Next(content, &position)) break;
+        }
+        return position;
+    }
+
+
+    auto
+    Previous_Word_Start(const Content &content, Position position) -> Position
+    {
+        if (!Previous(content, &position)) return position;
+
+        while (Class_At(content, position) == Blank_Class && !Is_Empty_Line(content, position)) {
+            if (!Previous(content, &position)) return position;
+        }
+
+        Char_Class word = Class_At(content, position);
+        if (word == Blank_Class) return position;
+
+        Position previous = position;
+        while (Previous(content, &previous) && Class_At(content, previous) == word) {
+            position = previous;
+        }
+        return position;
+    }
+
+
+    auto
+    Find_Word_End(const Content &content, Position position) -> Position
+    {
+        if (!Next(content, &position)) return position;
+
+        while (Class_At(content, position) == Blank_Class) {
+            if (!Next(content, &position)) return position;
+        }
+
+        Char_Class word = Class_At(content, position);
+        Position next = position;
+        while (Next(content, &next) && Class_At(content, next) == word) {
+            position = next;
+        }
+        return position;
+    }
+
+
+    auto
+    Find_First_Non_Blank(const Content &content, int64_t y) -> int64_t
+    {
+        const std::string &line = content.at(y);
+        size_t x = line.find_first_not_of(" \t");
+        return (x == std::string::npos ? 0 : static_cast<int64_t>(x));
+    }
+
+
+    /// Returns the next / previous empty line after the current paragraph
+    auto
+    Paragraph_Bound(const Content &content, int64_t y, bool is_forward) -> Position
+    {
+        int64_t step = (is_forward ? 1 : -1);
+        int64_t bound = (is_forward ? Last_Line(content) : 0);
+
+        while (y != bound && content.at(y).empty()) y += step;
+        while (y != bound && !content.at(y).empty()) y += step;
+
+        if (is_forward && !content.at(y).empty()) return { Line_Length(content, y), y };
+        return { 0, y };
+    }
+
+
+    /// Extends last over the next block of either empty or non-empty lines
+    auto
+    Extend_Block(const Content &content, int64_t last) -> int64_t
+    {
+        if (last >= Last_Line(content)) return last;
+
+        bool is_empty = content.at(++last).empty();
+        while (last < Last_Line(content) && content.at(last + 1).empty() == is_empty) last++;
+        return last;
+    }
+
+
+    /// Changes the case of text between from and to (exclusive)
+    /// @returns true if any character changed
+    auto
+    Apply_Case(std::string &text, size_t from, size_t to, Input::Action operation) -> bool
+    {
+        bool is_changed = false;
+        for (size_t i = from; i < to; i++) {
+            auto c = static_cast<unsigned char>(text[i]);
+            int changed = c;
+
+            if (operation == Input::Lowercase) changed = std::tolower(c);
+            else if (operation == Input::Uppercase) changed = std::toupper(c);
+            else changed = (std::isupper(c) != 0 ? std::tolower(c) : std::toupper(c));
+
+            is_changed = is_changed || (changed != c);
+            text[i] = static_cast<char>(changed);
+        }
+        return is_changed;
+    }
+
+
+    /// Extends end (exclusive) over the next run of characters of the same class, within the line
+    auto
+    Extend_Run(const Content &content, Position end) -> Position
+    {
+        if (end.x >= Line_Length(content, end.y)) return end;
+
+        Char_Class run = Class_At(content, end);
+        while (end.x < Line_Length(content, end.y) && Class_At(content, end) == run) end.x++;
+        return end;
+    }
+} /* Anonymous namespace */
+
+
+auto
+Logic::Execute(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool
+{
+    switch (Input::Get_Action_Type(command.operation)) {
+    case Motion_Action:
+        Move_Extra_Cursors(editor_data, command);
+
+        switch (command.operation) {
+        case Left:
+            return Cursor::Logic::Move_Cursor_Columns(editor_data, -command.count);
+        case Right:
+            return Cursor::Logic::Move_Cursor_Columns(editor_data, command.count);
+        case Down:
+            return Cursor::Logic::Move_Cursor_Lines(editor_data, command.count);
+        case Up:
+            return Cursor::Logic::Move_Cursor_Lines(editor_data, -command.count);
+
+        default: {
+            Position target = Find_Motion_Target(editor_data, command);
+            if (target == editor_data->cursor) return false;
+
+            editor_data->cursor = target;
+            Settle_Cursor(editor_data);
+            return true;
+        }
+        }
+
+    case Operator_Action: {
+        Text_Range range;
+        if (command.is_linewise) {
+            int64_t last = std::min(editor_data->cursor.y + command.count - 1, Last_Line(Content(editor_data)));
+            range = { { 0, editor_data->cursor.y }, { 0, last }, true };
+        } else if (!Find_Range(editor_data, command, &range)) {
+            return false;
+        }
+        return Apply_Operator(editor_data, app_data, command.operation, range, command.register_name);
+    }
+
+    case Command_Action:
+        return Execute_Command(editor_data, app_data, command);
+
+    default:
+        return false;
+    }
+}
+
+
+auto
+Logic::Execute_Visual(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool
+{
+    switch (Input::Get_Action_Type(command.operation)) {
+    case Motion_Action:
+        return Execute(editor_data, app_data, command);
+
+    case Operator_Action:
+        break;
+
+    default:
+        switch (command.operation) {
+        case Visual_Mode:
+            return Enter_Visual_Mode(editor_data, Editor::Visual_Char);
+        case Visual_Line_Mode:
+            return Enter_Visual_Mode(editor_data, Editor::Visual_Line);
+
+        case Swap_Anchor:
+            std::swap(editor_data->cursor, editor_data->visual_start);
+            Settle_Cursor(editor_data);
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    const Content content(editor_data);
+    Position start = editor_data->visual_start;
+    Position end = editor_data->cursor;
+    if (end.Is_Before(start)) std::swap(start, end);
+
+    /* Operators end the selection, change goes on to insert mode */
+    editor_data->mode = Editor::Normal;
+
+    switch (editor_data->visual_type) {
+    case Editor::Visual_Line:
+        return Apply_Operator(
+            editor_data, app_data, command.operation, { { 0, start.y }, { 0, end.y }, true }, command.register_name
+        );
+
+    case Editor::Visual_Block:
+        return Apply_Block_Operator(editor_data, app_data, command.operation, command.register_name);
+
+    default:
+        /* The selection ends after the character under its end, or after the newline past the line end */
+        if (end.x < Line_Length(content, end.y)) end.x++;
+        else if (end.y < Last_Line(content)) end = { 0, end.y + 1 };
+
+        return Apply_Operator(editor_data, app_data, command.operation, { start, end, false }, command.register_name);
+    }
+}
+
+
+auto
+Logic::Enter_Visual_Mode(Editor::Data *editor_data, Editor::Visual_Type type) -> bool
+{
+    if (editor_data->mode == Editor::Visual && editor_data->visual_type == type) {
+        editor_data->mode = Editor::Normal;
+        return true;
+    }
+
+    if (editor_data->mode != Editor::Visual) editor_data->visual_start = editor_data->cursor;
+    editor_data->mode = Editor::Visual;
+    editor_data->visual_type = type;
+    return true;
+}
+
+
+auto
+Logic::Find_Match(Editor::Data *editor_data, bool is_reversed, int64_t count) -> bool
+{
+    Search::Searcher &search = editor_data->search;
+    bool is_backward = (search.Is_Backward() != is_reversed);
+
+    Position match;
+    if (!search.Find_Next(editor_data, editor_data->cursor, is_backward, count, &match)) {
+        if (!search.Get_Pattern().empty()) Log::Err("Pattern not found: {}", search.Get_Pattern());
+        return false;
+    }
+
+    editor_data->cursor = match;
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+void
+Logic::Enter_Insert_Mode(Editor::Data *editor_data, AppData *app_data)
+{
+    if (Buffer::Is_Read_Only(editor_data)) return;
+
+    Set_Text_Input(app_data, true);
+    editor_data->mode = Editor::Insert;
+    editor_data->history.Begin_Group(editor_data->cursor);
+}
+
+
+void
+Logic::Set_Text_Input(AppData *app_data, bool is_enabled)
+{
+    if (app_data->is_headless) return;
+
+    if (is_enabled) SDL_StartTextInput(app_data->window);
+    else SDL_StopTextInput(app_data->window);
+}
+
+
+auto
+Logic::Find_Motion_Target(Editor::Data *editor_data, const Key_Command &command) -> Position
+{
+    const Content content(editor_data);
+    Position cursor = editor_data->cursor;
+    Action motion = (command.target == No_Action ? command.operation : command.target);
+    int64_t count = command.count;
+
+    switch (motion) {
+    case Left:
+        return { std::max(cursor.x - count, 0L), cursor.y };
+    case Right:
+        return { std::min(cursor.x + count, Line_Length(content, cursor.y)), cursor.y };
+    case Down:
+        return { cursor.x, std::min(cursor.y + count, Last_Line(content)) };
+    case Up:
+        return { cursor.x, std::max(cursor.y - count, 0L) };
+
+    case Word_Forward:
+    case Word_Backward:
+    case Word_End:
+        for (int64_t i = 0; i < count; i++) {
+            Position next = cursor;
+            if (motion == Word_Forward) next = Next_Word_Start(content, cursor);
+            else if (motion == Word_Backward) next = Previous_Word_Start(content, cursor);
+            else next = Find_Word_End(content, cursor);
+
+            if (next == cursor) break;
+            cursor = next;
+        }
+        return cursor;
+
+    case Line_Start:
+        return { 0, cursor.y };
+    case First_Non_Blank:
+        return { Find_First_Non_Blank(content, cursor.y), cursor.y };
+    case Line_End: {
+        int64_t y = std::min(cursor.y + count - 1, Last_Line(content));
+        return { Line_Length(content, y), y };
+    }
+
+    case File_Start:
+    case File_End: {
+        int64_t y = (motion == File_Start ? 0 : Last_Line(content));
+        if (command.has_count) y = std::min(count - 1, Last_Line(content));
+        return { Find_First_Non_Blank(content, y), y };
+    }
+
+    case Paragraph_Forward:
+    case Paragraph_Backward:
+        for (int64_t i = 0; i < count; i++) {
+            Position next = Paragraph_Bound(content, cursor.y, motion == Paragraph_Forward);
+            if (next == cursor) break;
+            cursor = next;
+        }
+        return cursor;
+
+    default:
+        return cursor;
+    }
+}
+
+
+auto
+Logic::Find_Range(Editor::Data *editor_data, const Key_Command &command, Text_Range *range) -> bool
+{
+    const Content content(editor_data);
+    Position cursor = editor_data->cursor;
+    int64_t count = command.count;
+
+    switch (command.target) {
+    case Inner_Word:
+    case A_Word: {
+        if (content.at(cursor.y).empty()) return false;
+
+        Char_Class word = Class_At(content, cursor);
+        Position start = cursor;
+        while (start.x > 0 && Class_At(content, { start.x - 1, start.y }) == word) start.x--;
+
+        Position end = Extend_Run(content, cursor);
+        for (int64_t i = 1; i < count; i++) end = Extend_Run(content, end);
+
+        /* A word takes its trailing blanks, or the leading ones when there are none */
+        if (command.target == A_Word) {
+            Position blank_end = end;
+            while (
+                blank_end.x < Line_Length(content, end.y) &&
+                Class_At(content, blank_end) == Blank_Class
+            ) { blank_end.x++; }
+
+            if (blank_end == end) {
+                while (start.x > 0 && Class_At(content, { start.x - 1, start.y }) == Blank_Class) start.x--;
+            }
+            end = blank_end;
+        }
+
+        *range = { start, end, false };
+        return true;
+    }
+
+    case Inner_Paragraph:
+    case A_Paragraph: {
+        int64_t first = cursor.y;
+        int64_t last = cursor.y;
+        bool is_empty = content.at(cursor.y).empty();
+        while (first > 0 && content.at(first - 1).empty() == is_empty) first--;
+        while (last < Last_Line(content) && content.at(last + 1).empty() == is_empty) last++;
+
+        /* A paragraph takes the empty lines after it as well */
+        int64_t blocks = (command.target == A_Paragraph ? count * 2 : count);
+        for (int64_t i = 1; i < blocks; i++) last = Extend_Block(content, last);
+
+        *range = { { 0, first }, { 0, last }, true };
+        return true;
+    }
+
+    default:
+        break;
+    }
+
+    Key_Command motion = command;
+
+    /* cw on a word changes up to the end of the word, like ce */
+    if (
+        command.operation == Change &&
+        command.target == Word_Forward &&
+        Class_At(content, cursor) != Blank_Class
+    ) {
+        motion.target = Word_End;
+        if (Class_At(content, { cursor.x + 1, cursor.y }) != Class_At(content, cursor)) motion.count--;
+        if (motion.count == 0) {
+            *range = { cursor, { cursor.x + 1, cursor.y }, false };
+            return true;
+        }
+    }
+
+    Position target = Find_Motion_Target(editor_data, motion);
+
+    switch (motion.target) {
+    case Down:
+    case Up:
+    case File_Start:
+    case File_End:
+        *range = {
+            { 0, std::min(cursor.y, target.y) },
+            { 0, std::max(cursor.y, target.y) },
+            true
+        };
+        return true;
+
+    case Word_End:
+        target.x = std::min(target.x + 1, Line_Length(content, target.y));
+        *range = { cursor, target, false };
+        return cursor.Is_Before(target);
+
+    case Word_Forward:
+        /* dw on the last word of a line stops at the line end */
+        if (target.y > cursor.y && Find_First_Non_Blank(content, target.y) >= target.x) {
+            target = { Line_Length(content, target.y - 1), target.y - 1 };
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if (target.Is_Before(cursor)) *range = { target, cursor, false };
+    else *range = { cursor, target, false };
+    return !(range->start == range->end);
+}
+
+
+auto
+Logic::Apply_Operator(
+    Editor::Data *editor_data,
+    AppData *app_data,
+    Action operation,
+    Text_Range range,
+    char register_name
+) -> bool
+{
+    /* The registers copy their text out of the lines of the range and the newlines around it, read as they are */
+    editor_data->cold.Thaw(editor_data, range.start.y - 1, range.end.y + 1);
+    const std::vector<std::string> &lines = editor_data->file_content;
+    const Content content(editor_data);
+
+    if (operation == Indent || operation == Dedent) {
+        Shift_Lines(editor_data, app_data, range.start.y, range.end.y, operation == Dedent);
+        editor_data->cursor = { Find_First_Non_Blank(content, range.start.y), range.start.y };
+        Settle_Cursor(editor_data);
+        return true;
+    }
+
+    if (operation == Lowercase || operation == Uppercase || operation == Toggle_Case) {
+        Position start = range.start;
+        Position end = range.end;
+        if (range.is_linewise) end = { Line_Length(content, end.y), end.y };
+
+        std::string text = Buffer::Get_Text(lines, start, end);
+        if (!Apply_Case(text, 0, text.length(), operation)) return false;
+
+        Replace_Text(editor_data, start, end, text);
+        editor_data->cursor = start;
+        Settle_Cursor(editor_data);
+        return true;
+    }
+
+    Position start = range.start;
+    Position end = range.end;
+    bool has_newline_after = false;
+    bool has_newline_before = false;
+
+    if (range.is_linewise) {
+        int64_t first = range.start.y;
+        int64_t last = range.end.y;
+        start = { 0, first };
+        end = { Line_Length(content, last), last };
+
+        /* Whole lines also take one of their surrounding newlines, changed lines are kept empty */
+        if (operation == Delete) {
+            has_newline_after = (last < Last_Line(content));
+            has_newline_before = (!has_newline_after && first > 0);
+
+            if (has_newline_after) end = { 0, last + 1 };
+            if (has_newline_before) start = { Line_Length(content, first - 1), first - 1 };
+        }
+    } else if (start == end) {
+        if (operation != Change) return false;
+
+        Enter_Insert_Mode(editor_data, app_data);
+        return true;
+    }
+
+    if (operation == Yank) {
+        editor_data->registers.Yank(lines, register_name, start, end, range.is_linewise);
+        editor_data->cursor = (range.is_linewise ? Position(editor_data->cursor.x, range.start.y) : start);
+        Settle_Cursor(editor_data);
+        return true;
+    }
+
+    if (operation == Change) Enter_Insert_Mode(editor_data, app_data);
+
+    /* Linewise register text ends with its newline, wherever the erased newline was */
+    std::string erased = Buffer::Erase(editor_data, start, end);
+    if (range.is_linewise && !has_newline_after) {
+        if (has_newline_before) erased.erase(0, 1);
+        erased += '\n';
+    }
+    editor_data->registers.Delete(lines, register_name, std::move(erased), range.is_linewise);
+
+    if (range.is_linewise && operation == Delete) {
+        int64_t y = std::min(range.start.y, Last_Line(content));
+        editor_data->cursor = { Find_First_Non_Blank(content, y), y };
+    } else {
+        editor_data->cursor = { range.is_linewise ? 0 : start.x, range.start.y };
+    }
+
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+auto
+Logic::Execute_Command(Editor::Data *editor_data, AppData *app_data, const Key_Command &command) -> bool
+{
+    const Content content(editor_data);
+    Position *cursor = &editor_data->cursor;
+    int64_t line_len = Line_Length(content, cursor->y);
+
+    switch (command.operation) {
+    case Insert_Before:
+        Enter_Insert_Mode(editor_data, app_data);
+        return true;
+
+    case Append_After:
+        if (cursor->x < line_len) cursor->x++;
+        Move_Extra_Cursors(editor_data, command);
+        Enter_Insert_Mode(editor_data, app_data);
+        return true;
+
+    case Insert_Line_Start:
+        cursor->x = Find_First_Non_Blank(content, cursor->y);
+        Move_Extra_Cursors(editor_data, command);
+        Enter_Insert_Mode(editor_data, app_data);
+        return true;
+
+    case Append_Line_End:
+        cursor->x = line_len;
+        Move_Extra_Cursors(editor_data, command);
+        Enter_Insert_Mode(editor_data, app_data);
+        return true;
+
+    case Open_Below:
+        Enter_Insert_Mode(editor_data, app_data);
+        *cursor = Buffer::Insert(editor_data, { line_len, cursor->y }, "\n");
+        return true;
+
+    case Open_Above:
+        Enter_Insert_Mode(editor_data, app_data);
+        Buffer::Insert(editor_data, { 0, cursor->y }, "\n");
+        cursor->x = 0;
+        return true;
+
+    case Delete_Char:
+        if (!editor_data->extra_cursors.empty()) {
+            Edit_Cursors(editor_data, "", Erase_Chars_After, command.count);
+            Settle_Cursor(editor_data);
+            return true;
+        }
+
+        if (line_len == 0) return false;
+        return Apply_Operator(
+            editor_data, app_data, Delete,
+            { *cursor, { std::min(cursor->x + command.count, line_len), cursor->y }, false },
+            command.register_name
+        );
+
+    case Delete_Char_Before:
+        if (cursor->x == 0) return false;
+        return Apply_Operator(
+            editor_data, app_data, Delete,
+            { { std::max(cursor->x - command.count, 0L), cursor->y }, *cursor, false },
+            command.register_name
+        );
+
+    case Delete_To_End:
+    case Change_To_End: {
+        Key_Command motion = { command.operation, Line_End, command.count, command.has_count, false };
+        Position target = Find_Motion_Target(editor_data, motion);
+        Action operation = (command.operation == Delete_To_End ? Delete : Change);
+
+        if (operation == Delete && !cursor->Is_Before(target)) return false;
+        return Apply_Operator(editor_data, app_data, operation, { *cursor, target, false }, command.register_name);
+    }
+
+    case Put_After:
+    case Put_Before:
+        return Put(editor_data, command.count, command.operation == Put_Before, command.register_name);
+
+    case Join_Lines:
+        return Join(editor_data, std::max(command.count, 2L));
+
+    case Undo_Change: {
+        /* Extra cursors are not kept in the history */
+        bool should_render = Clear_Extra_Cursors(editor_data);
+        for (int64_t i = 0; i < command.count; i++) {
+            if (!editor_data->history.Undo(editor_data)) break;
+            should_render = true;
+        }
+        return should_render;
+    }
+
+    case Visual_Mode:
+        return Enter_Visual_Mode(editor_data, Editor::Visual_Char);
+    case Visual_Line_Mode:
+        return Enter_Visual_Mode(editor_data, Editor::Visual_Line);
+
+    case Add_Cursor_Next_Match:
+    case Add_Cursor_All_Matches:
+    case Add_Cursor_Below:
+        return Add_Cursors(editor_data, command.operation, command.count);
+
+    case Command_Line:
+    case Search_Forward:
+    case Search_Backward:
+        Set_Text_Input(app_data, true);
+        editor_data->mode = Editor::Command;
+        return true;
+
+    case Search_Next:
+    case Search_Previous:
+        return Find_Match(editor_data, command.operation == Search_Previous, command.count);
+
+    default:
+        return false;
+    }
+}
+
+
+auto
+Logic::Apply_Block_Operator(Editor::Data *editor_data, AppData *app_data, Action operation, char register_name) -> bool
+{
+    const Content content(editor_data);
+    Position anchor = editor_data->visual_start;
+    Position cursor = editor_data->cursor;
+
+    int64_t first = std::min(anchor.y, cursor.y);
+    int64_t last = std::max(anchor.y, cursor.y);
+    int64_t left = std::min(anchor.x, cursor.x);
+    int64_t right = std::max(anchor.x, cursor.x) + 1;
+
+    if (operation == Indent || operation == Dedent) {
+        return Apply_Operator(editor_data, app_data, operation, { { 0, first }, { 0, last }, true }, register_name);
+    }
+
+    /* The block lines are rebuilt into one text, so the whole block is a single replace */
+    std::string block;
+    std::string rebuilt;
+    bool is_changed = false;
+
+    for (int64_t y = first; y <= last; y++) {
+        const std::string &line = content.at(y);
+        size_t from = std::min<size_t>(left, line.length());
+        size_t to = std::min<size_t>(right, line.length());
+
+        if (y > first) block += '\n';
+        block.append(line, from, to - from);
+        if (operation == Yank) continue;
+
+        if (y > first) rebuilt += '\n';
+        size_t offset = rebuilt.length();
+        rebuilt += line;
+
+        if (operation == Delete || operation == Change) {
+            rebuilt.erase(offset + from, to - from);
+            is_changed = is_changed || (to > from);
+        } else if (Apply_Case(rebuilt, offset + from, offset + to, operation)) {
+            is_changed = true;
+        }
+    }
+
+    editor_data->cursor = { left, first };
+
+    if (operation == Yank) {
+        editor_data->registers.Yank_Text(editor_data->file_content, register_name, std::move(block), false);
+        Settle_Cursor(editor_data);
+        return true;
+    }
+
+    if (operation == Delete || operation == Change) {
+        editor_data->registers.Delete(editor_data->file_content, register_name, std::move(block), false);
+    }
+    if (operation == Change) Enter_Insert_Mode(editor_data, app_data);
+
+    if (is_changed) Replace_Text(editor_data, { 0, first }, { Line_Length(content, last), last }, rebuilt);
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+void
+Logic::Replace_Text(Editor::Data *editor_data, Position start, Position end, std::string_view text)
+{
+    editor_data->history.Begin_Group(editor_data->cursor);
+    Buffer::Erase(editor_data, start, end);
+    Buffer::Insert(editor_data, start, text);
+    editor_data->history.End_Group(start);
+}
+
+
+void
+Logic::Shift_Lines(Editor::Data *editor_data, AppData *app_data, int64_t first, int64_t last, bool is_dedent)
+{
+    const Content content(editor_data);
+    int64_t tab_size = app_data->config.Get_Int_Value("file", "tab_size");
+    std::string indent(tab_size, ' ');
+
+    /* The shifted lines are rebuilt into one text, so the whole range is a single replace */
+    std::string shifted;
+    bool is_changed = false;
+
+    for (int64_t y = first; y <= last; y++) {
+        const std::string &line = content.at(y);
+        if (y > first) shifted += '\n';
+
+        if (line.empty()) continue;
+
+        if (!is_dedent) {
+            shifted += indent;
+            shifted += line;
+            is_changed = true;
+            continue;
+        }
+
+        size_t blank = line.find_first_not_of(' ');
+        int64_t width = std::min(
+            (blank == std::string::npos ? Line_Length(content, y) : static_cast<int64_t>(blank)), tab_size
+        );
+        shifted.append(line, width);
+        is_changed = is_changed || (width > 0);
+    }
+
+    if (!is_changed) return;
+
+    editor_data->history.Begin_Group(editor_data->cursor);
+    Buffer::Erase(editor_data, { 0, first }, { Line_Length(content, last), last });
+    Buffer::Insert(editor_data, { 0, first }, shifted);
+    editor_data->history.End_Group({ Find_First_Non_Blank(content, first), first });
+}
+
+
+auto
+Logic::Join(Editor::Data *editor_data, int64_t count) -> bool
+{
+    const Content content(editor_data);
+    int64_t y = editor_data->cursor.y;
+    int64_t joins = std::min(count - 1, Last_Line(content) - y);
+    if (joins <= 0) return false;
+
+    /* The joined line is built once and replaces the joined lines in one edit, instead of one edit per join */
+    Position start = { Line_Length(content, y), y };
+    Position end = { Line_Length(content, y + joins), y + joins };
+    int64_t length = start.x;
+    std::string joined;
+    Position joint;
+
+    for (int64_t next = y + 1; next <= end.y; next++) {
+        joint = { length + static_cast<int64_t>(joined.length()), y };
+
+        const std::string &line = content.at(next);
+        size_t indent = line.find_first_not_of(" \t");
+        if (indent == std::string::npos) continue;
+
+        if (joint.x > 0) joined += ' ';
+        joined.append(line, indent);
+    }
+
+    editor_data->history.Begin_Group(editor_data->cursor);
+    Buffer::Erase(editor_data, start, end);
+    Buffer::Insert(editor_data, start, joined);
+    editor_data->cursor = joint;
+    editor_data->history.End_Group(joint);
+
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+auto
+Logic::Put(Editor::Data *editor_data, int64_t count, bool is_before, char register_name) -> bool
+{
+    const Content content(editor_data);
+    const Register::Entry *entry = editor_data->registers.Get(editor_data->file_content, register_name);
+    if (entry == nullptr) return false;
+
+    /* Holds a reference, so the text stays alive whatever happens to the register */
+    Register::Text shared = entry->text;
+    bool is_linewise = entry->is_linewise;
+
+    Position *cursor = &editor_data->cursor;
+    bool is_after_last_line = (is_linewise && !is_before && cursor->y == Last_Line(content));
+
+    Position position = *cursor;
+    if (is_linewise) position = { 0, is_before ? cursor->y : cursor->y + 1 };
+    if (is_after_last_line) position = { Line_Length(content, cursor->y), cursor->y };
+    if (!is_linewise && !is_before && Line_Length(content, cursor->y) > 0) position.x++;
+
+    /* The register text is inserted as is, it is only copied to repeat it or to move its newline */
+    std::string built;
+    std::string_view text = *shared;
+    if (count > 1 || is_after_last_line) {
+        built.reserve((text.length() * count) + 1);
+        if (is_after_last_line) built += '\n';
+        for (int64_t i = 0; i < count; i++) built += text;
+        if (is_after_last_line) built.pop_back();
+        text = built;
+    }
+
+    Position end = Buffer::Insert(editor_data, position, text);
+
+    if (is_linewise) {
+        int64_t y = (is_before ? cursor->y : cursor->y + 1);
+        *cursor = { Find_First_Non_Blank(content, y), y };
+    } else {
+        *cursor = end;
+        if (cursor->x > 0) cursor->x--;
+    }
+
+    Settle_Cursor(editor_data);
+    return true;
+}
+
+
+void
+Logic::Settle_Cursor(Editor::Data *editor_data)
+{
+    Position *cursor = &editor_data->cursor;
+    cursor->y = std::clamp(cursor->y, 0L, std::max(Last_Line(Content(editor_data)), 0L));
+    cursor->x = std::clamp(cursor->x, 0L, Cursor::Logic::Line_End(editor_data, cursor->y));
+
+    editor_data->cursor_max_x = cursor->x;
+    Cursor::Logic::Scroll_To_Cursor(editor_data);
+}
@@ -1,16 +1,23 @@
+#include <chrono>
+
 #include "../inc/argument_parser.hpp"
 #include "../inc/logging_utility.hpp"
 #include "../inc/config_parser.hpp"
 #include "../inc/file_handler.hpp"
 #include "../inc/sdl_helper.hpp"
+#include "../inc/bulk_io.hpp"
 #include "../inc/command.hpp"
 #include "../inc/editor.hpp"
+#include "../inc/codec.hpp"
 #include "../inc/input.hpp"
+#include "../inc/tasks.hpp"
 
 static const float ONE_SECOND_MS = 1000.0F;
+static const size_t MEBIBYTE = 1024 * 1024;
 static const char *const APP_NAME = "c+text";
 static const char *const APP_VERSION = "0.0.1";
 static const char *const APP_DESCRIPTION = "Simple Text Editor";
+static const int32_t BENCH_RUNS = 5;
 
 
 enum AppResult : uint8_t {
@@ -44,68 +51,77 @@ namespace {
     }
 
 
-    auto
-    Handle_Mouse_Wheel(SDL_MouseWheelEvent wheel_event, Editor::UI *editor_ui) -> bool
+    void
+    Handle_Mouse_Wheel(SDL_MouseWheelEvent wheel_event, Input::Handler *input_handler)
     {
-        auto direction = wheel_event.y;
-        auto *scroll = &editor_ui->Get_Data()->scroll;
+        if (wheel_event.y > 0) input_handler->Queue_Scroll(-1);
+        if (wheel_event.y < 0) input_handler->Queue_Scroll(1);
+    }
 
-        if (direction > 0 && scroll->y > 0) {
-            scroll->y--;
-            return true;
-        }
 
-        if (direction < 0 && scroll->y < static_cast<int64_t>(editor_ui->Get_Data()->file_content.size())) {
-            scroll->y++;
-            return true;
+    auto
+    Handle_Event(SDL_Event *event, AppData *app_data, Input::Handler *input_handler, Editor::UI *editor_ui, Command::Handler *command) -> AppResult
+    {
+        switch (event->type) {
+        case SDL_EVENT_QUIT:
+            return Exit_Success;
+
+        case SDL_EVENT_MOUSE_WHEEL:
+            Handle_Mouse_Wheel(event->wheel, input_handler);
+            return Continue_Skip;
+
+        case SDL_EVENT_TEXT_INPUT:
+            input_handler->Handle_Text_Input(event->text.text, editor_ui, app_data, command);
+            return Continue_Render;
+
+        case SDL_EVENT_KEY_DOWN:
+            return (
+                input_handler->Handle(
+                    event->key.scancode, event->key.mod, editor_ui, app_data, command
+                ) ? Continue_Render : Continue_Skip
+            );
+
+        case SDL_EVENT_WINDOW_RESIZED:
+            return Continue_Render;
+        default:
+            /* Background jobs finishing, their completions run here on the main thread */
+            if (Tasks::Is_Completion_Event(event)) return (Tasks::Run_Completions() ? Continue_Render : Continue_Skip);
+            return Continue_Skip;
         }
-
-        return false;
     }
 
 
     auto
     App_Event(SDL_Event *event, AppData *app_data, Input::Handler *input_handler, Editor::UI *editor_ui, Command::Handler *command) -> AppResult
     {
-        while (SDL_PollEvent(event)) {
-            switch (event->type) {
-            case SDL_EVENT_QUIT:
-                return Exit_Success;
-
-            case SDL_EVENT_MOUSE_WHEEL:
-                if (Handle_Mouse_Wheel(event->wheel, editor_ui)) {
-                    return Continue_Render;
-                } else { return Continue_Skip; }
-
-            case SDL_EVENT_TEXT_INPUT: {
-                auto *data = editor_ui->Get_Data();
-                std::string text = event->text.text;
-
-                if (data->mode == Editor::Command) {
-                    command->Update_Command(text);
-                    return Continue_Render;
-                }
-
-                if (data->mode == Editor::Insert) {
-                    data->file_content.at(data->cursor.y).insert(data->cursor.x, text);
-                    data->cursor.x += text.length();
-                    data->cursor_max_x = data->cursor.x;
-                }
-                return Continue_Render;
-            }
+        AppResult result = Continue_Skip;
 
-            case SDL_EVENT_KEY_DOWN:
-                return (
-                    input_handler->Handle(event->key.scancode, editor_ui, app_data, command) ? Continue_Render : Continue_Skip
-                );
+        /* Drains every pending event, so auto-repeat never builds a backlog of frames */
+        while (SDL_PollEvent(event)) {
+            AppResult event_result = Handle_Event(event, app_data, input_handler, editor_ui, command);
 
-            case SDL_EVENT_WINDOW_RESIZED:
-                return Continue_Render;
-            default:
-                return Continue_Skip;
-            }
+            if (event_result == Exit_Success || event_result == Exit_Failure) return event_result;
+            if (event_result == Continue_Render) result = Continue_Render;
         }
-        return Continue_Skip;
+
+        if (input_handler->Flush_Motion(editor_ui)) result = Continue_Render;
+
+        /* Lines scrolled into view since the last frame are thawed before the highlighter asks for them */
+        Editor::Data *data = editor_ui->Get_Data();
+        if (data->cold.Collect(data)) result = Continue_Render;
+
+        /* Matches found by the search worker since the last frame */
+        if (editor_ui->Get_Data()->search.Collect(editor_ui->Get_Data())) result = Continue_Render;
+
+        /* Lines appended to the file on disk since the last frame */
+        if (data->watcher != nullptr && data->watcher->Collect(data)) result = Continue_Render;
+
+        /* The viewer's window following the cursor */
+        if (data->viewer != nullptr && data->viewer->Collect(data)) result = Continue_Render;
+
+        /* Lines highlighted by the syntax worker since the last frame */
+        if (editor_ui->Get_Data()->syntax.Collect(editor_ui->Get_Data())) result = Continue_Render;
+        return result;
     }
 
 
@@ -143,7 +159,28 @@ namespace {
 
         /* Finding / getting the file to edit */
         std::string file_path;
-        arg_parser->Get_File_Path(config, file_path);
+        bool recover_swap = false;
+        arg_parser->Get_File_Path(config, file_path, &recover_swap);
+        bool is_stdin = (file_path == ArgParser::STDIN_PATH);
+
+        /* A compressed file is decompressed as a stream, like stdin, its lines show up as they are decoded */
+        Codec::Format file_format = (is_stdin ? Codec::Plain : Codec::Detect_File(file_path));
+        bool is_streamed = (is_stdin || file_format != Codec::Plain);
+
+        /* Files from view_threshold_mb up, or any with --view, are browsed read-only a window at a time */
+        bool is_viewed = false;
+        if (!is_streamed) {
+            std::error_code error;
+            uintmax_t size = std::filesystem::file_size(file_path, error);
+            int64_t view_threshold = config->Get_Int_Value("file", "view_threshold_mb");
+
+            is_viewed = (
+                arg_parser->Find_Arg({ "-R", "--view" }) ||
+                (!error && view_threshold > 0 && size >= static_cast<uintmax_t>(view_threshold) * MEBIBYTE)
+            );
+        } else if (arg_parser->Find_Arg({ "-R", "--view" })) {
+            Log::Err("Only plain files can be viewed, {} is loaded instead", file_path);
+        }
 
         if (!Editor::UI::Init(editor_ui, file_path, cursor_renderer, app_data->debug)) return false;
 
@@ -163,14 +200,107 @@ namespace {
             return false;
         }
 
-        auto buff = File::Parse_File(file_path, config->Get_Int_Value("file", "tab_size"));
+        /* Every background job shares one pool, started before any of them */
+        Tasks::Start();
+
+        auto load_start = std::chrono::steady_clock::now();
+        /* Streams start empty, their lines are appended as they arrive, the viewer loads its own window */
+        auto buff = (is_streamed || is_viewed ? std::vector<std::string>() : File::Parse_File(file_path, config->Get_Int_Value("file", "tab_size")));
+
+        if (app_data->debug) {
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - load_start;
+            std::error_code error;
+            uintmax_t bytes = std::filesystem::file_size(file_path, error);
+            if (error) bytes = 0;
+
+            Log::Debug(
+                stdout,
+                "Loaded {} lines ({} bytes) in {:.3f}s, {:.1f} MiB/s on {} workers\n",
+                buff.size(),
+                bytes,
+                seconds.count(),
+                static_cast<double>(bytes) / MEBIBYTE / std::max(seconds.count(), 1e-9),
+                Tasks::Get_Thread_Count()
+            );
+
+            Bulk_IO::Transfer transfer = Bulk_IO::Get_Last_Read();
+            if (transfer.bytes > 0) {
+                Log::Debug(
+                    stdout,
+                    "Read {} bytes with {} at {:.2f} GB/s\n",
+                    transfer.bytes,
+                    transfer.backend,
+                    transfer.Get_Gigabytes_Per_Second()
+                );
+            }
+        }
 
         if (buff.empty()) {
             editor_ui->Get_Data()->file_content.assign(1, "");
         } else {
-            editor_ui->Get_Data()->file_content = buff;
+            editor_ui->Get_Data()->file_content = std::move(buff);
         }
 
+        int64_t undo_memory_cap = config->Get_Int_Value("undo", "memory_cap");
+        if (undo_memory_cap > 0) {
+            editor_ui->Get_Data()->history.Set_Memory_Cap(undo_memory_cap * MEBIBYTE);
+        }
+
+        auto *data = editor_ui->Get_Data();
+        data->file_format = file_format;
+        uint64_t content_hash = Utils::Hash_Content(data->file_content);
+
+        /* The journal and the swap file describe the buffer against a file read whole, a stream is still arriving */
+        if (!is_streamed && !is_viewed && config->Get_Bool_Value("undo", "persistent")) {
+            data->history.Open_Journal(data->file_path, content_hash);
+        }
+
+        if (!is_streamed && !is_viewed && config->Get_Bool_Value("file", "swap")) {
+            /* The old swap file is read before the new one truncates it */
+            std::string records = (recover_swap ? Recovery::Read_Swap(data->file_path) : "");
+
+            data->swap = std::make_unique<Recovery::Swap_Writer>();
+            if (!data->swap->Open(data->file_path, content_hash, config->Get_Int_Value("file", "swap_interval_ms"))) {
+                data->swap.reset();
+            }
+
+            if (recover_swap) Recovery::Replay(records, content_hash, data);
+        }
+
+        if (is_viewed) {
+            data->viewer = std::make_unique<View::Viewer>();
+            if (!data->viewer->Open(data, config->Get_Int_Value("file", "tab_size"))) return false;
+        } else if (is_streamed || config->Get_Bool_Value("file", "watch")) {
+            int32_t tab_size = config->Get_Int_Value("file", "tab_size");
+            data->watcher = std::make_unique<Watch::Watcher>();
+
+            bool is_started = false;
+            if (is_stdin) is_started = data->watcher->Start_Stream(fileno(stdin), tab_size);
+            else if (is_streamed) is_started = data->watcher->Start_Decoding(data->file_path, tab_size);
+            else is_started = data->watcher->Start(data->file_path, tab_size, data->version);
+
+            if (!is_started) {
+                data->watcher.reset();
+            } else {
+                data->watcher->Set_Follow(config->Get_Bool_Value("file", "follow"));
+            }
+        }
+
+        /* app.log.gz is highlighted as app.log */
+        std::filesystem::path language_path = data->file_path;
+        if (file_format != Codec::Plain) language_path.replace_extension();
+        data->syntax.Start(data, Syntax::Find_Language(language_path));
+
+        int64_t index_lines = config->Get_Int_Value("editor", "search_index_lines");
+        if (!is_viewed && index_lines > 0 && static_cast<int64_t>(data->file_content.size()) >= index_lines) {
+            data->trigrams = std::make_unique<Trigram::Index>();
+            data->trigrams->Start(data);
+        }
+
+        /* The viewer only ever holds a small window of its file */
+        int64_t cold_budget_mb = config->Get_Int_Value("file", "cold_budget_mb");
+        if (!is_viewed && cold_budget_mb > 0) data->cold.Start(cold_budget_mb * MEBIBYTE);
+
         if (app_data->debug) {
             Log::Info("Initialitation completed, starting rendering process\n");
         } else {
@@ -178,6 +308,57 @@ namespace {
         }
         return true;
     }
+
+
+    /// Times File::Parse_File on file_path with 1 worker, then twice as many up to one per hardware thread.
+    //  Each worker count keeps the fastest of BENCH_RUNS loads, the first load also warms the page cache.
+    auto
+    Bench_Load(ConfigParser *config, std::string file_path) -> int32_t
+    {
+        if (!Utils::Is_Valid_File(file_path)) {
+            Log::Err("Failed to open file: {}", file_path);
+            return EXIT_FAILURE;
+        }
+
+        std::error_code error;
+        uintmax_t bytes = std::filesystem::file_size(file_path, error);
+        if (error) bytes = 0;
+        auto tab_size = static_cast<int32_t>(config->Get_Int_Value("file", "tab_size"));
+
+        uint32_t max_workers = std::max(std::thread::hardware_concurrency(), 1U);
+        std::vector<uint32_t> worker_counts;
+        for (uint32_t workers = 1; workers < max_workers; workers *= 2) worker_counts.push_back(workers);
+        worker_counts.push_back(max_workers);
+
+        std::println("Loading {} ({} bytes), best of {} runs", file_path, bytes, BENCH_RUNS);
+        std::println("{:>8} {:>10} {:>10} {:>10} {:>8}", "workers", "lines", "seconds", "MiB/s", "speedup");
+
+        double single_seconds = 0;
+        for (uint32_t workers : worker_counts) {
+            Tasks::Start(workers);
+
+            size_t lines = 0;
+            double best_seconds = 0;
+            for (int32_t run = 0; run < BENCH_RUNS; run++) {
+                auto start = std::chrono::steady_clock::now();
+                lines = File::Parse_File(file_path, tab_size).size();
+                std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+                if (run == 0 || seconds.count() < best_seconds) best_seconds = seconds.count();
+            }
+            Tasks::Stop();
+
+            if (workers == 1) single_seconds = best_seconds;
+            std::println(
+                "{:>8} {:>10} {:>10.3f} {:>10.1f} {:>7.2f}x",
+                workers,
+                lines,
+                best_seconds,
+                static_cast<double>(bytes) / MEBIBYTE / std::max(best_seconds, 1e-9),
+                single_seconds / std::max(best_seconds, 1e-9)
+            );
+        }
+        return EXIT_SUCCESS;
+    }
 } /* Anonymous namespace */
 
 
@@ -202,6 +383,10 @@ main(int32_t argc, char **argv) -> int32_t
     ConfigParser config;
     if (!ConfigParser::Init_Config(&config, &arg_parser, debug)) return EXIT_FAILURE;
 
+    /* Only measures how fast a file loads, nothing is opened */
+    std::string bench_path;
+    if (arg_parser.Option_Arg(bench_path, { "-b", "--bench-load" })) return Bench_Load(&config, bench_path);
+
     // if (!Utils::Is_Instance_Alone()) {
     //     std::string file_path;
     //     if (!arg_parser.Get_File_Path(&config, file_path)) return EXIT_FAILURE;
@@ -213,6 +398,7 @@ main(int32_t argc, char **argv) -> int32_t
     if (!App_Init(&app_data, &editor_ui, &cursor_renderer, &command, &config, &arg_parser)) {
         return EXIT_FAILURE;
     }
+    input_handler.Init(&config);
 
     /* Rendering */
     AppResult result = Continue_Render;
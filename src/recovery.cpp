@@ -0,0 +1,310 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <array>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "../inc/logging_utility.hpp"
+#include "../inc/buffer.hpp"
+#include "../inc/editor.hpp"
+
+#include "../inc/recovery.hpp"
+
+using Recovery::Swap_Writer;
+
+
+namespace {
+    const std::array<char, 8> SWAP_MAGIC = { 'C', 'T', 'S', 'W', 'A', 'P', '0', '1' };
+    const size_t SWAP_HEADER_SIZE = SWAP_MAGIC.size() + sizeof(uint64_t);
+
+    enum Record_Type : uint8_t {
+        Insert_Record = 1,
+        Erase_Record = 2,
+    };
+
+    /// type, start x, start y, end x / text length, end y
+    const size_t RECORD_HEADER_SIZE = sizeof(uint8_t) + (4 * sizeof(int64_t));
+
+    /// Flush interval used when the configured one is missing or not positive, which would flush without pause
+    const int64_t DEFAULT_INTERVAL_MS = 1000;
+
+
+    void
+    Write_Int(std::string &buffer, uint64_t value)
+    { buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+
+    auto
+    Read_Int(const char *data) -> int64_t
+    {
+        int64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+
+    auto
+    Make_Header(uint64_t content_hash) -> std::string
+    {
+        std::string header(SWAP_MAGIC.data(), SWAP_MAGIC.size());
+        Write_Int(header, content_hash);
+        return header;
+    }
+
+
+    /// Checks if position is on a line of content, at most right after its last character
+    auto
+    Is_In_Content(const std::vector<std::string> &content, Position position) -> bool
+    {
+        if (position.y < 0 || position.y >= static_cast<int64_t>(content.size())) return false;
+        return position.x >= 0 && position.x <= static_cast<int64_t>(content[position.y].length());
+    }
+
+
+    auto
+    Write_All(int32_t fd, std::string_view data) -> bool
+    {
+        while (!data.empty()) {
+            ssize_t result = write(fd, data.data(), data.length());
+            if (result <= 0) return false;
+            data.remove_prefix(result);
+        }
+        return true;
+    }
+} /* Anonymous namespace */
+
+
+namespace Recovery {
+    auto
+    Swap_Path(const std::filesystem::path &file_path) -> std::filesystem::path
+    {
+        std::filesystem::path swap_path = file_path;
+        return swap_path.replace_filename("." + file_path.filename().string() + ".swp");
+    }
+
+
+    auto
+    Prompt_Recovery(const std::filesystem::path &swap_path) -> bool
+    {
+        if (isatty(STDIN_FILENO) == 0) {
+            Log::Err("Found swap file {}, stdin is not a terminal, skipping recovery", swap_path.string());
+            return false;
+        }
+
+        std::print(
+            "\n{}Found swap file{} {}, recover unsaved changes? [y/N]: ",
+            Color::Bold_Yellow, Color::Reset, swap_path.string()
+        );
+        std::fflush(stdout);
+
+        std::string answer;
+        std::getline(std::cin, answer);
+        Utils::Trim_String(answer, All);
+        return answer == "y" || answer == "Y" || answer == "yes";
+    }
+
+
+    auto
+    Read_Swap(const std::filesystem::path &file_path) -> std::string
+    {
+        std::ifstream swap_file(Swap_Path(file_path), std::ios::binary);
+        if (!swap_file.is_open()) return "";
+
+        return { std::istreambuf_iterator<char>(swap_file), std::istreambuf_iterator<char>() };
+    }
+
+
+    auto
+    Replay(std::string_view records, uint64_t content_hash, Editor::Data *editor_data) -> bool
+    {
+        if (
+            records.length() < SWAP_HEADER_SIZE ||
+            std::memcmp(records.data(), SWAP_MAGIC.data(), SWAP_MAGIC.size()) != 0
+        ) {
+            Log::Err("Invalid swap file");
+            return false;
+        }
+
+        if (static_cast<uint64_t>(Read_Int(records.data() + SWAP_MAGIC.size())) != content_hash) {
+            Log::Err("File has changed since the swap file was written, skipping recovery");
+            return false;
+        }
+
+        editor_data->history.Begin_Group(editor_data->cursor);
+        records.remove_prefix(SWAP_HEADER_SIZE);
+
+        /* A torn record at the end is the batch that was being written during the crash.
+        // A record that does not fit the buffer means the file is damaged, the changes before it are kept. */
+        int64_t replayed = 0;
+        bool is_damaged = false;
+        while (records.length() >= RECORD_HEADER_SIZE) {
+            auto type = static_cast<Record_Type>(records.front());
+            Position start = { Read_Int(records.data() + 1), Read_Int(records.data() + 9) };
+            int64_t third = Read_Int(records.data() + 17);
+            int64_t fourth = Read_Int(records.data() + 25);
+            records.remove_prefix(RECORD_HEADER_SIZE);
+
+            const std::vector<std::string> &content = editor_data->file_content;
+            if (type == Insert_Record) {
+                if (third < 0 || !Is_In_Content(content, start)) {
+                    is_damaged = true;
+                    break;
+                }
+                if (records.length() < static_cast<uint64_t>(third)) break;
+
+                editor_data->cursor = Buffer::Insert(editor_data, start, records.substr(0, third));
+                records.remove_prefix(third);
+            } else if (type == Erase_Record) {
+                Position end = { third, fourth };
+                if (!Is_In_Content(content, start) || !Is_In_Content(content, end) || end.Is_Before(start)) {
+                    is_damaged = true;
+                    break;
+                }
+
+                Buffer::Erase(editor_data, start, end);
+                editor_data->cursor = start;
+            } else {
+                is_damaged = true;
+                break;
+            }
+            replayed++;
+        }
+
+        editor_data->history.End_Group(editor_data->cursor);
+        if (is_damaged) Log::Err("Swap file is damaged, recovered the {} changes before the damage", replayed);
+        else Log::Info("Recovered {} changes from the swap file\n", replayed);
+        return true;
+    }
+} /* namespace Recovery */
+
+
+Swap_Writer::~Swap_Writer()
+{
+    Stop();
+
+    /* Unsaved changes are kept on disk so they can be recovered on the next start */
+    if (m_fd >= 0) {
+        close(m_fd);
+        if (!m_is_dirty) std::filesystem::remove(m_swap_path);
+    }
+}
+
+
+auto
+Swap_Writer::Open(const std::filesystem::path &file_path, uint64_t content_hash, int64_t interval_ms) -> bool
+{
+    m_swap_path = Swap_Path(file_path);
+    m_fd = open(m_swap_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+
+    if (m_fd < 0 || !Write_All(m_fd, Make_Header(content_hash))) {
+        Log::Err("Failed to create swap file: {}", m_swap_path.string());
+        return false;
+    }
+
+    if (interval_ms <= 0) interval_ms = DEFAULT_INTERVAL_MS;
+    m_is_running = true;
+    m_thread = std::thread(&Swap_Writer::Writer_Loop, this, std::chrono::milliseconds(interval_ms));
+    return true;
+}
+
+
+void
+Swap_Writer::Record_Insert(Position position, std::string_view text)
+{
+    std::lock_guard lock(m_mutex);
+    m_pending.push_back(Insert_Record);
+    Write_Int(m_pending, position.x);
+    Write_Int(m_pending, position.y);
+    Write_Int(m_pending, text.length());
+    Write_Int(m_pending, 0);
+    m_pending.append(text);
+    m_is_dirty = true;
+}
+
+
+void
+Swap_Writer::Record_Erase(Position start, Position end)
+{
+    std::lock_guard lock(m_mutex);
+    m_pending.push_back(Erase_Record);
+    Write_Int(m_pending, start.x);
+    Write_Int(m_pending, start.y);
+    Write_Int(m_pending, end.x);
+    Write_Int(m_pending, end.y);
+    m_is_dirty = true;
+}
+
+
+void
+Swap_Writer::Reset(uint64_t content_hash)
+{
+    if (m_fd < 0) return;
+
+    std::lock_guard file_lock(m_file_mutex);
+    std::lock_guard lock(m_mutex);
+    m_pending.clear();
+    m_is_dirty = false;
+
+    if (ftruncate(m_fd, 0) != 0 || !Write_All(m_fd, Make_Header(content_hash))) {
+        Log::Err("Failed to reset swap file: {}", m_swap_path.string());
+    }
+}
+
+
+void
+Swap_Writer::Remove()
+{
+    Stop();
+    if (m_fd < 0) return;
+
+    close(m_fd);
+    m_fd = -1;
+    std::filesystem::remove(m_swap_path);
+}
+
+
+void
+Swap_Writer::Writer_Loop(std::chrono::milliseconds interval)
+{
+    std::unique_lock lock(m_mutex);
+    while (m_is_running) {
+        m_condition.wait_for(lock, interval, [this]{ return !m_is_running; });
+
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+}
+
+
+void
+Swap_Writer::Flush()
+{
+    std::lock_guard file_lock(m_file_mutex);
+    std::string batch;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_pending.empty()) return;
+        batch.swap(m_pending);
+    }
+
+    if (!Write_All(m_fd, batch) || fdatasync(m_fd) != 0) {
+        Log::Err("Failed to write swap file: {}", m_swap_path.string());
+    }
+}
+
+
+void
+Swap_Writer::Stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_is_running) return;
+        m_is_running = false;
+    }
+
+    m_condition.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
\ No newline at end of file
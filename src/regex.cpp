@@ -0,0 +1,639 @@
+#include <algorithm>
+#include <cctype>
+
+#include "../inc/logging_utility.hpp"
+
+#include "../inc/regex.hpp"
+
+using Regex::Byte_Set;
+using Regex::Matcher;
+using Regex::Dfa;
+
+
+namespace {
+    const int32_t MAX_REPEAT = 1000;
+    const int32_t MAX_DEPTH = 256;
+    const size_t MAX_NFA_STATES = 1 << 20;
+
+    enum Node_Type : uint8_t {
+        Empty_Node,
+        Set_Node,
+        Concat_Node,
+        Alternate_Node,
+        Repeat_Node,
+        Line_Start_Node,
+        Line_End_Node,
+    };
+
+    struct Node {
+        Node_Type type = Empty_Node;
+        Byte_Set set;
+        std::vector<Node> children;
+        int32_t min = 0;
+
+        /// -1 is unbounded
+        int32_t max = -1;
+    };
+
+
+    class
+    Parser
+    {
+    public:
+        explicit Parser(std::string_view pattern) : m_pattern(pattern) {}
+
+        auto
+        Parse(Node *root) -> bool
+        {
+            if (!Parse_Alternation(root)) return false;
+            if (m_pos < m_pattern.length()) return Fail("unmatched )");
+            return true;
+        }
+
+        [[nodiscard]]
+        auto Get_Error() const -> std::string_view
+        { return m_error; }
+
+    private:
+        std::string_view m_pattern;
+        size_t m_pos = 0;
+        int32_t m_depth = 0;
+        std::string m_error;
+
+        auto
+        Fail(std::string_view error) -> bool
+        {
+            m_error = error;
+            return false;
+        }
+
+        [[nodiscard]]
+        auto Is_At(char c) const -> bool
+        { return m_pos < m_pattern.length() && m_pattern[m_pos] == c; }
+
+        auto
+        Parse_Alternation(Node *node) -> bool
+        {
+            Node branch;
+            if (!Parse_Concat(&branch)) return false;
+            if (!Is_At('|')) {
+                *node = std::move(branch);
+                return true;
+            }
+
+            node->type = Alternate_Node;
+            node->children.push_back(std::move(branch));
+            while (Is_At('|')) {
+                m_pos++;
+                if (!Parse_Concat(&branch)) return false;
+                node->children.push_back(std::move(branch));
+            }
+            return true;
+        }
+
+        auto
+        Parse_Concat(Node *node) -> bool
+        {
+            *node = Node();
+            node->type = Concat_Node;
+
+            while (m_pos < m_pattern.length() && !Is_At('|') && !Is_At(')')) {
+                Node atom;
+                if (!Parse_Repeat(&atom)) return false;
+                node->children.push_back(std::move(atom));
+            }
+            return true;
+        }
+
+        auto
+        Parse_Repeat(Node *node) -> bool
+        {
+            if (!Parse_Atom(node)) return false;
+
+            while (m_pos < m_pattern.length()) {
+                int32_t min = 0;
+                int32_t max = -1;
+
+                switch (m_pattern[m_pos]) {
+                case '*':
+                    m_pos++;
+                    break;
+                case '+':
+                    min = 1;
+                    m_pos++;
+                    break;
+                case '?':
+                    max = 1;
+                    m_pos++;
+                    break;
+                case '{':
+                    if (!Parse_Bounds(&min, &max)) return false;
+                    break;
+                default:
+                    return true;
+                }
+
+                if (node->type == Line_Start_Node || node->type == Line_End_Node) return Fail("nothing to repeat");
+
+                Node repeat;
+                repeat.type = Repeat_Node;
+                repeat.min = min;
+                repeat.max = max;
+                repeat.children.push_back(std::move(*node));
+                *node = std::move(repeat);
+            }
+            return true;
+        }
+
+        auto
+        Parse_Bounds(int32_t *min, int32_t *max) -> bool
+        {
+            m_pos++;
+            if (!Parse_Number(min)) return Fail("expected a count inside {}");
+
+            *max = *min;
+            if (Is_At(',')) {
+                m_pos++;
+                *max = -1;
+                if (!Is_At('}') && !Parse_Number(max)) return Fail("expected a count inside {}");
+            }
+
+            if (!Is_At('}')) return Fail("missing }");
+            m_pos++;
+
+            if (*max >= 0 && *max < *min) return Fail("{} bounds are reversed");
+            return true;
+        }
+
+        auto
+        Parse_Number(int32_t *number) -> bool
+        {
+            size_t start = m_pos;
+            *number = 0;
+
+            while (m_pos < m_pattern.length() && std::isdigit(static_cast<unsigned char>(m_pattern[m_pos])) != 0) {
+                *number = (*number * 10) + (m_pattern[m_pos++] - '0');
+                if (*number > MAX_REPEAT) return false;
+            }
+            return m_pos > start;
+        }
+
+        auto
+        Parse_Atom(Node *node) -> bool
+        {
+            char c = m_pattern[m_pos++];
+
+            switch (c) {
+            case '(':
+                if (++m_depth > MAX_DEPTH) return Fail("groups are nested too deeply");
+                if (!Parse_Alternation(node)) return false;
+                if (!Is_At(')')) return Fail("missing )");
+                m_pos++;
+                m_depth--;
+                return true;
+
+            case '.':
+                node->type = Set_Node;
+                node->set.set();
+                return true;
+
+            case '[':
+                return Parse_Class(node);
+
+            case '^':
+                node->type = Line_Start_Node;
+                return true;
+            case '$':
+                node->type = Line_End_Node;
+                return true;
+
+            case '\\':
+                node->type = Set_Node;
+                return Parse_Escape(&node->set);
+
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                return Fail("nothing to repeat");
+
+            default:
+                node->type = Set_Node;
+                node->set.set(static_cast<uint8_t>(c));
+                return true;
+            }
+        }
+
+        auto
+        Parse_Escape(Byte_Set *set) -> bool
+        {
+            if (m_pos >= m_pattern.length()) return Fail("trailing \\");
+            char c = m_pattern[m_pos++];
+
+            switch (std::tolower(static_cast<unsigned char>(c))) {
+            case 'd':
+                for (int32_t byte = '0'; byte <= '9'; byte++) set->set(byte);
+                break;
+            case 'w':
+                for (int32_t byte = 0; byte < 256; byte++) {
+                    if (std::isalnum(byte) != 0 || byte == '_') set->set(byte);
+                }
+                break;
+            case 's':
+                for (char byte : std::string_view(" \t\r\n\v\f")) set->set(static_cast<uint8_t>(byte));
+                break;
+            case 't':
+                set->set('\t');
+                return true;
+
+            default:
+                set->set(static_cast<uint8_t>(c));
+                return true;
+            }
+
+            /* \D \W \S are the complements */
+            if (std::isupper(static_cast<unsigned char>(c)) != 0) set->flip();
+            return true;
+        }
+
+        auto
+        Parse_Class(Node *node) -> bool
+        {
+            node->type = Set_Node;
+            bool is_negated = Is_At('^');
+            if (is_negated) m_pos++;
+
+            /* A ] right after the opening bracket is a literal */
+            bool is_first = true;
+            while (m_pos < m_pattern.length() && (is_first || !Is_At(']'))) {
+                is_first = false;
+
+                uint8_t low = 0;
+                if (Is_At('\\')) {
+                    m_pos++;
+                    Byte_Set escaped;
+                    if (!Parse_Escape(&escaped)) return false;
+
+                    if (escaped.count() != 1) {
+                        node->set |= escaped;
+                        continue;
+                    }
+                    while (!escaped.test(low)) low++;
+                } else {
+                    low = static_cast<uint8_t>(m_pattern[m_pos++]);
+                }
+
+                if (!Is_At('-') || m_pos + 1 >= m_pattern.length() || m_pattern[m_pos + 1] == ']') {
+                    node->set.set(low);
+                    continue;
+                }
+
+                m_pos++;
+                auto high = static_cast<uint8_t>(m_pattern[m_pos++]);
+                if (high < low) return Fail("character range is reversed");
+                for (int32_t byte = low; byte <= high; byte++) node->set.set(byte);
+            }
+
+            if (!Is_At(']')) return Fail("missing ]");
+            m_pos++;
+
+            if (is_negated) node->set.flip();
+            return true;
+        }
+    };
+
+
+    /// Compiles nodes into NFA states, each node is built in front of the state that follows it
+    class
+    Builder
+    {
+    public:
+        Builder(Regex::Nfa *nfa, bool is_reversed) : m_nfa(nfa), m_is_reversed(is_reversed) {}
+
+        /// @returns the first state of node, or -1 if the NFA grew too large
+        auto
+        Build(const Node &node, int32_t next) -> int32_t
+        {
+            if (next < 0 || m_nfa->states.size() > MAX_NFA_STATES) return -1;
+
+            switch (node.type) {
+            case Set_Node:
+                m_nfa->sets.push_back(node.set);
+                return Add({ Regex::Byte_State, static_cast<int32_t>(m_nfa->sets.size() - 1), next });
+
+            /* Scanning backward swaps which line boundary comes first */
+            case Line_Start_Node:
+                return Add({ m_is_reversed ? Regex::Line_End_State : Regex::Line_Start_State, -1, next });
+            case Line_End_Node:
+                return Add({ m_is_reversed ? Regex::Line_Start_State : Regex::Line_End_State, -1, next });
+
+            case Concat_Node:
+                if (m_is_reversed) {
+                    for (const auto &child : node.children) next = Build(child, next);
+                } else {
+                    for (auto child = node.children.rbegin(); child != node.children.rend(); child++) {
+                        next = Build(*child, next);
+                    }
+                }
+                return next;
+
+            case Alternate_Node: {
+                int32_t entry = Build(node.children.back(), next);
+                for (size_t i = node.children.size() - 1; i-- > 0;) {
+                    entry = Add({ Regex::Split_State, -1, Build(node.children.at(i), next), entry });
+                }
+                return entry;
+            }
+
+            case Repeat_Node:
+                return Build_Repeat(node, next);
+
+            default:
+                return next;
+            }
+        }
+
+        auto
+        Add(Regex::State state) -> int32_t
+        {
+            m_nfa->states.push_back(state);
+            return static_cast<int32_t>(m_nfa->states.size() - 1);
+        }
+
+    private:
+        Regex::Nfa *m_nfa;
+        bool m_is_reversed;
+
+        auto
+        Build_Repeat(const Node &node, int32_t next) -> int32_t
+        {
+            const Node &child = node.children.front();
+            int32_t entry = next;
+
+            if (node.max < 0) {
+                /* The loop is created first, so the body can point back at it */
+                int32_t loop = Add({ Regex::Split_State, -1, -1, next });
+                int32_t body = Build(child, loop);
+                if (body < 0) return -1;
+
+                m_nfa->states.at(loop).out = body;
+                entry = loop;
+            } else {
+                for (int32_t i = node.min; i < node.max; i++) {
+                    entry = Add({ Regex::Split_State, -1, Build(child, entry), next });
+                }
+            }
+
+            for (int32_t i = 0; i < node.min; i++) entry = Build(child, entry);
+            return entry;
+        }
+    };
+
+
+    auto
+    Build_Nfa(const Node &root, Regex::Nfa *nfa, bool is_reversed, bool is_unanchored) -> bool
+    {
+        Builder builder(nfa, is_reversed);
+        int32_t match = builder.Add({ Regex::Match_State });
+        nfa->start = builder.Build(root, match);
+
+        if (is_unanchored && nfa->start >= 0) {
+            /* Any byte can come before the match: a loop over every byte in front of the pattern */
+            int32_t loop = builder.Add({ Regex::Split_State, -1, -1, nfa->start });
+            nfa->sets.emplace_back().set();
+            nfa->states.at(loop).out = builder.Add({ Regex::Byte_State, static_cast<int32_t>(nfa->sets.size() - 1), loop });
+            nfa->start = loop;
+        }
+
+        for (auto &state : nfa->states) {
+            if (state.type == Regex::Split_State && (state.out < 0 || state.out1 < 0)) return false;
+        }
+        return nfa->start >= 0;
+    }
+} /* Anonymous namespace */
+
+
+auto
+Regex::Compile(std::string_view pattern, Program *program) -> bool
+{
+    Node root;
+    Parser parser(pattern);
+    if (!parser.Parse(&root)) {
+        Log::Err("Invalid pattern {}: {}", pattern, parser.Get_Error());
+        return false;
+    }
+
+    *program = Program();
+    if (
+        !Build_Nfa(root, &program->reversed, true, true) ||
+        !Build_Nfa(root, &program->anchored, false, false)
+    ) {
+        Log::Err("Pattern is too large: {}", pattern);
+        return false;
+    }
+    return true;
+}
+
+
+void
+Dfa::Close(std::vector<int32_t> *set, bool at_line_start, bool at_line_end) const
+{
+    std::vector<int32_t> stack = std::move(*set);
+    std::vector<bool> is_visited(m_nfa->states.size());
+    set->clear();
+
+    while (!stack.empty()) {
+        int32_t index = stack.back();
+        stack.pop_back();
+        if (is_visited.at(index)) continue;
+        is_visited.at(index) = true;
+
+        const State &state = m_nfa->states.at(index);
+        switch (state.type) {
+        case Split_State:
+            stack.push_back(state.out1);
+            stack.push_back(state.out);
+            break;
+
+        /* Unresolved line boundaries stay in the set, until the scan reaches one */
+        case Line_Start_State:
+            if (at_line_start) stack.push_back(state.out);
+            else set->push_back(index);
+            break;
+        case Line_End_State:
+            if (at_line_end) stack.push_back(state.out);
+            else set->push_back(index);
+            break;
+
+        default:
+            set->push_back(index);
+            break;
+        }
+    }
+
+    std::ranges::sort(*set);
+}
+
+
+auto
+Dfa::Intern(std::vector<int32_t> set) -> int32_t
+{
+    std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(int32_t));
+    auto found = m_ids.find(key);
+    if (found != m_ids.end()) return found->second;
+
+    bool is_match = std::ranges::any_of(set, [this](int32_t index) {
+        return m_nfa->states.at(index).type == Match_State;
+    });
+
+    auto id = static_cast<int32_t>(m_sets.size());
+    m_sets.push_back(std::move(set));
+    m_next.emplace_back().fill(-1);
+    m_is_match.push_back(is_match);
+    m_is_match_at_end.push_back(-1);
+    m_ids.emplace(std::move(key), id);
+    return id;
+}
+
+
+void
+Dfa::Clear()
+{
+    m_sets.clear();
+    m_next.clear();
+    m_is_match.clear();
+    m_is_match_at_end.clear();
+    m_ids.clear();
+    m_starts = { -1, -1 };
+    m_resets++;
+}
+
+
+auto
+Dfa::Start(bool at_line_start) -> int32_t
+{
+    int32_t &start = m_starts.at(at_line_start ? 1 : 0);
+    if (start >= 0) return start;
+
+    std::vector<int32_t> set = { m_nfa->start };
+    Close(&set, at_line_start, false);
+
+    if (m_sets.size() >= MAX_STATES) Clear();
+    int32_t id = Intern(std::move(set));
+    m_starts.at(at_line_start ? 1 : 0) = id;
+    return id;
+}
+
+
+auto
+Dfa::Compute_Step(int32_t state, uint8_t byte) -> int32_t
+{
+    std::vector<int32_t> next;
+    for (int32_t index : m_sets.at(state)) {
+        const State &nfa_state = m_nfa->states.at(index);
+        if (nfa_state.type == Byte_State && m_nfa->sets.at(nfa_state.set).test(byte)) next.push_back(nfa_state.out);
+    }
+    Close(&next, false, false);
+
+    /* A full cache starts over, the states already scanned are never needed again */
+    if (m_sets.size() >= MAX_STATES) {
+        Clear();
+        return Intern(std::move(next));
+    }
+
+    int32_t id = Intern(std::move(next));
+    m_next.at(state).at(byte) = id;
+    return id;
+}
+
+
+auto
+Dfa::Is_Match_At_End(int32_t state) -> bool
+{
+    int8_t &cached = m_is_match_at_end.at(state);
+    if (cached >= 0) return cached == 1;
+
+    std::vector<int32_t> set = m_sets.at(state);
+    Close(&set, false, true);
+
+    bool is_match = std::ranges::any_of(set, [this](int32_t index) {
+        return m_nfa->states.at(index).type == Match_State;
+    });
+    cached = (is_match ? 1 : 0);
+    return is_match;
+}
+
+
+Matcher::Matcher(const Program *program) :
+    m_reversed(&program->reversed),
+    m_anchored(&program->anchored) {}
+
+
+void
+Matcher::Find_All(std::string_view line, std::vector<Match> *matches)
+{
+    auto length = static_cast<int64_t>(line.length());
+    auto byte_at = [&line](int64_t i) { return static_cast<uint8_t>(line[i]); };
+    auto pack = [](int64_t position, int32_t state) {
+        return (static_cast<uint64_t>(position) << 32) | static_cast<uint32_t>(state);
+    };
+
+    /* One backward scan marks every start, then each match is extended as far as it goes from the leftmost one */
+    m_is_start.assign(length + 1, 0);
+    int32_t state = m_reversed.Start(true);
+    m_is_start.at(length) = (m_reversed.Is_Match(state) ? 1 : 0);
+
+    for (int64_t i = length; i > 0; i--) {
+        state = m_reversed.Step(state, byte_at(i - 1));
+        m_is_start[i - 1] = (m_reversed.Is_Match(state) ? 1 : 0);
+    }
+    if (m_reversed.Is_Match_At_End(state)) m_is_start.at(0) = 1;
+
+    /* The longest match has to be scanned until the DFA dies, often far past its end, where the next scans start.
+    // Where a scan meets the state an earlier one had at the same position, it stops: the rest is known not to match.
+    // So every position is scanned at most once per state it is reached in, and not once per start before it. */
+    m_doomed.clear();
+    int64_t doomed_last = -1;
+    uint64_t resets = m_anchored.Get_Resets();
+
+    int64_t start = 0;
+    while (start <= length) {
+        if (m_is_start[start] == 0) {
+            start++;
+            continue;
+        }
+
+        state = m_anchored.Start(start == 0);
+        int64_t end = (m_anchored.Is_Match(state) ? start : -1);
+        m_trail.clear();
+
+        int64_t i = start;
+        while (i < length && !m_anchored.Is_Dead(state)) {
+            state = m_anchored.Step(state, byte_at(i));
+            i++;
+
+            if (m_anchored.Is_Match(state)) end = i;
+            else if (i <= doomed_last && m_anchored.Get_Resets() == resets && m_doomed.contains(pack(i, state))) break;
+            m_trail.push_back(state);
+        }
+        if (i == length && m_anchored.Is_Match_At_End(state)) end = length;
+
+        /* Ids from before the cache started over could name other states now */
+        if (m_anchored.Get_Resets() != resets) {
+            resets = m_anchored.Get_Resets();
+            m_doomed.clear();
+            doomed_last = -1;
+        } else {
+            for (int64_t position = std::max(start, end) + 1; position <= start + static_cast<int64_t>(m_trail.size()); position++) {
+                int32_t doomed = m_trail[position - start - 1];
+                if (m_anchored.Is_Dead(doomed)) break;
+
+                m_doomed.insert(pack(position, doomed));
+                doomed_last = std::max(doomed_last, position);
+            }
+        }
+
+        matches->push_back({ start, end - start });
+        start = (end > start ? end : start + 1);
+    }
+}
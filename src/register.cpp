@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cctype>
+
+#include "../inc/buffer.hpp"
+
+#include "../inc/register.hpp"
+
+using Register::Store;
+
+
+namespace {
+    const int32_t LETTER_OFFSET = 10;
+    const int32_t SMALL_DELETE_INDEX = 36;
+
+
+    /// Moves a position that comes after an insertion from start to end
+    auto
+    Shift_After_Insert(Position position, Position start, Position end) -> Position
+    {
+        if (position.y == start.y) return { end.x + position.x - start.x, end.y };
+        return { position.x, position.y + end.y - start.y };
+    }
+
+
+    /// Moves a position that comes after an erased range from start to end
+    auto
+    Shift_After_Erase(Position position, Position start, Position end) -> Position
+    {
+        if (position.y == end.y) return { start.x + position.x - end.x, start.y };
+        return { position.x, position.y - (end.y - start.y) };
+    }
+
+
+    /// Returns where text ends once inserted at position
+    auto
+    Insert_End(Position position, std::string_view text) -> Position
+    {
+        auto lines = static_cast<int64_t>(std::ranges::count(text, '\n'));
+        if (lines == 0) return { position.x + static_cast<int64_t>(text.length()), position.y };
+
+        return { static_cast<int64_t>(text.length() - text.rfind('\n') - 1), position.y + lines };
+    }
+} /* Anonymous namespace */
+
+
+auto
+Store::Index(char name) -> int32_t
+{
+    if (name >= '0' && name <= '9') return name - '0';
+    if (std::isalpha(static_cast<unsigned char>(name)) != 0) {
+        return LETTER_OFFSET + (std::tolower(static_cast<unsigned char>(name)) - 'a');
+    }
+    if (name == '-') return SMALL_DELETE_INDEX;
+    return -1;
+}
+
+
+auto
+Store::Is_Valid_Name(char name) -> bool
+{ return name == '"' || name == '_' || Index(name) >= 0; }
+
+
+void
+Store::Yank(const std::vector<std::string> &content, char name, Position start, Position end, bool is_linewise)
+{
+    if (name == '_') return;
+
+    Entry entry;
+    entry.start = start;
+    entry.end = end;
+    entry.is_live = true;
+    entry.is_linewise = is_linewise;
+
+    /* Empty ranges are not worth tracking */
+    if (start == end) Materialise(content, entry);
+    Set(content, (name == '"' ? '0' : name), std::move(entry));
+}
+
+
+void
+Store::Yank_Text(const std::vector<std::string> &content, char name, std::string text, bool is_linewise)
+{
+    if (name == '_') return;
+
+    Entry entry;
+    entry.text = std::make_shared<const std::string>(std::move(text));
+    entry.is_linewise = is_linewise;
+    Set(content, (name == '"' ? '0' : name), std::move(entry));
+}
+
+
+void
+Store::Delete(const std::vector<std::string> &content, char name, std::string text, bool is_linewise)
+{
+    if (name == '_') return;
+
+    Entry entry;
+    entry.text = std::make_shared<const std::string>(std::move(text));
+    entry.is_linewise = is_linewise;
+
+    if (name != '"') {
+        Set(content, name, std::move(entry));
+        return;
+    }
+
+    /* Small deletes go to "-, the rest shift through "1 to "9 */
+    if (!is_linewise && entry.text->find('\n') == std::string::npos) {
+        Set(content, '-', std::move(entry));
+        return;
+    }
+
+    std::move_backward(m_entries.begin() + 1, m_entries.begin() + 9, m_entries.begin() + 10);
+    Set(content, '1', std::move(entry));
+}
+
+
+auto
+Store::Get(const std::vector<std::string> &content, char name) -> const Entry*
+{
+    int32_t index = Index(name == '"' ? m_unnamed : name);
+    if (index < 0) return nullptr;
+
+    Entry &entry = m_entries.at(index);
+    if (entry.Is_Empty()) return nullptr;
+
+    if (entry.is_live) Materialise(content, entry);
+    return &entry;
+}
+
+
+void
+Store::Set(const std::vector<std::string> &content, char name, Entry entry)
+{
+    int32_t index = Index(name);
+    if (index < 0) return;
+
+    Entry &stored = m_entries.at(index);
+    m_unnamed = static_cast<char>(std::tolower(static_cast<unsigned char>(name)));
+
+    if (std::isupper(static_cast<unsigned char>(name)) == 0 || stored.Is_Empty()) {
+        stored = std::move(entry);
+        return;
+    }
+
+    /* Appending builds a new text, the old one may still be shared */
+    if (stored.is_live) Materialise(content, stored);
+    if (entry.is_live) Materialise(content, entry);
+
+    std::string appended = *stored.text;
+    if (entry.is_linewise && !stored.is_linewise) appended += '\n';
+    appended += *entry.text;
+
+    stored.text = std::make_shared<const std::string>(std::move(appended));
+    stored.is_linewise = stored.is_linewise || entry.is_linewise;
+}
+
+
+void
+Store::Before_Insert(const std::vector<std::string> &content, Position position, std::string_view text)
+{
+    Position end;
+    bool has_end = false;
+
+    for (auto &entry : m_entries) {
+        if (!entry.is_live || !position.Is_Before(entry.end)) continue;
+
+        /* Text inserted inside the range changes it, so the old text is kept */
+        if (entry.start.Is_Before(position)) {
+            Materialise(content, entry);
+            continue;
+        }
+
+        if (!has_end) {
+            end = Insert_End(position, text);
+            has_end = true;
+        }
+        entry.start = Shift_After_Insert(entry.start, position, end);
+        entry.end = Shift_After_Insert(entry.end, position, end);
+    }
+}
+
+
+void
+Store::Before_Erase(const std::vector<std::string> &content, Position start, Position end)
+{
+    for (auto &entry : m_entries) {
+        if (!entry.is_live || !start.Is_Before(entry.end)) continue;
+
+        if (entry.start.Is_Before(end)) {
+            Materialise(content, entry);
+            continue;
+        }
+
+        entry.start = Shift_After_Erase(entry.start, start, end);
+        entry.end = Shift_After_Erase(entry.end, start, end);
+    }
+}
+
+
+auto
+Store::Is_Live(int64_t first, int64_t last) const -> bool
+{
+    return std::ranges::any_of(m_entries, [first, last](const Entry &entry) {
+        return entry.is_live && entry.start.y <= last && entry.end.y >= first;
+    });
+}
+
+
+void
+Store::Materialise(const std::vector<std::string> &content, Entry &entry)
+{
+    std::string text = Buffer::Get_Text(content, entry.start, entry.end);
+    if (entry.is_linewise) text += '\n';
+
+    entry.text = std::make_shared<const std::string>(std::move(text));
+    entry.is_live = false;
+}
@@ -0,0 +1,293 @@
+#include <shared_mutex>
+#include <algorithm>
+#include <optional>
+
+#include "../inc/editor.hpp"
+
+#include "../inc/search.hpp"
+
+using Search::Searcher;
+
+
+namespace {
+    auto
+    Chunk_Count(const std::vector<std::string> &content) -> size_t
+    { return (content.size() + Searcher::CHUNK_LINES - 1) / Searcher::CHUNK_LINES; }
+
+
+    auto
+    Before(Position a, Position b) -> bool
+    { return a.Is_Before(b); }
+
+
+    auto
+    Match_Start(const Search::Match &match) -> Position
+    { return match.start; }
+
+
+    const std::string_view REGEX_PREFIX = "\\v";
+} /* Anonymous namespace */
+
+
+auto
+Search::Compile(std::string_view pattern, std::shared_ptr<const Regex::Program> *program) -> bool
+{
+    program->reset();
+    if (!pattern.starts_with(REGEX_PREFIX)) return true;
+
+    auto compiled = std::make_shared<Regex::Program>();
+    if (!Regex::Compile(pattern.substr(REGEX_PREFIX.length()), compiled.get())) return false;
+
+    *program = std::move(compiled);
+    return true;
+}
+
+
+void
+Search::Find_In_Line(
+    std::string_view line,
+    std::string_view pattern,
+    Regex::Matcher *matcher,
+    std::vector<Regex::Match> *matches
+)
+{
+    if (matcher != nullptr) {
+        matcher->Find_All(line, matches);
+        return;
+    }
+
+    /* Kept between calls, most lines would otherwise allocate it only to throw it away */
+    thread_local std::vector<size_t> offsets;
+    offsets.clear();
+    Utils::Find_Substrings(line, pattern, &offsets);
+
+    auto length = static_cast<int64_t>(pattern.length());
+    int64_t last_end = 0;
+    for (size_t offset : offsets) {
+        auto start = static_cast<int64_t>(offset);
+        if (start < last_end) continue;
+
+        matches->push_back({ start, length });
+        last_end = start + length;
+    }
+}
+
+
+Searcher::~Searcher()
+{ Stop(); }
+
+
+void
+Searcher::Stop()
+{
+    m_token.Cancel();
+    m_generation++;
+    m_jobs.Wait();
+}
+
+
+void
+Searcher::Start(Editor::Data *editor_data, std::string_view pattern, bool is_backward)
+{
+    m_pattern = pattern;
+    m_is_backward = is_backward;
+    m_version = editor_data->version;
+    m_matcher.reset();
+
+    if (!Compile(m_pattern, &m_program)) m_pattern.clear();
+    if (m_program) m_matcher = std::make_unique<Regex::Matcher>(m_program.get());
+    m_chunks.assign(m_pattern.empty() ? 0 : Chunk_Count(editor_data->file_content), Chunk());
+
+    m_token.Cancel();
+    m_token = Tasks::Token();
+    {
+        std::lock_guard lock(m_mutex);
+        m_generation++;
+        m_finished.clear();
+    }
+    if (m_pattern.empty()) return;
+
+    auto job = std::make_shared<Job>();
+    job->generation = m_generation;
+    job->pattern = m_pattern;
+    job->program = m_program;
+    job->version = m_version;
+    job->first_chunk = editor_data->scroll.y / CHUNK_LINES;
+    job->editor_data = editor_data;
+
+    /* One job per worker, the completion only wakes the main loop so it collects the chunks */
+    uint32_t job_count = std::min(Tasks::Get_Thread_Count(), static_cast<uint32_t>(m_chunks.size()));
+    for (uint32_t i = 0; i < job_count; i++) {
+        Tasks::Submit_With_Completion(Tasks::Interactive, [this, job] { Scan_Job(job); }, [] {}, &m_jobs, m_token);
+    }
+}
+
+
+void
+Searcher::Scan_Job(const std::shared_ptr<Job> &job)
+{
+    std::optional<Regex::Matcher> matcher;
+    if (job->program) matcher.emplace(job->program.get());
+    Editor::Data *editor_data = job->editor_data;
+
+    /* Chunks are claimed in viewport-first order, the buffer is only locked for one chunk at a time */
+    for (;;) {
+        std::vector<Match> matches;
+        size_t index = 0;
+        {
+            std::shared_lock content_lock(editor_data->content_mutex);
+            size_t chunk_count = Chunk_Count(editor_data->file_content);
+            if (editor_data->version != job->version || m_generation != job->generation) break;
+
+            size_t i = job->next_chunk++;
+            if (i >= chunk_count) break;
+
+            index = (job->first_chunk + i) % chunk_count;
+            matches = Scan_Chunk(editor_data, index, job->pattern, matcher ? &*matcher : nullptr);
+        }
+
+        std::lock_guard finished_lock(m_mutex);
+        if (m_generation != job->generation) break;
+        m_finished.push_back({ job->generation, index, std::move(matches) });
+    }
+}
+
+
+auto
+Searcher::Scan_Chunk(
+    const Editor::Data *editor_data,
+    size_t index,
+    std::string_view pattern,
+    Regex::Matcher *matcher
+) -> std::vector<Match>
+{
+    Cold::Reader content(editor_data);
+    std::vector<Match> matches;
+    std::vector<Regex::Match> line_matches;
+
+    size_t first = index * CHUNK_LINES;
+    size_t last = std::min(first + CHUNK_LINES, content.size());
+
+    const Trigram::Index *trigrams = editor_data->trigrams.get();
+    if (matcher == nullptr && trigrams != nullptr && !trigrams->May_Contain(first, last, pattern)) return matches;
+
+    for (size_t y = first; y < last; y++) {
+        line_matches.clear();
+        Find_In_Line(content.at(y), pattern, matcher, &line_matches);
+
+        for (const auto &match : line_matches) {
+            matches.push_back({ { match.start, static_cast<int64_t>(y) }, match.length });
+        }
+    }
+    return matches;
+}
+
+
+auto
+Searcher::Collect(Editor::Data *editor_data) -> bool
+{
+    if (m_pattern.empty()) return false;
+
+    /* Edits make every match stale, the search starts over on the new buffer */
+    if (editor_data->version != m_version) {
+        Start(editor_data, m_pattern, m_is_backward);
+        return true;
+    }
+
+    std::vector<Finished_Chunk> finished;
+    {
+        std::lock_guard lock(m_mutex);
+        finished.swap(m_finished);
+    }
+
+    bool is_updated = false;
+    for (auto &chunk : finished) {
+        if (chunk.generation != m_generation || chunk.index >= m_chunks.size()) continue;
+
+        Chunk &stored = m_chunks.at(chunk.index);
+        if (stored.is_scanned) continue;
+
+        stored.matches = std::move(chunk.matches);
+        stored.is_scanned = true;
+        is_updated = true;
+    }
+    return is_updated;
+}
+
+
+auto
+Searcher::Find_Next(
+    Editor::Data *editor_data,
+    Position from,
+    bool is_backward,
+    int64_t count,
+    Position *match
+) -> bool
+{
+    if (m_pattern.empty() || m_chunks.empty()) return false;
+    Collect(editor_data);
+
+    auto chunk_count = static_cast<int64_t>(m_chunks.size());
+    bool is_found = false;
+
+    for (int64_t n = 0; n < count; n++) {
+        int64_t index = from.y / CHUNK_LINES;
+        bool is_match = false;
+
+        /* The chunk of from is visited twice, once on each side of from */
+        for (int64_t i = 0; i <= chunk_count && !is_match; i++) {
+            int64_t current = (is_backward ? index - i : index + i) % chunk_count;
+            if (current < 0) current += chunk_count;
+
+            Chunk &chunk = m_chunks.at(current);
+            if (!chunk.is_scanned) {
+                chunk.matches = Scan_Chunk(editor_data, current, m_pattern, m_matcher.get());
+                chunk.is_scanned = true;
+            }
+
+            const std::vector<Match> &matches = chunk.matches;
+            if (matches.empty()) continue;
+
+            bool is_wrapped = (i == chunk_count);
+            if (is_backward) {
+                auto found = (i == 0 ? std::ranges::lower_bound(matches, from, Before, Match_Start) : matches.end());
+                if (is_wrapped) found = matches.end();
+                if (found == matches.begin()) continue;
+
+                Position candidate = std::prev(found)->start;
+                if (is_wrapped && candidate.Is_Before(from)) continue;
+
+                *match = candidate;
+                is_match = true;
+            } else {
+                auto found = (i == 0 ? std::ranges::upper_bound(matches, from, Before, Match_Start) : matches.begin());
+                if (found == matches.end()) continue;
+                if (is_wrapped && from.Is_Before(found->start)) continue;
+
+                *match = found->start;
+                is_match = true;
+            }
+        }
+
+        if (!is_match) break;
+        from = *match;
+        is_found = true;
+    }
+    return is_found;
+}
+
+
+auto
+Searcher::Get_Line_Matches(int64_t y, std::vector<Match> *matches) const -> bool
+{
+    matches->clear();
+
+    auto index = static_cast<size_t>(y / CHUNK_LINES);
+    if (index >= m_chunks.size() || !m_chunks.at(index).is_scanned) return false;
+
+    const std::vector<Match> &chunk_matches = m_chunks.at(index).matches;
+    auto found = std::ranges::lower_bound(chunk_matches, Position(0, y), Before, Match_Start);
+
+    for (; found != chunk_matches.end() && found->start.y == y; found++) matches->push_back(*found);
+    return true;
+}
@@ -0,0 +1,255 @@
+#include <algorithm>
+
+#include "../../inc/editor.hpp"
+
+#include "../../inc/syntax.hpp"
+
+using Syntax::Highlighter;
+
+
+Highlighter::~Highlighter()
+{ Stop(); }
+
+
+void
+Highlighter::Stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_running = false;
+    }
+    m_jobs.Wait();
+}
+
+
+void
+Highlighter::Start(Editor::Data *editor_data, const Language *language)
+{
+    Stop();
+
+    m_language = language;
+    m_editor_data = editor_data;
+    m_checkpoints.assign(1, { 0, Normal_State });
+    m_valid = 1;
+    m_edited_end = -1;
+    m_shown.clear();
+
+    if (m_language == nullptr) return;
+
+    std::lock_guard lock(m_mutex);
+    m_is_complete = false;
+    m_wanted = {};
+    m_published = {};
+    m_finished.clear();
+
+    m_is_running = true;
+    Schedule();
+}
+
+
+void
+Highlighter::After_Edit(int64_t first, int64_t last, int64_t line_shift)
+{
+    if (m_language == nullptr) return;
+
+    /* Checkpoints inside the rewritten lines are dropped, the ones after move with their lines
+    // and keep their old state, so the worker can tell when it is back in sync */
+    int64_t old_last = last - line_shift;
+    std::erase_if(m_checkpoints, [first, old_last](const Checkpoint &checkpoint) {
+        return checkpoint.line > first && checkpoint.line <= old_last;
+    });
+    for (auto &checkpoint : m_checkpoints) {
+        if (checkpoint.line > old_last) checkpoint.line += line_shift;
+    }
+
+    auto kept = std::ranges::upper_bound(m_checkpoints, first, {}, &Checkpoint::line) - m_checkpoints.begin();
+    m_valid = std::min(m_valid, static_cast<size_t>(kept));
+
+    if (m_edited_end > old_last) m_edited_end += line_shift;
+    m_edited_end = std::max(m_edited_end, last);
+
+    /* Shown lines keep their old colours until the worker catches up, rather than flashing plain on every key */
+    std::unordered_map<int64_t, std::vector<Run>> shown;
+    for (auto &[y, runs] : m_shown) {
+        if (y <= std::min(last, old_last)) shown.emplace(y, std::move(runs));
+        else if (y > old_last) shown.emplace(y + line_shift, std::move(runs));
+    }
+    m_shown = std::move(shown);
+
+    std::lock_guard lock(m_mutex);
+    m_is_complete = false;
+    Schedule();
+}
+
+
+auto
+Highlighter::Collect(Editor::Data *editor_data) -> bool
+{
+    if (m_language == nullptr) return false;
+
+    /* A page above and below the viewport is lexed too, so scrolling rarely shows plain lines */
+    auto first = static_cast<int64_t>(editor_data->scroll.y);
+    auto last = static_cast<int64_t>(editor_data->last_rendered_line);
+    int64_t page = std::max(last - first, 0L);
+    Range wanted = { std::max(first - page, 0L), last + page, editor_data->version };
+
+    std::vector<Lexed_Lines> finished;
+    {
+        std::lock_guard lock(m_mutex);
+        if (last > first && m_wanted != wanted) {
+            m_wanted = wanted;
+            Schedule();
+        }
+        finished.swap(m_finished);
+    }
+
+    bool is_updated = false;
+    for (auto &lines : finished) {
+        if (lines.range.version != editor_data->version) continue;
+
+        m_shown.clear();
+        for (size_t i = 0; i < lines.runs.size(); i++) {
+            m_shown.emplace(lines.range.first + static_cast<int64_t>(i), std::move(lines.runs.at(i)));
+        }
+        is_updated = true;
+    }
+    return is_updated;
+}
+
+
+auto
+Highlighter::Get_Line_Runs(int64_t y, std::vector<Run> *runs) const -> bool
+{
+    auto found = m_shown.find(y);
+    if (found == m_shown.end()) return false;
+
+    *runs = found->second;
+    return true;
+}
+
+
+auto
+Highlighter::Find_Checkpoint(int64_t line) const -> size_t
+{
+    auto valid = m_checkpoints.begin() + static_cast<int64_t>(m_valid);
+    auto found = std::upper_bound(m_checkpoints.begin(), valid, line, [](int64_t value, const Checkpoint &checkpoint) {
+        return value < checkpoint.line;
+    });
+    return static_cast<size_t>(std::max(found - m_checkpoints.begin() - 1, 0L));
+}
+
+
+auto
+Highlighter::Extend(Cold::Reader &content) -> bool
+{
+    auto lines = static_cast<int64_t>(content.size());
+    const Checkpoint &from = m_checkpoints.at(m_valid - 1);
+    int64_t line = from.line;
+    int64_t anchor = from.line;
+    State state = from.state;
+
+    for (int64_t end = std::min(lines, line + BATCH_LINES); line < end;) {
+        state = Lex_Line(*m_language, content.at(line), state, nullptr);
+        line++;
+        if (line >= lines) break;
+
+        /* Past the edits, a checkpoint reached in the same state as before means every one after it is right too */
+        if (m_valid < m_checkpoints.size() && m_checkpoints.at(m_valid).line == line) {
+            Checkpoint &checkpoint = m_checkpoints.at(m_valid);
+            if (line > m_edited_end && checkpoint.state == state) {
+                m_valid = m_checkpoints.size();
+                m_edited_end = -1;
+                return true;
+            }
+
+            checkpoint.state = state;
+            m_valid++;
+            anchor = line;
+        }
+        else if (line - anchor >= CHECKPOINT_LINES) {
+            m_checkpoints.insert(m_checkpoints.begin() + static_cast<int64_t>(m_valid), { line, state });
+            m_valid++;
+            anchor = line;
+        }
+    }
+
+    if (line < lines) return false;
+
+    m_valid = m_checkpoints.size();
+    m_edited_end = -1;
+    return true;
+}
+
+
+auto
+Highlighter::Lex_Range(Cold::Reader &content, Range range) const -> Lexed_Lines
+{
+    const Checkpoint &from = m_checkpoints.at(Find_Checkpoint(range.first));
+    State state = from.state;
+    for (int64_t y = from.line; y < range.first; y++) state = Lex_Line(*m_language, content.at(y), state, nullptr);
+
+    Lexed_Lines lexed = { range, {} };
+    lexed.runs.resize(static_cast<size_t>(range.last - range.first));
+    for (int64_t y = range.first; y < range.last; y++) {
+        state = Lex_Line(*m_language, content.at(y), state, &lexed.runs.at(static_cast<size_t>(y - range.first)));
+    }
+    return lexed;
+}
+
+
+void
+Highlighter::Schedule()
+{
+    bool wants_lines = (m_wanted != m_published);
+    if (!m_is_running || m_is_scheduled || (!wants_lines && m_is_complete)) return;
+
+    m_is_scheduled = true;
+    Tasks::Submit((wants_lines ? Tasks::Interactive : Tasks::Background), [this] { Run_Step(); }, &m_jobs);
+}
+
+
+void
+Highlighter::Run_Step()
+{
+    Range wanted;
+    bool wants_lines = false;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_is_running) {
+            m_is_scheduled = false;
+            return;
+        }
+
+        wanted = m_wanted;
+        wants_lines = (m_wanted != m_published);
+    }
+
+    {
+        /* The content is held for one step, edits wait for it and then update the checkpoints they touch */
+        std::shared_lock content_lock(m_editor_data->content_mutex);
+        Cold::Reader content(m_editor_data);
+        auto lines = static_cast<int64_t>(content.size());
+
+        Range range = { std::min(wanted.first, lines), std::min(wanted.last, lines), m_editor_data->version };
+        size_t checkpoint = Find_Checkpoint(range.first);
+        bool is_near = (checkpoint + 1 < m_valid || range.first - m_checkpoints.at(checkpoint).line <= CHECKPOINT_LINES);
+
+        /* The viewport waits only for the checkpoints before it, the rest of the file is done afterwards */
+        if (wants_lines && is_near) {
+            Lexed_Lines lexed = Lex_Range(content, range);
+
+            std::lock_guard lock(m_mutex);
+            m_finished.push_back(std::move(lexed));
+            m_published = wanted;
+        } else {
+            bool is_done = Extend(content);
+
+            std::lock_guard lock(m_mutex);
+            m_is_complete = is_done;
+        }
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_is_scheduled = false;
+    Schedule();
+}
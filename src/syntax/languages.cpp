@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "../../inc/syntax.hpp"
+
+using Syntax::Language;
+
+
+namespace {
+    /// Adds every space separated word of list as type
+    void
+    Add_Words(Language *language, std::string_view list, Syntax::Token_Type type)
+    {
+        while (!list.empty()) {
+            size_t end = std::min(list.find(' '), list.length());
+            if (end > 0) language->words.emplace(list.substr(0, end), type);
+            list.remove_prefix(std::min(end + 1, list.length()));
+        }
+    }
+
+
+    auto
+    Make_Languages() -> std::vector<Language>
+    {
+        std::vector<Language> languages;
+
+        Language &c = languages.emplace_back();
+        c.name = "c++";
+        c.extensions = { ".c", ".h", ".cc", ".cpp", ".cxx", ".hh", ".hpp", ".hxx", ".inl" };
+        c.line_comment = "//";
+        c.block_comment_start = "/*";
+        c.block_comment_end = "*/";
+        c.quotes = "\"'";
+        c.has_preprocessor = true;
+        Add_Words(&c, "alignas alignof asm break case catch class co_await co_return co_yield concept const consteval "
+            "constexpr constinit const_cast continue decltype default delete do dynamic_cast else enum explicit export "
+            "extern false for friend goto if inline mutable namespace new noexcept nullptr operator private protected "
+            "public register reinterpret_cast requires return sizeof static static_assert static_cast struct switch "
+            "template this thread_local throw true try typedef typeid typename union using virtual volatile while "
+            "override final", Syntax::Keyword);
+        Add_Words(&c, "auto bool char char8_t char16_t char32_t double float int long short signed unsigned void wchar_t "
+            "int8_t int16_t int32_t int64_t uint8_t uint16_t uint32_t uint64_t size_t ssize_t ptrdiff_t", Syntax::Type);
+
+        Language &python = languages.emplace_back();
+        python.name = "python";
+        python.extensions = { ".py", ".pyw", "meson.build", "SConstruct" };
+        python.line_comment = "#";
+        python.long_string = "\"\"\"";
+        python.quotes = "\"'";
+        Add_Words(&python, "and as assert async await break class continue def del elif else except False finally for "
+            "from global if import in is lambda None nonlocal not or pass raise return True try while with yield "
+            "match case", Syntax::Keyword);
+        Add_Words(&python, "bool bytes dict float int list object set str tuple", Syntax::Type);
+
+        Language &rust = languages.emplace_back();
+        rust.name = "rust";
+        rust.extensions = { ".rs" };
+        rust.line_comment = "//";
+        rust.block_comment_start = "/*";
+        rust.block_comment_end = "*/";
+        rust.quotes = "\"";
+        Add_Words(&rust, "as async await break const continue crate dyn else enum extern false fn for if impl in let "
+            "loop match mod move mut pub ref return self Self static struct super trait true type unsafe use where "
+            "while", Syntax::Keyword);
+        Add_Words(&rust, "bool char f32 f64 i8 i16 i32 i64 i128 isize str u8 u16 u32 u64 u128 usize String Vec Option "
+            "Result Box", Syntax::Type);
+
+        Language &go = languages.emplace_back();
+        go.name = "go";
+        go.extensions = { ".go" };
+        go.line_comment = "//";
+        go.block_comment_start = "/*";
+        go.block_comment_end = "*/";
+        go.quotes = "\"'`";
+        Add_Words(&go, "break case chan const continue default defer else fallthrough for func go goto if import "
+            "interface map package range return select struct switch type var nil true false iota", Syntax::Keyword);
+        Add_Words(&go, "bool byte complex64 complex128 error float32 float64 int int8 int16 int32 int64 rune string "
+            "uint uint8 uint16 uint32 uint64 uintptr any", Syntax::Type);
+
+        Language &javascript = languages.emplace_back();
+        javascript.name = "javascript";
+        javascript.extensions = { ".js", ".mjs", ".cjs", ".jsx", ".ts", ".tsx" };
+        javascript.line_comment = "//";
+        javascript.block_comment_start = "/*";
+        javascript.block_comment_end = "*/";
+        javascript.quotes = "\"'`";
+        Add_Words(&javascript, "async await break case catch class const continue debugger default delete do else "
+            "export extends false finally for from function if import in instanceof let new null of return static "
+            "super switch this throw true try typeof undefined var void while with yield interface type enum "
+            "implements", Syntax::Keyword);
+        Add_Words(&javascript, "any boolean number string symbol bigint never unknown object", Syntax::Type);
+
+        Language &lua = languages.emplace_back();
+        lua.name = "lua";
+        lua.extensions = { ".lua" };
+        lua.line_comment = "--";
+        lua.block_comment_start = "--[[";
+        lua.block_comment_end = "]]";
+        lua.quotes = "\"'";
+        Add_Words(&lua, "and break do else elseif end false for function goto if in local nil not or repeat return "
+            "then true until while", Syntax::Keyword);
+
+        Language &shell = languages.emplace_back();
+        shell.name = "shell";
+        shell.extensions = { ".sh", ".bash", ".zsh", ".bashrc", ".zshrc", ".profile" };
+        shell.line_comment = "#";
+        shell.quotes = "\"'";
+        Add_Words(&shell, "case do done elif else esac fi for function if in local return select then until while "
+            "export readonly declare", Syntax::Keyword);
+
+        Language &ini = languages.emplace_back();
+        ini.name = "ini";
+        ini.extensions = { ".ini", ".cfg", ".conf", ".toml" };
+        ini.line_comment = "#";
+        ini.quotes = "\"";
+        Add_Words(&ini, "yes no true false", Syntax::Keyword);
+
+        return languages;
+    }
+} /* Anonymous namespace */
+
+
+auto
+Syntax::Find_Language(const std::filesystem::path &file_path) -> const Language*
+{
+    static const std::vector<Language> LANGUAGES = Make_Languages();
+
+    std::string file_name = file_path.filename().string();
+    std::string extension = file_path.extension().string();
+
+    for (const auto &language : LANGUAGES) {
+        for (std::string_view known : language.extensions) {
+            if (known == file_name || (known.starts_with('.') && known == extension)) return &language;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cctype>
+
+#include "../../inc/syntax.hpp"
+
+using Syntax::Language;
+using Syntax::State;
+using Syntax::Run;
+
+
+namespace {
+    auto
+    Is_Word_Char(char c) -> bool
+    { return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_'; }
+
+
+    void
+    Add_Run(std::vector<Run> *runs, size_t start, size_t end, Syntax::Token_Type type)
+    {
+        if (runs == nullptr || end <= start) return;
+        runs->push_back({ static_cast<int64_t>(start), static_cast<int64_t>(end - start), type });
+    }
+
+
+    /// Finds where a token closed by delimiter ends, searching from i
+    /// @returns the index past the delimiter, or npos if the line ends first
+    auto
+    Find_Close(std::string_view line, size_t i, std::string_view delimiter) -> size_t
+    {
+        size_t found = line.find(delimiter, i);
+        return (found == std::string_view::npos ? found : found + delimiter.length());
+    }
+
+
+    /// Skips a number starting at i, including its prefix, separators and suffix
+    auto
+    Skip_Number(std::string_view line, size_t i) -> size_t
+    {
+        while (i < line.length()) {
+            char c = line[i];
+            bool is_exponent_sign = (
+                (c == '+' || c == '-') &&
+                (line[i - 1] == 'e' || line[i - 1] == 'E' || line[i - 1] == 'p' || line[i - 1] == 'P')
+            );
+            if (!Is_Word_Char(c) && c != '.' && c != '\'' && !is_exponent_sign) break;
+            i++;
+        }
+        return i;
+    }
+
+
+    /// Skips a single line string opened at i
+    /// @returns the index past its closing quote, or the end of the line
+    auto
+    Skip_String(std::string_view line, size_t i) -> size_t
+    {
+        char quote = line[i];
+        for (i++; i < line.length(); i++) {
+            if (line[i] == '\\') i++;
+            else if (line[i] == quote) return i + 1;
+        }
+        return line.length();
+    }
+} /* Anonymous namespace */
+
+
+auto
+Syntax::Lex_Line(const Language &language, std::string_view line, State state, std::vector<Run> *runs) -> State
+{
+    size_t i = 0;
+
+    /* The line first finishes whatever the line before it left open */
+    if (state != Normal_State) {
+        std::string_view close = (state == Block_Comment_State ? language.block_comment_end : language.long_string);
+        size_t end = Find_Close(line, 0, close);
+
+        Add_Run(runs, 0, std::min(end, line.length()), (state == Block_Comment_State ? Comment : String));
+        if (end == std::string_view::npos) return state;
+        i = end;
+    }
+
+    if (language.has_preprocessor && i == 0) {
+        size_t first = line.find_first_not_of(" \t");
+        if (first != std::string_view::npos && line[first] == '#') {
+            Add_Run(runs, first, line.length(), Preprocessor);
+            return Normal_State;
+        }
+    }
+
+    while (i < line.length()) {
+        std::string_view rest = line.substr(i);
+        char c = line[i];
+
+        /* Block comments go first, lua's one starts with its line comment */
+        if (!language.block_comment_start.empty() && rest.starts_with(language.block_comment_start)) {
+            size_t end = Find_Close(line, i + language.block_comment_start.length(), language.block_comment_end);
+            Add_Run(runs, i, std::min(end, line.length()), Comment);
+            if (end == std::string_view::npos) return Block_Comment_State;
+            i = end;
+        }
+        else if (!language.line_comment.empty() && rest.starts_with(language.line_comment)) {
+            Add_Run(runs, i, line.length(), Comment);
+            return Normal_State;
+        }
+        else if (!language.long_string.empty() && rest.starts_with(language.long_string)) {
+            size_t end = Find_Close(line, i + language.long_string.length(), language.long_string);
+            Add_Run(runs, i, std::min(end, line.length()), String);
+            if (end == std::string_view::npos) return Long_String_State;
+            i = end;
+        }
+        else if (language.quotes.find(c) != std::string_view::npos) {
+            size_t end = Skip_String(line, i);
+            Add_Run(runs, i, end, String);
+            i = end;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) != 0) {
+            size_t end = Skip_Number(line, i);
+            Add_Run(runs, i, end, Number);
+            i = end;
+        }
+        else if (Is_Word_Char(c)) {
+            size_t end = i;
+            while (end < line.length() && Is_Word_Char(line[end])) end++;
+
+            auto word = language.words.find(line.substr(i, end - i));
+            if (word != language.words.end()) Add_Run(runs, i, end, word->second);
+            i = end;
+        }
+        else i++;
+    }
+    return Normal_State;
+}
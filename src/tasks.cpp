@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <deque>
+
+#include "../inc/logging_utility.hpp"
+
+#include "../inc/tasks.hpp"
+
+
+namespace {
+    const size_t PRIORITY_COUNT = 2;
+
+
+    struct Worker_Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs[PRIORITY_COUNT];
+    };
+
+
+    /// The process-wide pool, started on first use
+    class
+    Scheduler
+    {
+    public:
+        ~Scheduler()
+        { Stop(); }
+
+        void Start(uint32_t thread_count);
+        void Stop();
+        void Push(Tasks::Priority priority, std::function<void()> job);
+
+        [[nodiscard]]
+        auto Get_Thread_Count() const -> uint32_t
+        { return static_cast<uint32_t>(m_queues.size()); }
+
+        /* Completions wait here for the main thread, the event only wakes it */
+        std::mutex completion_mutex;
+        std::vector<std::function<void()>> completions;
+        uint32_t completion_event = 0;
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::vector<std::unique_ptr<Worker_Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic<int64_t> m_pending = 0;
+        std::atomic<size_t> m_next_queue = 0;
+        bool m_is_running = false;
+
+        /// Takes the most urgent job, from its own queue first and then from the others
+        auto Take(size_t worker, std::function<void()> *job) -> bool;
+
+        void Worker_Loop(size_t worker);
+    };
+
+
+    auto
+    Get_Scheduler() -> Scheduler&
+    {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+
+    /// The worker the current thread is, so jobs submitted from a job stay on the same worker
+    thread_local int64_t t_worker = -1;
+
+
+    void
+    Scheduler::Start(uint32_t thread_count)
+    {
+        /* A pool that is stopping keeps its queues, so jobs pushed meanwhile still run */
+        std::lock_guard lock(m_mutex);
+        if (!m_threads.empty()) return;
+
+        if (thread_count == 0) thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+        m_queues.clear();
+        for (uint32_t i = 0; i < thread_count; i++) m_queues.push_back(std::make_unique<Worker_Queue>());
+
+        m_is_running = true;
+        for (size_t i = 0; i < thread_count; i++) m_threads.emplace_back(&Scheduler::Worker_Loop, this, i);
+    }
+
+
+    void
+    Scheduler::Stop()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_is_running) return;
+            m_is_running = false;
+        }
+        m_condition.notify_all();
+        for (auto &thread : m_threads) thread.join();
+
+        std::lock_guard lock(m_mutex);
+        m_threads.clear();
+        m_pending = 0;
+    }
+
+
+    void
+    Scheduler::Push(Tasks::Priority priority, std::function<void()> job)
+    {
+        Start(0);
+
+        size_t index = (t_worker >= 0 ? static_cast<size_t>(t_worker) : m_next_queue++ % m_queues.size());
+        {
+            Worker_Queue &queue = *m_queues.at(index);
+            std::lock_guard lock(queue.mutex);
+            queue.jobs[priority].push_back(std::move(job));
+        }
+
+        /* Taking the lock keeps a worker from missing the job between its check and its wait */
+        m_pending++;
+        { std::lock_guard lock(m_mutex); }
+        m_condition.notify_one();
+    }
+
+
+    auto
+    Scheduler::Take(size_t worker, std::function<void()> *job) -> bool
+    {
+        size_t count = m_queues.size();
+        for (size_t priority = 0; priority < PRIORITY_COUNT; priority++) {
+            for (size_t i = 0; i < count; i++) {
+                Worker_Queue &queue = *m_queues.at((worker + i) % count);
+                std::lock_guard lock(queue.mutex);
+
+                std::deque<std::function<void()>> &jobs = queue.jobs[priority];
+                if (jobs.empty()) continue;
+
+                if (i == 0) {
+                    *job = std::move(jobs.back());
+                    jobs.pop_back();
+                } else {
+                    *job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    void
+    Scheduler::Worker_Loop(size_t worker)
+    {
+        t_worker = static_cast<int64_t>(worker);
+
+        for (;;) {
+            std::function<void()> job;
+            if (Take(worker, &job)) {
+                m_pending--;
+                job();
+                continue;
+            }
+
+            /* Stopping lets the workers finish what is queued, so no group is left waiting */
+            std::unique_lock lock(m_mutex);
+            if (!m_is_running) break;
+            m_condition.wait(lock, [this]{ return !m_is_running || m_pending > 0; });
+        }
+    }
+} /* Anonymous namespace */
+
+
+Tasks::Group::~Group()
+{ Wait(); }
+
+
+void
+Tasks::Group::Wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_condition.wait(lock, [this]{ return m_count == 0; });
+}
+
+
+void
+Tasks::Start(uint32_t thread_count)
+{
+    Scheduler &scheduler = Get_Scheduler();
+    scheduler.Start(thread_count);
+
+    std::lock_guard lock(scheduler.completion_mutex);
+    if (scheduler.completion_event != 0) return;
+
+    scheduler.completion_event = SDL_RegisterEvents(1);
+    if (scheduler.completion_event == 0) Log::SDL_Err("Failed to register the task completion event");
+}
+
+
+void
+Tasks::Stop()
+{ Get_Scheduler().Stop(); }
+
+
+auto
+Tasks::Get_Thread_Count() -> uint32_t
+{
+    Scheduler &scheduler = Get_Scheduler();
+    scheduler.Start(0);
+    return scheduler.Get_Thread_Count();
+}
+
+
+void
+Tasks::Submit(Priority priority, std::function<void()> job, Group *group, Token token)
+{
+    if (group != nullptr) {
+        std::lock_guard lock(group->m_mutex);
+        group->m_count++;
+    }
+
+    Get_Scheduler().Push(priority, [job = std::move(job), group, token = std::move(token)] {
+        if (!token.Is_Cancelled()) job();
+        if (group == nullptr) return;
+
+        /* The owner may be destroyed as soon as the count hits 0, so it is notified under the lock */
+        std::lock_guard lock(group->m_mutex);
+        if (--group->m_count == 0) group->m_condition.notify_all();
+    });
+}
+
+
+void
+Tasks::Submit_With_Completion(
+    Priority priority,
+    std::function<void()> job,
+    std::function<void()> on_done,
+    Group *group,
+    Token token
+)
+{
+    auto run = [job = std::move(job), on_done = std::move(on_done), token]() mutable {
+        job();
+
+        /* The token is checked again on the main thread, it may be cancelled while the completion waits */
+        Run_On_Main([on_done = std::move(on_done), token] {
+            if (!token.Is_Cancelled()) on_done();
+        });
+    };
+    Submit(priority, std::move(run), group, std::move(token));
+}
+
+
+void
+Tasks::Run_On_Main(std::function<void()> on_main)
+{
+    Scheduler &scheduler = Get_Scheduler();
+    bool is_first = false;
+    uint32_t event_type = 0;
+    {
+        std::lock_guard lock(scheduler.completion_mutex);
+        is_first = scheduler.completions.empty();
+        event_type = scheduler.completion_event;
+        scheduler.completions.push_back(std::move(on_main));
+    }
+
+    /* One event wakes the main thread for every completion queued before it runs them */
+    if (!is_first || event_type == 0) return;
+
+    SDL_Event event = {};
+    event.type = event_type;
+    if (!SDL_PushEvent(&event)) Log::SDL_Err("Failed to push the task completion event");
+}
+
+
+auto
+Tasks::Is_Completion_Event(const SDL_Event *event) -> bool
+{
+    Scheduler &scheduler = Get_Scheduler();
+    std::lock_guard lock(scheduler.completion_mutex);
+    return scheduler.completion_event != 0 && event->type == scheduler.completion_event;
+}
+
+
+auto
+Tasks::Run_Completions() -> bool
+{
+    Scheduler &scheduler = Get_Scheduler();
+    std::vector<std::function<void()>> completions;
+    {
+        std::lock_guard lock(scheduler.completion_mutex);
+        completions.swap(scheduler.completions);
+    }
+
+    for (auto &completion : completions) completion();
+    return !completions.empty();
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <bit>
+
+#include "../inc/editor.hpp"
+
+#include "../inc/trigram.hpp"
+
+using Trigram::Index;
+
+
+namespace {
+    const size_t TRIGRAM_COUNT = 1 << 24;
+
+
+    auto
+    Pack(std::string_view text, size_t i) -> uint32_t
+    {
+        return (
+            (static_cast<uint32_t>(static_cast<uint8_t>(text[i])) << 16) |
+            (static_cast<uint32_t>(static_cast<uint8_t>(text[i + 1])) << 8) |
+            static_cast<uint32_t>(static_cast<uint8_t>(text[i + 2]))
+        );
+    }
+
+
+    /// Collects the trigrams of lines first up to last, sorted.
+    //  seen is a bit per possible trigram, left cleared for the next chunk.
+    auto
+    Collect(Cold::Reader &content, int64_t first, int64_t last, std::vector<uint64_t> *seen) -> std::vector<uint32_t>
+    {
+        size_t count = 0;
+        for (int64_t y = first; y < last; y++) {
+            const std::string &line = content.at(y);
+
+            for (size_t i = 0; i + 2 < line.length(); i++) {
+                uint32_t trigram = Pack(line, i);
+                uint64_t &word = (*seen)[trigram / 64];
+                uint64_t bit = uint64_t(1) << (trigram % 64);
+
+                count += ((word & bit) == 0 ? 1 : 0);
+                word |= bit;
+            }
+        }
+
+        std::vector<uint32_t> trigrams;
+        trigrams.reserve(count);
+        for (size_t i = 0; i < seen->size() && trigrams.size() < count; i++) {
+            for (uint64_t word = (*seen)[i]; word != 0; word &= word - 1) {
+                trigrams.push_back(static_cast<uint32_t>((i * 64) + std::countr_zero(word)));
+            }
+            (*seen)[i] = 0;
+        }
+        return trigrams;
+    }
+} /* Anonymous namespace */
+
+
+Index::~Index()
+{ Stop(); }
+
+
+void
+Index::Stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_running = false;
+    }
+    m_jobs.Wait();
+}
+
+
+void
+Index::Start(Editor::Data *editor_data)
+{
+    Stop();
+
+    std::lock_guard lock(m_mutex);
+    m_editor_data = editor_data;
+    m_chunks.clear();
+
+    auto lines = static_cast<int64_t>(editor_data->file_content.size());
+    for (int64_t start = 0; start == 0 || start < lines; start += CHUNK_LINES) m_chunks.push_back({ start, {} });
+
+    m_is_running = true;
+    Schedule();
+}
+
+
+auto
+Index::Find_Chunk(int64_t line) const -> size_t
+{
+    auto found = std::ranges::upper_bound(m_chunks, line, {}, &Chunk::start);
+    return static_cast<size_t>(std::max(found - m_chunks.begin() - 1, 0L));
+}
+
+
+auto
+Index::Has_Unindexed() const -> bool
+{ return std::ranges::any_of(m_chunks, [](const Chunk &chunk) { return !chunk.is_indexed; }); }
+
+
+void
+Index::After_Edit(int64_t first, int64_t last, int64_t line_shift)
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_is_running) return;
+
+    /* Chunks starting inside the rewritten lines are squeezed into them, the ones after move with their lines */
+    int64_t old_last = last - line_shift;
+    for (auto &chunk : m_chunks) {
+        if (chunk.start <= first) continue;
+
+        if (chunk.start <= old_last) chunk.start = std::min(chunk.start, last);
+        else chunk.start += line_shift;
+    }
+
+    auto lines = static_cast<int64_t>(m_editor_data->file_content.size());
+    for (size_t i = m_chunks.size(); i-- > 1;) {
+        int64_t end = (i + 1 < m_chunks.size() ? m_chunks.at(i + 1).start : lines);
+        if (m_chunks.at(i).start >= end) m_chunks.erase(m_chunks.begin() + static_cast<int64_t>(i));
+    }
+
+    for (size_t i = Find_Chunk(first); i < m_chunks.size() && m_chunks.at(i).start <= last; i++) {
+        m_chunks.at(i).is_indexed = false;
+        m_chunks.at(i).trigrams.clear();
+    }
+    Schedule();
+}
+
+
+void
+Index::Schedule()
+{
+    if (!m_is_running || m_is_scheduled || !Has_Unindexed()) return;
+
+    m_is_scheduled = true;
+    Tasks::Submit(Tasks::Background, [this] { Index_Next_Chunk(); }, &m_jobs);
+}
+
+
+void
+Index::Index_Next_Chunk()
+{
+    /* Each worker keeps its own scratch set, cleared again after every chunk */
+    thread_local std::vector<uint64_t> seen(TRIGRAM_COUNT / 64);
+
+    /* The content is held for one chunk, edits wait for it and then update the chunks they touch */
+    std::shared_lock content_lock(m_editor_data->content_mutex);
+    Cold::Reader content(m_editor_data);
+    size_t index = 0;
+    int64_t first = 0;
+    int64_t last = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        auto unindexed = std::ranges::find_if(m_chunks, [](const Chunk &chunk) { return !chunk.is_indexed; });
+        if (!m_is_running || unindexed == m_chunks.end()) {
+            m_is_scheduled = false;
+            return;
+        }
+
+        /* Chunks that grew past twice their size are split */
+        index = static_cast<size_t>(unindexed - m_chunks.begin());
+        first = unindexed->start;
+        last = (index + 1 < m_chunks.size() ? m_chunks.at(index + 1).start : static_cast<int64_t>(content.size()));
+        if (last - first > 2 * CHUNK_LINES) {
+            last = first + CHUNK_LINES;
+            m_chunks.insert(m_chunks.begin() + static_cast<int64_t>(index) + 1, { last, {} });
+        }
+    }
+
+    std::vector<uint32_t> trigrams = Collect(content, first, last, &seen);
+
+    /* One chunk per job, so interactive jobs never wait behind the whole index */
+    std::lock_guard lock(m_mutex);
+    m_chunks.at(index).trigrams = std::move(trigrams);
+    m_chunks.at(index).is_indexed = true;
+    m_is_scheduled = false;
+    Schedule();
+}
+
+
+auto
+Index::May_Contain(int64_t first, int64_t last, std::string_view pattern) const -> bool
+{
+    if (pattern.length() < 3) return true;
+
+    std::vector<uint32_t> wanted;
+    wanted.reserve(pattern.length() - 2);
+    for (size_t i = 0; i + 2 < pattern.length(); i++) wanted.push_back(Pack(pattern, i));
+
+    std::shared_lock lock(m_mutex);
+    for (size_t i = Find_Chunk(first); i < m_chunks.size() && m_chunks.at(i).start < last; i++) {
+        const Chunk &chunk = m_chunks.at(i);
+        if (!chunk.is_indexed) return true;
+
+        bool has_all = std::ranges::all_of(wanted, [&chunk](uint32_t trigram) {
+            return std::ranges::binary_search(chunk.trigrams, trigram);
+        });
+        if (has_all) return true;
+    }
+    return false;
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+
+#include "../../inc/buffer.hpp"
+#include "../../inc/editor.hpp"
+
+#include "../../inc/undo.hpp"
+
+using Undo::History;
+
+
+void
+History::Begin_Group(Position cursor)
+{
+    if (m_group_depth++ == 0) {
+        m_current = Group();
+        m_current.cursor_before = cursor;
+    }
+}
+
+
+void
+History::End_Group(Position cursor)
+{
+    if (m_group_depth == 0) return;
+    if (--m_group_depth > 0) return;
+
+    m_current.cursor_after = cursor;
+    Commit_Group();
+}
+
+
+void
+History::Record_Insert(Position start, Position end, std::string_view text)
+{
+    if (m_group_depth > 0 && Merge_Operation(Insert, start, end, text)) return;
+
+    m_current.operations.emplace_back(Insert, start, end, text);
+    m_current.memory_usage += sizeof(Operation) + text.length();
+
+    if (m_group_depth == 0) {
+        m_current.cursor_before = start;
+        m_current.cursor_after = end;
+        Commit_Group();
+    }
+}
+
+
+void
+History::Record_Erase(Position start, Position end, std::string_view text)
+{
+    if (m_group_depth > 0 && Merge_Operation(Erase, start, end, text)) return;
+
+    m_current.operations.emplace_back(Erase, start, end, text);
+    m_current.memory_usage += sizeof(Operation) + text.length();
+
+    if (m_group_depth == 0) {
+        m_current.cursor_before = start;
+        m_current.cursor_after = start;
+        Commit_Group();
+    }
+}
+
+
+auto
+History::Merge_Operation(Type type, Position start, Position end, std::string_view text) -> bool
+{
+    if (m_current.operations.empty()) return false;
+
+    Operation &last = m_current.operations.back();
+    if (last.type != type) return false;
+
+    /* Typing, the new text continues right where the last insertion stopped */
+    if (type == Insert && last.end.x == start.x && last.end.y == start.y) {
+        last.text.append(text);
+        last.end = end;
+        m_current.memory_usage += text.length();
+        return true;
+    }
+
+    /* Backspace, the erased text ends where the last erasure started */
+    if (type == Erase && end.x == last.start.x && end.y == last.start.y) {
+        last.text.insert(0, text);
+        last.start = start;
+        m_current.memory_usage += text.length();
+        return true;
+    }
+
+    return false;
+}
+
+
+void
+History::Commit_Group()
+{
+    if (m_current.Is_Empty()) return;
+
+    m_memory_usage += m_current.memory_usage;
+    m_undo_stack.emplace_back(std::move(m_current));
+    m_current = Group();
+    m_redo_stack.clear();
+
+    Enforce_Memory_Cap();
+}
+
+
+void
+History::Enforce_Memory_Cap()
+{
+    /* The newest group is always kept, so the last edit can be undone no matter its size */
+    while (m_memory_usage > m_memory_cap && m_undo_stack.size() > 1) {
+        m_memory_usage -= m_undo_stack.front().memory_usage;
+        m_undo_stack.pop_front();
+
+        /* A dropped group that was never written leaves a hole in the persisted history */
+        if (m_written > 0) { m_written--; }
+        else { m_journal.Mark_Broken(); }
+    }
+}
+
+
+auto
+History::Undo(Editor::Data *editor_data) -> bool
+{
+    if (m_group_depth > 0) {
+        m_group_depth = 1;
+        End_Group(editor_data->cursor);
+    }
+    Group group;
+    if (m_undo_stack.empty()) {
+        /* Continues into the history of previous sessions */
+        if (!m_journal.Pop_Group(group)) return false;
+    } else {
+        group = std::move(m_undo_stack.back());
+        m_undo_stack.pop_back();
+        m_memory_usage -= group.memory_usage;
+
+        if (m_undo_stack.size() < m_written) {
+            m_written--;
+            m_journal.Drop_Top();
+        }
+    }
+
+    for (auto it = group.operations.rbegin(); it != group.operations.rend(); it++) {
+        if (it->type == Insert) {
+            Buffer::Apply_Erase(editor_data, it->start, it->end);
+        } else {
+            Buffer::Apply_Insert(editor_data, it->start, it->text);
+        }
+    }
+
+    Clamp_Cursor(editor_data, group.cursor_before);
+    m_redo_stack.emplace_back(std::move(group));
+    return true;
+}
+
+
+auto
+History::Redo(Editor::Data *editor_data) -> bool
+{
+    if (m_redo_stack.empty()) return false;
+
+    Group group = std::move(m_redo_stack.back());
+    m_redo_stack.pop_back();
+
+    for (const auto &operation : group.operations) {
+        if (operation.type == Insert) {
+            Buffer::Apply_Insert(editor_data, operation.start, operation.text);
+        } else {
+            Buffer::Apply_Erase(editor_data, operation.start, operation.end);
+        }
+    }
+
+    Clamp_Cursor(editor_data, group.cursor_after);
+    m_memory_usage += group.memory_usage;
+    m_undo_stack.emplace_back(std::move(group));
+    return true;
+}
+
+
+void
+History::Set_Memory_Cap(size_t bytes)
+{
+    m_memory_cap = bytes;
+    Enforce_Memory_Cap();
+}
+
+
+void
+History::Clear()
+{
+    m_undo_stack.clear();
+    m_redo_stack.clear();
+    m_current = Group();
+    m_group_depth = 0;
+    m_memory_usage = 0;
+    m_written = 0;
+    m_journal.Mark_Broken();
+}
+
+
+auto
+History::Open_Journal(const std::filesystem::path &file_path, uint64_t content_hash) -> bool
+{ return m_journal.Open(file_path, content_hash); }
+
+
+auto
+History::Save_Journal(uint64_t content_hash) -> bool
+{
+    if (!m_journal.Is_Open()) return false;
+
+    size_t first = (m_journal.Is_Broken() ? 0 : m_written);
+    if (!m_journal.Append(m_undo_stack, first, content_hash)) return false;
+
+    m_written = m_undo_stack.size();
+    return true;
+}
+
+
+void
+History::Clamp_Cursor(Editor::Data *editor_data, Position cursor)
+{
+    int64_t last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+    cursor.y = std::clamp(cursor.y, 0L, std::max(last_line, 0L));
+
+    int64_t line_len = editor_data->file_content.at(cursor.y).length();
+    if (editor_data->mode == Editor::Normal && line_len > 0) line_len--;
+    cursor.x = std::clamp(cursor.x, 0L, line_len);
+
+    editor_data->cursor = cursor;
+    editor_data->cursor_max_x = cursor.x;
+    editor_data->scroll.y = std::min(editor_data->scroll.y, cursor.y);
+
+    int64_t last_rendered_line = editor_data->last_rendered_line;
+    if (last_rendered_line > 0 && cursor.y >= last_rendered_line) {
+        editor_data->scroll.y += cursor.y - last_rendered_line + 1;
+    }
+}
\ No newline at end of file
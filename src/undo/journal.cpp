@@ -0,0 +1,461 @@
+#include <cstring>
+#include <array>
+
+#if __unix__
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#endif
+
+#include "../../inc/logging_utility.hpp"
+
+#include "../../inc/undo.hpp"
+
+using Undo::Journal;
+
+
+namespace {
+    const std::array<char, 8> JOURNAL_MAGIC = { 'C', 'T', 'U', 'N', 'D', 'O', '0', '1' };
+    const size_t JOURNAL_HEADER_SIZE = JOURNAL_MAGIC.size() + sizeof(uint64_t);
+    const uint64_t REWIND_ALL = UINT64_MAX;
+
+    /// Journals smaller than this are never compacted, their dead records cost next to nothing
+    const size_t COMPACT_MIN_BYTES = 1 << 20;
+
+    enum Record_Type : uint32_t {
+        Group_Record = 1,
+        Rewind_Record = 2,
+        Checkpoint_Record = 3,
+    };
+
+    struct Record_Header {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t size;
+    };
+
+
+    void
+    Write_Int(std::string &buffer, uint64_t value)
+    { buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+
+    auto
+    Read_Int(const uint8_t *data) -> uint64_t
+    {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+
+    /// The size of the record at offset, its header included
+    auto
+    Record_Size(const uint8_t *map, uint64_t offset) -> size_t
+    {
+        Record_Header header{};
+        std::memcpy(&header, map + offset, sizeof(header));
+        return sizeof(header) + header.size;
+    }
+
+
+    void
+    Write_Record(std::string &buffer, Record_Type type, std::string_view payload)
+    {
+        Record_Header header = { type, 0, payload.length() };
+        buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        buffer.append(payload);
+    }
+
+
+    auto
+    Encode_Group(const Undo::Group &group) -> std::string
+    {
+        std::string payload;
+        Write_Int(payload, group.cursor_before.x);
+        Write_Int(payload, group.cursor_before.y);
+        Write_Int(payload, group.cursor_after.x);
+        Write_Int(payload, group.cursor_after.y);
+        Write_Int(payload, group.operations.size());
+
+        for (const auto &operation : group.operations) {
+            Write_Int(payload, operation.type);
+            Write_Int(payload, operation.start.x);
+            Write_Int(payload, operation.start.y);
+            Write_Int(payload, operation.end.x);
+            Write_Int(payload, operation.end.y);
+            Write_Int(payload, operation.text.length());
+            payload.append(operation.text);
+        }
+        return payload;
+    }
+
+
+    auto
+    Journal_Path(const std::filesystem::path &file_path, uint64_t *path_hash) -> std::filesystem::path
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(file_path, error);
+        if (error) absolute = file_path;
+
+        *path_hash = Utils::Hash_Bytes(Utils::Path_To_String(absolute), 0);
+        return DEFAULT_CACHE_PATH / "undo" / std::format("{:016x}.journal", *path_hash);
+    }
+} /* Anonymous namespace */
+
+
+#if __unix__
+Journal::~Journal()
+{
+    Unmap();
+    if (m_fd >= 0) close(m_fd);
+}
+
+
+auto
+Journal::Open(const std::filesystem::path &file_path, uint64_t content_hash) -> bool
+{
+    uint64_t path_hash = 0;
+    std::filesystem::path journal_path = Journal_Path(file_path, &path_hash);
+
+    std::error_code error;
+    std::filesystem::create_directories(journal_path.parent_path(), error);
+    if (error) {
+        Log::Err("Failed to create undo cache directory: {}", error.message());
+        return false;
+    }
+
+    m_path = journal_path;
+    m_fd = open(journal_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (m_fd < 0) {
+        Log::Err("Failed to open undo journal: {}", journal_path.string());
+        return false;
+    }
+
+    struct stat info{};
+    fstat(m_fd, &info);
+    m_file_size = info.st_size;
+
+    if (!Map()) return false;
+
+    size_t valid_end = 0;
+    if (
+        m_file_size >= JOURNAL_HEADER_SIZE &&
+        std::memcmp(m_map, JOURNAL_MAGIC.data(), JOURNAL_MAGIC.size()) == 0 &&
+        Read_Int(m_map + JOURNAL_MAGIC.size()) == path_hash
+    ) { valid_end = Walk_Records(content_hash); }
+
+    if (valid_end != 0 && valid_end == m_file_size) return true;
+
+    /* Drops every record that does not belong to the current content */
+    if (valid_end == 0) {
+        std::string header(JOURNAL_MAGIC.data(), JOURNAL_MAGIC.size());
+        Write_Int(header, path_hash);
+
+        m_stack.clear();
+        if (
+            ftruncate(m_fd, 0) != 0 ||
+            pwrite(m_fd, header.data(), header.length(), 0) != static_cast<ssize_t>(header.length())
+        ) {
+            Log::Err("Failed to reset undo journal: {}", journal_path.string());
+            return false;
+        }
+        valid_end = header.length();
+    } else if (ftruncate(m_fd, valid_end) != 0) {
+        Log::Err("Failed to truncate undo journal: {}", journal_path.string());
+        return false;
+    }
+
+    m_file_size = valid_end;
+    return Map();
+}
+
+
+auto
+Journal::Walk_Records(uint64_t content_hash) -> size_t
+{
+    std::vector<uint64_t> valid_stack;
+    size_t valid_end = 0;
+    size_t offset = JOURNAL_HEADER_SIZE;
+
+    while (offset + sizeof(Record_Header) <= m_file_size) {
+        Record_Header header{};
+        std::memcpy(&header, m_map + offset, sizeof(header));
+
+        size_t payload = offset + sizeof(header);
+        if (header.size > m_file_size - payload) break; /* Torn write */
+
+        switch (header.type) {
+        case Group_Record:
+            m_stack.push_back(offset);
+            break;
+
+        case Rewind_Record: {
+            uint64_t count = Read_Int(m_map + payload);
+            if (count == REWIND_ALL) count = m_stack.size();
+            m_stack.resize(m_stack.size() - std::min<uint64_t>(count, m_stack.size()));
+            break;
+        }
+
+        case Checkpoint_Record:
+            if (Read_Int(m_map + payload) == content_hash) {
+                valid_stack = m_stack;
+                valid_end = payload + header.size;
+            }
+            break;
+
+        default:
+            offset = m_file_size;
+            continue;
+        }
+
+        offset = payload + header.size;
+    }
+
+    m_stack = std::move(valid_stack);
+    return valid_end;
+}
+
+
+auto
+Journal::Append(const std::deque<Group> &groups, size_t first, uint64_t content_hash) -> bool
+{
+    if (m_fd < 0) return false;
+
+    std::string buffer;
+    std::string payload;
+
+    if (m_is_broken || m_pending_rewinds > 0) {
+        Write_Int(payload, m_is_broken ? REWIND_ALL : m_pending_rewinds);
+        Write_Record(buffer, Rewind_Record, payload);
+        if (m_is_broken) m_stack.clear();
+    }
+
+    std::vector<uint64_t> offsets;
+    for (size_t i = first; i < groups.size(); i++) {
+        offsets.push_back(m_file_size + buffer.length());
+        Write_Record(buffer, Group_Record, Encode_Group(groups.at(i)));
+    }
+
+    payload.clear();
+    Write_Int(payload, content_hash);
+    Write_Record(buffer, Checkpoint_Record, payload);
+
+    /* One write for the whole batch, the journal is only ever appended to */
+    size_t written = 0;
+    while (written < buffer.length()) {
+        ssize_t result = pwrite(
+            m_fd, buffer.data() + written, buffer.length() - written, m_file_size + written
+        );
+        if (result <= 0) {
+            Log::Err("Failed to append to undo journal");
+            return false;
+        }
+        written += result;
+    }
+
+    m_file_size += buffer.length();
+    m_stack.insert(m_stack.end(), offsets.begin(), offsets.end());
+    m_pending_rewinds = 0;
+    m_is_broken = false;
+    if (!Map()) return false;
+
+    Compact(content_hash);
+    return true;
+}
+
+
+void
+Journal::Compact(uint64_t content_hash)
+{
+    /* Rewound and dropped groups stay in the file, it is only rewritten once they outweigh the live ones */
+    size_t live_size = JOURNAL_HEADER_SIZE + sizeof(Record_Header) + sizeof(uint64_t);
+    for (uint64_t offset : m_stack) live_size += Record_Size(m_map, offset);
+    if (m_file_size < COMPACT_MIN_BYTES || m_file_size - live_size < live_size) return;
+
+    std::string buffer(reinterpret_cast<const char*>(m_map), JOURNAL_HEADER_SIZE);
+    buffer.reserve(live_size);
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(m_stack.size());
+    for (uint64_t offset : m_stack) {
+        offsets.push_back(buffer.length());
+        buffer.append(reinterpret_cast<const char*>(m_map + offset), Record_Size(m_map, offset));
+    }
+
+    std::string payload;
+    Write_Int(payload, content_hash);
+    Write_Record(buffer, Checkpoint_Record, payload);
+
+    /* Written next to the journal and renamed over it, a crash leaves either the old or the new journal */
+    std::filesystem::path compact_path = m_path;
+    compact_path += ".compact";
+
+    int32_t fd = open(compact_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        Log::Err("Failed to compact undo journal: {}", compact_path.string());
+        return;
+    }
+
+    size_t written = 0;
+    while (written < buffer.length()) {
+        ssize_t result = pwrite(fd, buffer.data() + written, buffer.length() - written, written);
+        if (result <= 0) break;
+        written += result;
+    }
+
+    std::error_code error;
+    if (written == buffer.length()) std::filesystem::rename(compact_path, m_path, error);
+    if (written != buffer.length() || error) {
+        Log::Err("Failed to compact undo journal: {}", m_path.string());
+        close(fd);
+        std::filesystem::remove(compact_path, error);
+        return;
+    }
+
+    close(m_fd);
+    m_fd = fd;
+    m_file_size = buffer.length();
+    m_stack = std::move(offsets);
+    Map();
+}
+
+
+auto
+Journal::Map() -> bool
+{
+    Unmap();
+    if (m_file_size == 0) return true;
+
+    void *map = mmap(nullptr, m_file_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        Log::Err("Failed to map undo journal");
+        return false;
+    }
+
+    m_map = static_cast<uint8_t*>(map);
+    m_map_size = m_file_size;
+    return true;
+}
+
+
+void
+Journal::Unmap()
+{
+    if (m_map != nullptr) munmap(m_map, m_map_size);
+    m_map = nullptr;
+    m_map_size = 0;
+}
+#else
+Journal::~Journal() = default;
+
+
+auto
+Journal::Open(const std::filesystem::path &/* file_path */, uint64_t /* content_hash */) -> bool
+{ return false; }
+
+
+auto
+Journal::Walk_Records(uint64_t /* content_hash */) -> size_t
+{ return 0; }
+
+
+auto
+Journal::Append(const std::deque<Group> &/* groups */, size_t /* first */, uint64_t /* content_hash */) -> bool
+{ return false; }
+
+
+void
+Journal::Compact(uint64_t /* content_hash */) {}
+
+
+auto
+Journal::Map() -> bool
+{ return false; }
+
+
+void
+Journal::Unmap() {}
+#endif
+
+
+auto
+Journal::Pop_Group(Group &group) -> bool
+{
+    if (m_stack.empty() || m_map == nullptr) return false;
+
+    if (!Decode_Group(m_stack.back(), group)) {
+        m_stack.clear();
+        return false;
+    }
+
+    m_stack.pop_back();
+    m_pending_rewinds++;
+    return true;
+}
+
+
+void
+Journal::Drop_Top()
+{
+    if (m_stack.empty()) return;
+
+    m_stack.pop_back();
+    m_pending_rewinds++;
+}
+
+
+void
+Journal::Mark_Broken()
+{
+    /* The persisted groups no longer lead to the buffer, undo must not reach them until the next append rewinds them */
+    m_stack.clear();
+    m_pending_rewinds = 0;
+    m_is_broken = true;
+}
+
+
+auto
+Journal::Decode_Group(uint64_t offset, Group &group) const -> bool
+{
+    const size_t GROUP_HEADER_INTS = 5;
+    const size_t OPERATION_HEADER_INTS = 6;
+
+    Record_Header header{};
+    std::memcpy(&header, m_map + offset, sizeof(header));
+
+    const uint8_t *data = m_map + offset + sizeof(header);
+    const uint8_t *end = data + header.size;
+    if (header.size < GROUP_HEADER_INTS * sizeof(uint64_t)) return false;
+
+    auto next = [&data]() -> int64_t {
+        int64_t value = Read_Int(data);
+        data += sizeof(uint64_t);
+        return value;
+    };
+
+    group = Group();
+    group.cursor_before = { next(), next() };
+    group.cursor_after = { next(), next() };
+
+    uint64_t count = next();
+    group.operations.reserve(count);
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (end - data < static_cast<ptrdiff_t>(OPERATION_HEADER_INTS * sizeof(uint64_t))) return false;
+
+        auto type = static_cast<Type>(next());
+        Position start = { next(), next() };
+        Position stop = { next(), next() };
+        uint64_t length = next();
+        if (static_cast<uint64_t>(end - data) < length) return false;
+
+        group.operations.emplace_back(
+            type, start, stop, std::string_view(reinterpret_cast<const char*>(data), length)
+        );
+        group.memory_usage += sizeof(Operation) + length;
+        data += length;
+    }
+    return true;
+}
\ No newline at end of file
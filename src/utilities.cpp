@@ -1,9 +1,14 @@
 #include <filesystem>
 #include <algorithm>
 #include <string>
+#include <cstring>
 #include <chrono>
 #include <ctime>
 
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
 #include <fontconfig/fontconfig.h>
 
 #include "../inc/logging_utility.hpp"
@@ -126,6 +131,113 @@ namespace Utils {
     }
 
 
+    auto
+    Hash_Bytes(std::string_view bytes, uint64_t seed) -> uint64_t
+    {
+        const uint64_t PRIME = 0x100000001b3;
+        uint64_t hash = seed;
+        size_t i = 0;
+
+        for (; i + sizeof(uint64_t) <= bytes.length(); i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes.data() + i, sizeof(uint64_t));
+            hash = (hash ^ word) * PRIME;
+            hash ^= hash >> 32;
+        }
+
+        for (; i < bytes.length(); i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * PRIME;
+        }
+        return hash;
+    }
+
+
+    auto
+    Find_All_Bytes(std::string_view text, char byte) -> std::vector<size_t>
+    {
+        std::vector<size_t> offsets;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const size_t BLOCK_SIZE = sizeof(__m128i);
+        const __m128i needle = _mm_set1_epi8(byte);
+
+        for (; i + BLOCK_SIZE <= text.length(); i += BLOCK_SIZE) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+
+            while (mask != 0) {
+                offsets.push_back(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        /* memchr is vectorised by the C library as well, used for the tail or without SSE2 */
+        while (i < text.length()) {
+            const void *found = std::memchr(text.data() + i, byte, text.length() - i);
+            if (found == nullptr) break;
+
+            size_t offset = static_cast<const char*>(found) - text.data();
+            offsets.push_back(offset);
+            i = offset + 1;
+        }
+        return offsets;
+    }
+
+
+    void
+    Find_Substrings(std::string_view text, std::string_view pattern, std::vector<size_t> *offsets)
+    {
+        if (pattern.empty() || pattern.length() > text.length()) return;
+
+        const size_t last = pattern.length() - 1;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const size_t BLOCK_SIZE = sizeof(__m128i);
+        const __m128i first_needle = _mm_set1_epi8(pattern.front());
+        const __m128i last_needle = _mm_set1_epi8(pattern.back());
+
+        for (; i + last + BLOCK_SIZE <= text.length(); i += BLOCK_SIZE) {
+            __m128i first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+            __m128i last_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + last));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(first_block, first_needle),
+                _mm_cmpeq_epi8(last_block, last_needle)
+            )));
+
+            while (mask != 0) {
+                size_t offset = i + __builtin_ctz(mask);
+                if (std::memcmp(text.data() + offset, pattern.data(), pattern.length()) == 0) {
+                    offsets->push_back(offset);
+                }
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        for (; i + last < text.length(); i++) {
+            if (text[i] != pattern.front() || text[i + last] != pattern.back()) continue;
+            if (std::memcmp(text.data() + i, pattern.data(), pattern.length()) == 0) offsets->push_back(i);
+        }
+    }
+
+
+    auto
+    Hash_Content(const std::vector<std::string> &content) -> uint64_t
+    {
+        uint64_t hash = CONTENT_HASH_BASIS;
+        for (const auto &line : content) hash = Hash_Line(line, hash);
+        return hash;
+    }
+
+
+    auto
+    Hash_Line(std::string_view line, uint64_t hash) -> uint64_t
+    { return Hash_Bytes("\n", Hash_Bytes(line, hash)); }
+
+
     auto
     Path_To_String(const std::filesystem::path &path) -> std::string
     {
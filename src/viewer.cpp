@@ -0,0 +1,417 @@
+#include <algorithm>
+
+#if __unix__
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#endif
+
+#include "../inc/logging_utility.hpp"
+#include "../inc/file_handler.hpp"
+#include "../inc/cursor.hpp"
+#include "../inc/editor.hpp"
+
+#include "../inc/viewer.hpp"
+
+using View::Viewer;
+
+
+namespace {
+    /// Bytes searched at once for a line break
+    const int64_t SEARCH_BYTES = 1024 * 1024;
+
+
+    /// A read-only map of MAP_BYTES of a file at a time, moved along as other parts of it are asked for
+    class
+    Window_Map
+    {
+    public:
+        Window_Map(int32_t fd, int64_t size, bool is_sequential = false) :
+            m_fd(fd),
+            m_size(size),
+            m_is_sequential(is_sequential) {}
+
+        ~Window_Map()
+        { Unmap(); }
+
+        Window_Map(const Window_Map&) = delete;
+        auto operator=(const Window_Map&) -> Window_Map& = delete;
+
+        /// The bytes from offset on, length of them or fewer at the end of the file, mapped if they were not yet
+        /// @returns an empty view past the end of the file, or if it could not be mapped
+        auto Get(int64_t offset, int64_t length) -> std::string_view
+        {
+            length = std::min(length, m_size - offset);
+            if (length <= 0) return {};
+
+#if __unix__
+            if (m_map == nullptr || offset < m_offset || offset + length > m_offset + m_length) {
+                Unmap();
+
+                /* A map has to start on a page */
+                static const int64_t page_size = sysconf(_SC_PAGESIZE);
+                int64_t start = offset - (offset % page_size);
+                int64_t map_length = std::min(std::max(View::MAP_BYTES, offset + length - start), m_size - start);
+
+                void *map = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, m_fd, start);
+                if (map == MAP_FAILED) return {};
+                if (m_is_sequential) madvise(map, map_length, MADV_SEQUENTIAL);
+
+                m_map = map;
+                m_offset = start;
+                m_length = map_length;
+            }
+            return { static_cast<const char*>(m_map) + (offset - m_offset), static_cast<size_t>(length) };
+#else
+            return {};
+#endif
+        }
+
+        /// @returns the offset of the first line break from offset on, or the size of the file if there is none
+        auto Find_Break(int64_t offset) -> int64_t
+        {
+            while (offset < m_size) {
+                std::string_view bytes = Get(offset, SEARCH_BYTES);
+                if (bytes.empty()) break;
+
+                size_t line_break = bytes.find('\n');
+                if (line_break != std::string_view::npos) return offset + static_cast<int64_t>(line_break);
+                offset += static_cast<int64_t>(bytes.length());
+            }
+            return m_size;
+        }
+
+        /// @returns the offset of the last line break before offset, or -1 if there is none
+        auto Find_Break_Before(int64_t offset) -> int64_t
+        {
+            while (offset > 0) {
+                int64_t start = std::max(offset - SEARCH_BYTES, 0L);
+                std::string_view bytes = Get(start, offset - start);
+                if (bytes.empty()) break;
+
+                size_t line_break = bytes.rfind('\n');
+                if (line_break != std::string_view::npos) return start + static_cast<int64_t>(line_break);
+                offset = start;
+            }
+            return -1;
+        }
+
+    private:
+        int32_t m_fd;
+        int64_t m_size;
+        bool m_is_sequential;
+
+        void *m_map = nullptr;
+        int64_t m_offset = 0;
+        int64_t m_length = 0;
+
+        void Unmap()
+        {
+#if __unix__
+            if (m_map != nullptr) munmap(m_map, m_length);
+#endif
+            m_map = nullptr;
+        }
+    };
+} /* Anonymous namespace */
+
+
+Viewer::~Viewer()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_running = false;
+    }
+    if (m_thread.joinable()) m_thread.join();
+
+#if __unix__
+    if (m_fd >= 0) close(m_fd);
+#endif
+}
+
+
+auto
+Viewer::Open(Editor::Data *editor_data, int32_t tab_size) -> bool
+{
+    m_file_path = editor_data->file_path;
+    m_tab_size = tab_size;
+
+#if __unix__
+    m_fd = open(m_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status = {};
+    if (m_fd < 0 || fstat(m_fd, &status) != 0) {
+        Log::Err("Failed to open file: {}", m_file_path.string());
+        return false;
+    }
+    m_size = status.st_size;
+
+    Window_Map map(m_fd, m_size);
+    std::string_view last_byte = map.Get(m_size - 1, 1);
+    m_ends_with_break = (!last_byte.empty() && last_byte.front() == '\n');
+
+    m_checkpoints.assign(1, 0);
+    m_is_running = true;
+    m_thread = std::thread(&Viewer::Scan_Loop, this);
+
+    Load_Window(editor_data, 0, 0);
+    return true;
+#else
+    Log::Err("The viewer is not supported on this platform");
+    return false;
+#endif
+}
+
+
+void
+Viewer::Jump_To_Line(Editor::Data *editor_data, int64_t line)
+{
+    line = std::max(line, 0L);
+    {
+        /* Line n starts after the n-th line break */
+        std::lock_guard lock(m_mutex);
+        if (!m_is_scanned && m_scanned_lines < line) {
+            m_pending_line = line;
+            Log::Info("Counting the lines up to {}, the viewer jumps there once they are\n", line + 1);
+            return;
+        }
+    }
+
+    m_pending_line = -1;
+    Move_To(editor_data, Find_Line(line));
+}
+
+
+void
+Viewer::Jump_To_Byte(Editor::Data *editor_data, int64_t offset)
+{
+    m_pending_line = -1;
+    Move_To(editor_data, Find_Line_Start(std::clamp(offset, 0L, std::max(m_size - 1, 0L))));
+}
+
+
+void
+Viewer::Jump_To_Percent(Editor::Data *editor_data, double percent)
+{
+    percent = std::clamp(percent, 0.0, 100.0);
+    Jump_To_Byte(editor_data, static_cast<int64_t>(static_cast<double>(m_size) * percent / 100));
+}
+
+
+auto
+Viewer::Collect(Editor::Data *editor_data) -> bool
+{
+    if (m_pending_line >= 0) {
+        bool is_counted = false;
+        {
+            std::lock_guard lock(m_mutex);
+            is_counted = (m_is_scanned || m_scanned_lines >= m_pending_line);
+        }
+        if (is_counted) {
+            Jump_To_Line(editor_data, m_pending_line);
+            return true;
+        }
+    }
+
+    bool is_changed = false;
+    if (m_first_line < 0) {
+        m_first_line = Find_Line_Number(m_window_start);
+        is_changed = (m_first_line >= 0);
+    }
+
+    int64_t cursor = editor_data->cursor.y;
+    auto count = static_cast<int64_t>(m_line_starts.size());
+    bool is_near_start = (cursor < MARGIN_LINES && m_window_start > 0);
+    bool is_near_end = (count - cursor <= MARGIN_LINES && m_window_end < m_size);
+    if (!is_near_start && !is_near_end) return is_changed;
+
+    /* The window is moved only when that brings in new lines, the cursor keeps its place on the screen */
+    int64_t line_start = m_line_starts.at(cursor);
+    int64_t start = Find_Earlier_Line(line_start, WINDOW_LINES / 2);
+    if (start == m_window_start && !(cursor == count - 1 && m_window_end < m_size)) return is_changed;
+
+    Load_Window(editor_data, start, line_start);
+    int64_t shift = (std::ranges::lower_bound(m_line_starts, line_start) - m_line_starts.begin()) - cursor;
+
+    editor_data->cursor.y += shift;
+    editor_data->scroll.y = std::max(editor_data->scroll.y + shift, 0L);
+    editor_data->last_rendered_line = std::max(static_cast<int64_t>(editor_data->last_rendered_line) + shift, 0L);
+    editor_data->visual_start.y = std::clamp(editor_data->visual_start.y + shift, 0L, static_cast<int64_t>(m_line_starts.size()) - 1);
+    return true;
+}
+
+
+auto
+Viewer::Get_Counted_Lines() -> int64_t
+{
+    std::lock_guard lock(m_mutex);
+    return m_scanned_lines + (m_is_scanned && m_size > 0 && !m_ends_with_break ? 1 : 0);
+}
+
+
+void
+Viewer::Scan_Loop()
+{
+    /* Read once front to back, the kernel reads ahead and may drop the pages already passed */
+    Window_Map map(m_fd, m_size, true);
+    std::vector<int64_t> checkpoints;
+    int64_t offset = 0;
+    int64_t lines = 0;
+
+    while (offset < m_size) {
+        std::string_view bytes = map.Get(offset, MAP_BYTES);
+        if (bytes.empty()) {
+            Log::Err("Failed to read file: {}", m_file_path.string());
+            break;
+        }
+
+        for (size_t line_break = bytes.find('\n'); line_break != std::string_view::npos; line_break = bytes.find('\n', line_break + 1)) {
+            lines++;
+            if (lines % CHECKPOINT_LINES == 0) checkpoints.push_back(offset + static_cast<int64_t>(line_break) + 1);
+        }
+        offset += static_cast<int64_t>(bytes.length());
+
+        std::lock_guard lock(m_mutex);
+        if (!m_is_running) return;
+
+        m_checkpoints.insert(m_checkpoints.end(), checkpoints.begin(), checkpoints.end());
+        checkpoints.clear();
+        m_scanned_bytes = offset;
+        m_scanned_lines = lines;
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_is_scanned = true;
+}
+
+
+void
+Viewer::Load_Window(Editor::Data *editor_data, int64_t start, int64_t keep)
+{
+    Window_Map map(m_fd, m_size);
+    std::vector<int64_t> line_starts;
+    std::string text;
+
+    /* Each line is read up to MAX_LINE_BYTES, the rest of a longer one is only searched for its line break */
+    int64_t offset = start;
+    while (offset < m_size) {
+        bool is_full = (static_cast<int64_t>(line_starts.size()) >= WINDOW_LINES || offset - start >= WINDOW_BYTES);
+        if (is_full && line_starts.size() >= 2 && line_starts.at(line_starts.size() - 2) >= keep) break;
+
+        int64_t line_break = map.Find_Break(offset);
+        line_starts.push_back(offset);
+        text += map.Get(offset, std::min(line_break - offset, MAX_LINE_BYTES));
+        text += '\n';
+        offset = line_break + 1;
+    }
+
+    std::vector<std::string> lines = File::Parse_Text(text, m_tab_size);
+    if (lines.empty()) {
+        lines.assign(1, "");
+        line_starts.assign(1, start);
+    }
+
+    m_window_start = start;
+    m_window_end = std::min(offset, m_size);
+    m_line_starts = std::move(line_starts);
+
+    /* Not an edit, the window stands for the file, so it is neither recorded nor sent to the registers */
+    {
+        std::unique_lock lock(editor_data->content_mutex);
+        auto old_size = static_cast<int64_t>(editor_data->file_content.size());
+        auto new_size = static_cast<int64_t>(lines.size());
+
+        editor_data->version++;
+        editor_data->file_content = std::move(lines);
+        editor_data->syntax.After_Edit(0, new_size - 1, new_size - old_size);
+    }
+
+    editor_data->extra_cursors.clear();
+    m_first_line = Find_Line_Number(start);
+}
+
+
+void
+Viewer::Move_To(Editor::Data *editor_data, int64_t line_start)
+{
+    Load_Window(editor_data, Find_Earlier_Line(line_start, WINDOW_LINES / 2), line_start);
+
+    /* The line jumped to is shown at the top of the screen */
+    int64_t visible_lines = static_cast<int64_t>(editor_data->last_rendered_line) - editor_data->scroll.y;
+    editor_data->cursor = { 0, std::ranges::lower_bound(m_line_starts, line_start) - m_line_starts.begin() };
+    editor_data->cursor_max_x = 0;
+    editor_data->scroll.y = editor_data->cursor.y;
+    editor_data->last_rendered_line = editor_data->scroll.y + std::max(visible_lines, 0L);
+    Cursor::Logic::Scroll_To_Cursor(editor_data);
+}
+
+
+auto
+Viewer::Find_Earlier_Line(int64_t line_start, int64_t count) -> int64_t
+{
+    Window_Map map(m_fd, m_size);
+    int64_t start = line_start;
+
+    for (int64_t i = 0; i < count && start > 0; i++) {
+        if (i > 0 && line_start - start >= WINDOW_BYTES / 2) break;
+
+        /* The byte before a line start is the line break of the line before it */
+        start = map.Find_Break_Before(start - 1) + 1;
+    }
+    return start;
+}
+
+
+auto
+Viewer::Find_Line_Start(int64_t offset) -> int64_t
+{
+    Window_Map map(m_fd, m_size);
+    return map.Find_Break_Before(offset) + 1;
+}
+
+
+auto
+Viewer::Find_Line(int64_t line) -> int64_t
+{
+    int64_t offset = 0;
+    int64_t checkpoint_line = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        auto index = std::min(line / CHECKPOINT_LINES, static_cast<int64_t>(m_checkpoints.size()) - 1);
+        offset = m_checkpoints.at(index);
+        checkpoint_line = index * CHECKPOINT_LINES;
+    }
+
+    Window_Map map(m_fd, m_size);
+    for (int64_t i = checkpoint_line; i < line && offset < m_size; i++) offset = map.Find_Break(offset) + 1;
+
+    /* Past the end of the file, or on the empty line after its last line break, the last line is taken */
+    if (offset >= m_size) return Find_Line_Start(std::max(m_size - 1, 0L));
+    return offset;
+}
+
+
+auto
+Viewer::Find_Line_Number(int64_t line_start) -> int64_t
+{
+    int64_t offset = 0;
+    int64_t line = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_is_scanned && line_start > m_scanned_bytes) return -1;
+
+        auto checkpoint = std::ranges::upper_bound(m_checkpoints, line_start) - 1;
+        offset = *checkpoint;
+        line = (checkpoint - m_checkpoints.begin()) * CHECKPOINT_LINES;
+    }
+
+    Window_Map map(m_fd, m_size);
+    while (offset < line_start) {
+        std::string_view bytes = map.Get(offset, std::min(line_start - offset, SEARCH_BYTES));
+        if (bytes.empty()) return -1;
+
+        line += std::ranges::count(bytes, '\n');
+        offset += static_cast<int64_t>(bytes.length());
+    }
+    return line;
+}
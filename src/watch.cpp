@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <utility>
+#include <array>
+
+#if __linux__
+#   include <sys/inotify.h>
+#   include <sys/eventfd.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <cerrno>
+#endif
+
+#include "../inc/logging_utility.hpp"
+#include "../inc/file_handler.hpp"
+#include "../inc/buffer.hpp"
+#include "../inc/editor.hpp"
+
+#include "../inc/watch.hpp"
+
+using Watch::Watcher;
+
+
+namespace {
+    const uint64_t CHECKSUM_SEED = 0xcbf29ce484222325;
+    const uint64_t CHECKSUM_PRIME = 0x100000001b3;
+
+
+    /// Hashes bytes one at a time, so the checksum of a file can be carried on over what is appended to it
+    auto
+    Hash_Stream(uint64_t hash, std::string_view bytes) -> uint64_t
+    {
+        for (char byte : bytes) hash = (hash ^ static_cast<uint8_t>(byte)) * CHECKSUM_PRIME;
+        return hash;
+    }
+
+
+#if __linux__
+    /// Reads up to length bytes of fd from offset, fewer if the file ends first
+    /// @returns false if reading failed
+    auto
+    Read_Range(int32_t fd, int64_t offset, int64_t length, std::string *bytes) -> bool
+    {
+        bytes->resize(static_cast<size_t>(std::max(length, 0L)));
+
+        size_t done = 0;
+        while (done < bytes->length()) {
+            ssize_t result = pread(fd, bytes->data() + done, bytes->length() - done, offset + static_cast<off_t>(done));
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0) return false;
+            if (result == 0) break;
+            done += static_cast<size_t>(result);
+        }
+
+        bytes->resize(done);
+        return true;
+    }
+
+
+    auto
+    Get_Modified_Ns(const struct stat &status) -> int64_t
+    { return (static_cast<int64_t>(status.st_mtim.tv_sec) * 1'000'000'000) + status.st_mtim.tv_nsec; }
+#endif
+} /* Anonymous namespace */
+
+
+Watcher::~Watcher()
+{
+    Stop();
+
+#if __linux__
+    if (m_inotify_fd >= 0) close(m_inotify_fd);
+    if (m_wake_fd >= 0) close(m_wake_fd);
+    if (m_owns_stream_fd) close(m_stream_fd);
+#endif
+}
+
+
+auto
+Watcher::Start(const std::filesystem::path &file_path, int32_t tab_size, uint64_t version) -> bool
+{
+    m_file_path = file_path;
+    m_tab_size = tab_size;
+    m_synced_version = version;
+
+#if __linux__
+    /* The directory is watched rather than the file, editors that save by renaming a copy replace its inode */
+    std::filesystem::path directory = (file_path.has_parent_path() ? file_path.parent_path() : ".");
+    uint32_t mask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_MOVED_TO | IN_DELETE;
+
+    m_inotify_fd = inotify_init1(IN_CLOEXEC);
+    m_wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (m_inotify_fd < 0 || m_wake_fd < 0 || inotify_add_watch(m_inotify_fd, directory.c_str(), mask) < 0) {
+        Log::Err("Failed to watch file: {}", file_path.string());
+        return false;
+    }
+
+    m_needs_snapshot = true;
+    m_is_running = true;
+    m_thread = std::thread(&Watcher::Watch_Loop, this);
+    return true;
+#else
+    Log::Err("File watching is not supported on this platform");
+    return false;
+#endif
+}
+
+
+auto
+Watcher::Start_Stream(int32_t fd, int32_t tab_size) -> bool
+{
+    m_stream_fd = fd;
+    m_tab_size = tab_size;
+
+#if __linux__
+    m_wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (m_wake_fd < 0) {
+        Log::Err("Failed to start reading the input stream");
+        return false;
+    }
+
+    m_is_running = true;
+    m_thread = std::thread(&Watcher::Stream_Loop, this);
+    return true;
+#else
+    Log::Err("Reading a stream is not supported on this platform");
+    return false;
+#endif
+}
+
+
+auto
+Watcher::Start_Decoding(const std::filesystem::path &file_path, int32_t tab_size) -> bool
+{
+    m_file_path = file_path;
+
+#if __linux__
+    int32_t fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Log::Err("Failed to open file: {}", file_path.string());
+        return false;
+    }
+    m_owns_stream_fd = true;
+    return Start_Stream(fd, tab_size);
+#else
+    Log::Err("Reading a stream is not supported on this platform");
+    return false;
+#endif
+}
+
+
+auto
+Watcher::Is_Loading() -> bool
+{
+    if (m_stream_fd < 0) return false;
+
+    std::lock_guard lock(m_mutex);
+    return !m_is_stream_done || m_has_appended;
+}
+
+
+void
+Watcher::Pause()
+{
+    std::lock_guard lock(m_mutex);
+    m_pauses++;
+}
+
+
+void
+Watcher::Resume(uint64_t version)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_pauses = std::max(m_pauses - 1, 0);
+        if (m_pauses > 0) return;
+    }
+    Resync(version);
+}
+
+
+void
+Watcher::Resync(uint64_t version)
+{
+    /* A new generation would drop what the stream read meanwhile */
+    if (m_stream_fd >= 0) return;
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        /* Whatever was found before is outdated, the file is read again as the new reference */
+        m_generation++;
+        m_needs_snapshot = true;
+        m_appended.clear();
+        m_has_appended = false;
+        m_is_changed = false;
+    }
+
+    m_synced_version = version;
+    m_is_synced = true;
+    m_is_reported = false;
+    Wake();
+}
+
+
+auto
+Watcher::Collect(Editor::Data *editor_data) -> bool
+{
+    std::string appended;
+    bool has_appended = false;
+    bool continues_line = false;
+    bool is_changed = false;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_has_appended && !m_is_changed) return false;
+
+        appended.swap(m_appended);
+        has_appended = std::exchange(m_has_appended, false);
+        continues_line = m_continues_line;
+        is_changed = std::exchange(m_is_changed, false);
+
+        /* A large batch is cut after a line break, the rest starts a line of its own on the next frame */
+        size_t line_break = (appended.length() > BATCH_BYTES ? appended.rfind('\n', BATCH_BYTES) : std::string::npos);
+        if (line_break != std::string::npos) {
+            m_appended.assign(appended, line_break + 1);
+            m_has_appended = true;
+            m_continues_line = false;
+            appended.resize(line_break + 1);
+        }
+    }
+    m_drained.notify_one();
+
+    /* Appends only line up with the buffer while it holds exactly what was on disk, a stream has no such copy */
+    if (m_stream_fd < 0 && (is_changed || editor_data->version != m_synced_version)) m_is_synced = false;
+    if (!m_is_synced) {
+        if (!m_is_reported) Log::Info("{} changed on disk, :e! reloads it\n", m_file_path.string());
+        m_is_reported = true;
+        return false;
+    }
+    if (!has_appended) return false;
+
+    std::vector<std::string> lines = File::Parse_Text(appended, m_tab_size);
+    size_t length = lines.size();
+    for (const auto &line : lines) length += line.length();
+
+    std::string text;
+    text.reserve(length);
+    if (!continues_line) text += '\n';
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (i != 0) text += '\n';
+        text += lines.at(i);
+    }
+
+    /* An unfinished last line is parsed again together with its continuation, the new text replaces it */
+    auto last_line = static_cast<int64_t>(editor_data->file_content.size()) - 1;
+    auto line_end = static_cast<int64_t>(editor_data->file_content.back().length());
+    if (continues_line) {
+        if (line_end > 0) Buffer::Apply_Erase(editor_data, { 0, last_line }, { line_end, last_line });
+        line_end = 0;
+    }
+    if (!text.empty()) Buffer::Apply_Insert(editor_data, { line_end, last_line }, text);
+    m_synced_version = editor_data->version;
+
+    if (m_is_following) {
+        editor_data->cursor = { 0, static_cast<int64_t>(editor_data->file_content.size()) - 1 };
+        editor_data->cursor_max_x = 0;
+        Cursor::Logic::Scroll_To_Cursor(editor_data);
+    }
+    return true;
+}
+
+
+void
+Watcher::Watch_Loop()
+{
+#if __linux__
+    std::string file_name = m_file_path.filename().string();
+    alignas(inotify_event) std::array<char, 4096> events{};
+
+    for (;;) {
+        bool needs_snapshot = false;
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_is_running) return;
+            needs_snapshot = std::exchange(m_needs_snapshot, false);
+        }
+
+        if (needs_snapshot) {
+            m_snapshot = {};
+            int32_t fd = open(m_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                Read_Snapshot(fd, &m_snapshot);
+                close(fd);
+            }
+        }
+
+        std::array<pollfd, 2> fds = {{ { m_inotify_fd, POLLIN, 0 }, { m_wake_fd, POLLIN, 0 } }};
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            Log::Err("Failed to wait for changes of file: {}", m_file_path.string());
+            return;
+        }
+
+        /* A wake only asks for the loop to run again, for a stop or a new snapshot */
+        if ((fds.at(1).revents & POLLIN) != 0) {
+            uint64_t count = 0;
+            if (read(m_wake_fd, &count, sizeof(count)) < 0) continue;
+        }
+        if ((fds.at(0).revents & POLLIN) == 0) continue;
+
+        ssize_t length = read(m_inotify_fd, events.data(), events.size());
+        bool is_touched = false;
+        for (ssize_t offset = 0; offset < length;) {
+            const auto *event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+            if (event->len > 0 && file_name == event->name) is_touched = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+        if (!is_touched) continue;
+
+        uint64_t generation = 0;
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_pauses > 0 || m_needs_snapshot) continue;
+            generation = m_generation;
+        }
+        if (Check_Append(generation)) continue;
+
+        /* A file rewritten in place is empty or half written for a moment, it is compared once left alone */
+        Wait_For_Quiet();
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_is_running || m_pauses > 0 || m_needs_snapshot) continue;
+            generation = m_generation;
+        }
+        Check_Whole(generation);
+    }
+#endif
+}
+
+
+void
+Watcher::Stream_Loop()
+{
+#if __linux__
+    auto get_generation = [this] {
+        std::lock_guard lock(m_mutex);
+        return m_generation;
+    };
+
+    std::string block;
+    std::string decoded;
+    for (;;) {
+        {
+            /* A producer faster than the frames is held back by the pipe filling up */
+            std::unique_lock lock(m_mutex);
+            m_drained.wait(lock, [this]{ return !m_is_running || m_appended.length() < MAX_PENDING_BYTES; });
+            if (!m_is_running) return;
+        }
+
+        std::array<pollfd, 2> fds = {{ { m_stream_fd, POLLIN, 0 }, { m_wake_fd, POLLIN, 0 } }};
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            Log::Err("Failed to wait for the input stream");
+            break;
+        }
+        if ((fds.at(1).revents & POLLIN) != 0) {
+            uint64_t count = 0;
+            if (read(m_wake_fd, &count, sizeof(count)) < 0) continue;
+        }
+        if (fds.at(0).revents == 0) continue;
+
+        block.resize(READ_BYTES);
+        ssize_t length = read(m_stream_fd, block.data(), block.length());
+        if (length < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (length < 0) Log::Err("Failed to read the input stream");
+        if (length <= 0) break;
+
+        /* Compressed input is detected from its first bytes and decompressed on this thread */
+        block.resize(static_cast<size_t>(length));
+        decoded.clear();
+        bool is_decoded = m_decoder.Decode(block, &decoded);
+        if (!decoded.empty()) Publish_Append(decoded, get_generation());
+        if (!is_decoded) break;
+    }
+
+    /* A stream shorter than a magic number was held back by the decoder */
+    decoded.clear();
+    m_decoder.Finish(&decoded);
+    if (!decoded.empty()) Publish_Append(decoded, get_generation());
+
+    std::lock_guard lock(m_mutex);
+    m_is_stream_done = true;
+#endif
+}
+
+
+void
+Watcher::Wait_For_Quiet()
+{
+#if __linux__
+    std::array<char, 4096> events{};
+    for (;;) {
+        std::array<pollfd, 2> fds = {{ { m_inotify_fd, POLLIN, 0 }, { m_wake_fd, POLLIN, 0 } }};
+        if (poll(fds.data(), fds.size(), SETTLE_MS) <= 0) return;
+
+        /* The wake is left for the loop, which stops or takes a new snapshot */
+        if ((fds.at(1).revents & POLLIN) != 0) return;
+        if (read(m_inotify_fd, events.data(), events.size()) < 0) return;
+    }
+#endif
+}
+
+
+auto
+Watcher::Read_Snapshot(int32_t fd, Snapshot *snapshot) -> bool
+{
+#if __linux__
+    struct stat status = {};
+    if (fstat(fd, &status) != 0) return false;
+
+    snapshot->device = status.st_dev;
+    snapshot->inode = status.st_ino;
+    snapshot->modified_ns = Get_Modified_Ns(status);
+    snapshot->checksum = CHECKSUM_SEED;
+
+    int64_t size = 0;
+    int64_t last_break = -1;
+    std::string block;
+    for (;;) {
+        if (!Read_Range(fd, size, READ_BYTES, &block)) return false;
+        if (block.empty()) break;
+
+        snapshot->checksum = Hash_Stream(snapshot->checksum, block);
+        size_t line_break = block.rfind('\n');
+        if (line_break != std::string::npos) last_break = size + static_cast<int64_t>(line_break);
+        size += static_cast<int64_t>(block.length());
+    }
+    snapshot->size = size;
+
+    int64_t tail_start = std::max(size - static_cast<int64_t>(TAIL_BYTES), 0L);
+    return (
+        Read_Range(fd, tail_start, size - tail_start, &snapshot->tail) &&
+        Read_Range(fd, last_break + 1, size - last_break - 1, &snapshot->partial)
+    );
+#else
+    return false;
+#endif
+}
+
+
+auto
+Watcher::Check_Append(uint64_t generation) -> bool
+{
+#if __linux__
+    /* A file being replaced may be missing for a moment, the new one brings its own event */
+    int32_t fd = open(m_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return true;
+
+    struct stat status = {};
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return true;
+    }
+
+    Snapshot &known = m_snapshot;
+    bool is_same_file = (status.st_dev == known.device && status.st_ino == known.inode);
+    if (is_same_file && status.st_size == known.size && Get_Modified_Ns(status) == known.modified_ns) {
+        close(fd);
+        return true;
+    }
+
+    /* Growth is an append if the old tail is still in place, then only the tail and the new bytes are read */
+    auto tail_length = static_cast<int64_t>(known.tail.length());
+    std::string bytes;
+    if (
+        is_same_file && status.st_size > known.size &&
+        Read_Range(fd, known.size - tail_length, status.st_size - known.size + tail_length, &bytes) &&
+        static_cast<int64_t>(bytes.length()) > tail_length &&
+        bytes.compare(0, known.tail.length(), known.tail) == 0
+    ) {
+        close(fd);
+        std::string_view added = std::string_view(bytes).substr(known.tail.length());
+        Publish_Append(added, generation);
+
+        known.checksum = Hash_Stream(known.checksum, added);
+        known.modified_ns = Get_Modified_Ns(status);
+        known.tail = bytes.substr(bytes.length() - std::min(bytes.length(), TAIL_BYTES));
+        return true;
+    }
+
+    close(fd);
+    return false;
+#else
+    return true;
+#endif
+}
+
+
+void
+Watcher::Publish_Append(std::string_view added, uint64_t generation)
+{
+    Snapshot &known = m_snapshot;
+    {
+        std::lock_guard lock(m_mutex);
+        if (generation == m_generation) {
+            /* The unfinished last line is sent again, so it is parsed together with its continuation */
+            if (!m_has_appended) {
+                m_continues_line = (known.size == 0 || !known.partial.empty());
+                m_appended = known.partial;
+            }
+            m_appended.append(added);
+            m_has_appended = true;
+        }
+    }
+
+    size_t line_break = added.rfind('\n');
+    if (line_break == std::string_view::npos) known.partial.append(added);
+    else known.partial = added.substr(line_break + 1);
+    known.size += static_cast<int64_t>(added.length());
+}
+
+
+void
+Watcher::Check_Whole(uint64_t generation)
+{
+#if __linux__
+    int32_t fd = open(m_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    /* A rewrite with the same content, or a touch, is not a change */
+    Snapshot &known = m_snapshot;
+    Snapshot current;
+    bool is_read = Read_Snapshot(fd, &current);
+    close(fd);
+    if (!is_read) return;
+
+    bool is_changed = (current.size != known.size || current.checksum != known.checksum);
+    known = std::move(current);
+    if (!is_changed) return;
+
+    std::lock_guard lock(m_mutex);
+    if (generation == m_generation) m_is_changed = true;
+#endif
+}
+
+
+void
+Watcher::Wake()
+{
+#if __linux__
+    uint64_t count = 1;
+    if (m_wake_fd >= 0 && write(m_wake_fd, &count, sizeof(count)) < 0) {
+        Log::Err("Failed to wake the watcher of file: {}", m_file_path.string());
+    }
+#endif
+}
+
+
+void
+Watcher::Stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_is_running) return;
+        m_is_running = false;
+    }
+
+    Wake();
+    m_drained.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}